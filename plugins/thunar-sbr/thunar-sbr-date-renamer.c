@@ -44,6 +44,19 @@
 
 
 
+#ifdef HAVE_EXIF
+/* number of threads parsing exif data in the background */
+#define THUNAR_SBR_EXIF_MAX_THREADS 4
+
+/* delay in ms before the renamers are updated once all files are parsed */
+#define THUNAR_SBR_EXIF_UPDATE_INTERVAL 500
+
+typedef struct _ThunarSbrExifEntry ThunarSbrExifEntry;
+typedef struct _ThunarSbrExifTask  ThunarSbrExifTask;
+#endif
+
+
+
 /* Property identifiers */
 enum
 {
@@ -56,26 +69,31 @@ enum
 
 
 
-static void    thunar_sbr_date_renamer_finalize     (GObject                   *object);
-static void    thunar_sbr_date_renamer_get_property (GObject                   *object,
-                                                     guint                      prop_id,
-                                                     GValue                    *value,
-                                                     GParamSpec                *pspec);
-static void    thunar_sbr_date_renamer_set_property (GObject                   *object,
-                                                     guint                      prop_id,
-                                                     const GValue              *value,
-                                                     GParamSpec                *pspec);
-static gchar  *thunar_sbr_get_time_string           (guint64                    file_time,
-                                                     const gchar               *custom_format);
+static void     thunar_sbr_date_renamer_finalize     (GObject                   *object);
+static void     thunar_sbr_date_renamer_get_property (GObject                   *object,
+                                                      guint                      prop_id,
+                                                      GValue                    *value,
+                                                      GParamSpec                *pspec);
+static void     thunar_sbr_date_renamer_set_property (GObject                   *object,
+                                                      guint                      prop_id,
+                                                      const GValue              *value,
+                                                      GParamSpec                *pspec);
+static gchar   *thunar_sbr_get_time_string           (guint64                    file_time,
+                                                      const gchar               *custom_format);
 #ifdef HAVE_EXIF
-static guint64 thunar_sbr_get_time_from_string      (const gchar               *string);
+static guint64  thunar_sbr_get_time_from_string      (const gchar               *string);
+static guint64  thunar_sbr_get_time_from_exif        (const gchar               *filename);
+static guint64  thunar_sbr_get_time_taken            (ThunarxFileInfo           *file);
+static void     thunar_sbr_exif_worker               (gpointer                   data,
+                                                      gpointer                   user_data);
+static gboolean thunar_sbr_exif_update_timeout       (gpointer                   user_data);
 #endif
-static guint64 thunar_sbr_get_time                  (ThunarxFileInfo           *file,
-                                                     ThunarSbrDateMode          mode);
-static gchar  *thunar_sbr_date_renamer_process      (ThunarxRenamer            *renamer,
-                                                     ThunarxFileInfo           *file,
-                                                     const gchar               *text,
-                                                     guint                      idx);
+static guint64  thunar_sbr_get_time                  (ThunarxFileInfo           *file,
+                                                      ThunarSbrDateMode          mode);
+static gchar   *thunar_sbr_date_renamer_process      (ThunarxRenamer            *renamer,
+                                                      ThunarxFileInfo           *file,
+                                                      const gchar               *text,
+                                                      guint                      idx);
 
 
 
@@ -95,6 +113,38 @@ struct _ThunarSbrDateRenamer
 
 
 
+#ifdef HAVE_EXIF
+struct _ThunarSbrExifEntry
+{
+  guint64  mtime;
+  guint64  time_taken;
+  gboolean pending;
+};
+
+struct _ThunarSbrExifTask
+{
+  gchar   *uri;
+  guint64  mtime;
+};
+
+
+
+/* Parsing the exif data of large images is slow, so it is done on
+ * a thread pool and the results are kept per uri, shared by all date
+ * renamers. The renamers return the unchanged text for files that
+ * are still being parsed, so they stay busy until all queued files
+ * are parsed and are updated then.
+ */
+static GHashTable  *exif_cache = NULL;
+static GThreadPool *exif_pool = NULL;
+static GSList      *exif_renamers = NULL;
+static guint        exif_n_pending = 0;
+static guint        exif_update_timer_id = 0;
+G_LOCK_DEFINE_STATIC (exif_cache);
+#endif
+
+
+
 THUNARX_DEFINE_TYPE (ThunarSbrDateRenamer, thunar_sbr_date_renamer, THUNARX_TYPE_RENAMER);
 
 
@@ -184,6 +234,13 @@ thunar_sbr_date_renamer_init (ThunarSbrDateRenamer *date_renamer)
   GtkAdjustment  *adjustment;
   guint           n;
 
+#ifdef HAVE_EXIF
+  /* receive updates for files parsed in the background */
+  G_LOCK (exif_cache);
+  exif_renamers = g_slist_prepend (exif_renamers, date_renamer);
+  G_UNLOCK (exif_cache);
+#endif
+
   grid = gtk_grid_new ();
   gtk_grid_set_row_spacing (GTK_GRID (grid), 6);
   gtk_grid_set_column_spacing (GTK_GRID (grid), 12);
@@ -274,6 +331,19 @@ thunar_sbr_date_renamer_finalize (GObject *object)
 {
   ThunarSbrDateRenamer *date_renamer = THUNAR_SBR_DATE_RENAMER (object);
 
+#ifdef HAVE_EXIF
+  G_LOCK (exif_cache);
+  exif_renamers = g_slist_remove (exif_renamers, date_renamer);
+
+  /* forget the cached data when the last renamer is gone */
+  if (exif_renamers == NULL && exif_cache != NULL)
+    {
+      g_hash_table_destroy (exif_cache);
+      exif_cache = NULL;
+    }
+  G_UNLOCK (exif_cache);
+#endif
+
   /* release the format */
   g_free (date_renamer->format);
 
@@ -423,6 +493,176 @@ thunar_sbr_get_time_from_string (const gchar *string)
   /* return the local time */
   return mktime (&tm);
 }
+
+
+
+static guint64
+thunar_sbr_get_time_from_exif (const gchar *filename)
+{
+  ExifEntry *exif_entry;
+  ExifData  *exif_data;
+  guint64    file_time = 0;
+  gchar      exif_buffer[128];
+
+  /* try to load the exif data for the file */
+  exif_data = exif_data_new_from_file (filename);
+  if (G_LIKELY (exif_data != NULL))
+    {
+      /* lookup the entry for the tag, fallback on less common ones */
+      exif_entry = exif_data_get_entry (exif_data, EXIF_TAG_DATE_TIME);
+
+      if (exif_entry == NULL)
+        exif_entry = exif_data_get_entry (exif_data, EXIF_TAG_DATE_TIME_ORIGINAL);
+
+      if (exif_entry == NULL)
+        exif_entry = exif_data_get_entry (exif_data, EXIF_TAG_DATE_TIME_DIGITIZED);
+
+      if (G_LIKELY (exif_entry != NULL))
+        {
+          /* determine the value */
+          if (exif_entry_get_value (exif_entry, exif_buffer, sizeof (exif_buffer)) != NULL)
+            file_time = thunar_sbr_get_time_from_string (exif_buffer);
+        }
+
+      /* cleanup */
+      exif_data_free (exif_data);
+    }
+
+  return file_time;
+}
+
+
+
+static guint64
+thunar_sbr_get_time_taken (ThunarxFileInfo *file)
+{
+  ThunarSbrExifEntry *entry;
+  ThunarSbrExifTask  *task;
+  GFileInfo          *file_info;
+  guint64             file_time = 0;
+  guint64             mtime;
+  gchar              *uri;
+
+  /* get the uri */
+  uri = thunarx_file_info_get_uri (file);
+  if (G_UNLIKELY (uri == NULL))
+    return 0;
+
+  /* cached entries are only valid for the same modification time */
+  file_info = thunarx_file_info_get_file_info (file);
+  mtime = g_file_info_get_attribute_uint64 (file_info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+  g_object_unref (file_info);
+
+  G_LOCK (exif_cache);
+
+  if (G_UNLIKELY (exif_cache == NULL))
+    exif_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+
+  entry = g_hash_table_lookup (exif_cache, uri);
+  if (entry != NULL && entry->mtime == mtime)
+    {
+      /* use the cached time, if the file was parsed already */
+      if (!entry->pending)
+        file_time = entry->time_taken;
+    }
+  else
+    {
+      /* allocate the pool on demand */
+      if (G_UNLIKELY (exif_pool == NULL))
+        exif_pool = g_thread_pool_new (thunar_sbr_exif_worker, NULL, THUNAR_SBR_EXIF_MAX_THREADS, FALSE, NULL);
+
+      entry = g_new0 (ThunarSbrExifEntry, 1);
+      entry->mtime = mtime;
+      entry->pending = TRUE;
+      g_hash_table_replace (exif_cache, g_strdup (uri), entry);
+
+      /* queue the file for parsing */
+      exif_n_pending += 1;
+      task = g_new (ThunarSbrExifTask, 1);
+      task->uri = g_strdup (uri);
+      task->mtime = mtime;
+      g_thread_pool_push (exif_pool, task, NULL);
+    }
+
+  G_UNLOCK (exif_cache);
+
+  g_free (uri);
+
+  return file_time;
+}
+
+
+
+static void
+thunar_sbr_exif_worker (gpointer data,
+                        gpointer user_data)
+{
+  ThunarSbrExifEntry *entry;
+  ThunarSbrExifTask  *task = data;
+  guint64             file_time = 0;
+  gchar              *filename;
+
+  /* determine the local path of the file */
+  filename = g_filename_from_uri (task->uri, NULL, NULL);
+  if (G_LIKELY (filename != NULL))
+    {
+      file_time = thunar_sbr_get_time_from_exif (filename);
+      g_free (filename);
+    }
+
+  G_LOCK (exif_cache);
+
+  /* store the result, unless the entry was dropped or replaced meanwhile */
+  entry = (exif_cache != NULL) ? g_hash_table_lookup (exif_cache, task->uri) : NULL;
+  if (entry != NULL && entry->pending && entry->mtime == task->mtime)
+    {
+      entry->time_taken = file_time;
+      entry->pending = FALSE;
+    }
+
+  /* update the renamers once the last queued file is parsed */
+  exif_n_pending -= 1;
+  if (exif_n_pending == 0 && exif_update_timer_id == 0)
+    exif_update_timer_id = g_timeout_add (THUNAR_SBR_EXIF_UPDATE_INTERVAL, thunar_sbr_exif_update_timeout, NULL);
+
+  G_UNLOCK (exif_cache);
+
+  g_free (task->uri);
+  g_free (task);
+}
+
+
+
+static gboolean
+thunar_sbr_exif_update_timeout (gpointer user_data)
+{
+  GSList *renamers = NULL;
+  GSList *lp;
+
+  G_LOCK (exif_cache);
+
+  exif_update_timer_id = 0;
+
+  /* collect the renamers, unless new files were queued meanwhile */
+  if (exif_n_pending == 0)
+    for (lp = exif_renamers; lp != NULL; lp = lp->next)
+      renamers = g_slist_prepend (renamers, g_object_ref (lp->data));
+
+  G_UNLOCK (exif_cache);
+
+  /* update the previews with the final results */
+  for (lp = renamers; lp != NULL; lp = lp->next)
+    {
+      thunarx_renamer_set_busy (THUNARX_RENAMER (lp->data), FALSE);
+      if (THUNAR_SBR_DATE_RENAMER (lp->data)->mode == THUNAR_SBR_DATE_MODE_TAKEN)
+        thunarx_renamer_changed (THUNARX_RENAMER (lp->data));
+      g_object_unref (lp->data);
+    }
+
+  g_slist_free (renamers);
+
+  return FALSE;
+}
 #endif
 
 
@@ -434,12 +674,6 @@ thunar_sbr_get_time (ThunarxFileInfo   *file,
 
   GFileInfo *file_info;
   guint64    file_time = 0;
-#ifdef HAVE_EXIF
-  gchar     *uri, *filename;
-  ExifEntry *exif_entry;
-  ExifData  *exif_data;
-  gchar     exif_buffer[128];
-#endif
 
   switch (mode)
     {
@@ -471,46 +705,8 @@ thunar_sbr_get_time (ThunarxFileInfo   *file,
 
 #ifdef HAVE_EXIF
     case THUNAR_SBR_DATE_MODE_TAKEN:
-      /* get the uri */
-      uri = thunarx_file_info_get_uri (file);
-      if (G_LIKELY (uri != NULL))
-        {
-          /* determine the local path of the file */
-          filename = g_filename_from_uri (uri, NULL, NULL);
-          if (G_LIKELY (filename != NULL))
-            {
-              /* try to load the exif data for the file */
-              exif_data = exif_data_new_from_file (filename);
-              if (G_LIKELY (exif_data != NULL))
-                {
-                  /* lookup the entry for the tag, fallback on less common ones */
-                  exif_entry = exif_data_get_entry (exif_data, EXIF_TAG_DATE_TIME);
-
-                  if (exif_entry == NULL)
-                    exif_entry = exif_data_get_entry (exif_data, EXIF_TAG_DATE_TIME_ORIGINAL);
-
-                  if (exif_entry == NULL)
-                    exif_entry = exif_data_get_entry (exif_data, EXIF_TAG_DATE_TIME_DIGITIZED);
-
-                  if (G_LIKELY (exif_entry != NULL))
-                    {
-                      /* determine the value */
-                      if (exif_entry_get_value (exif_entry, exif_buffer, sizeof (exif_buffer)) != NULL)
-                        file_time = thunar_sbr_get_time_from_string (exif_buffer);
-                    }
-
-                  /* cleanup */
-                  exif_data_free (exif_data);
-                }
-
-              /* cleanup */
-              g_free (filename);
-            }
-
-          /* cleanup */
-          g_free (uri);
-        }
-
+      /* lookup the time in the cache, queuing the file if unknown */
+      file_time = thunar_sbr_get_time_taken (file);
       break;
 #endif
     }
@@ -533,6 +729,9 @@ thunar_sbr_date_renamer_process (ThunarxRenamer  *renamer,
   GString              *result;
   guint                 text_length;
   guint                 offset;
+#ifdef HAVE_EXIF
+  guint                 n_pending;
+#endif
 
   /* return when there is no text in the custom format entry */
   if (G_UNLIKELY (date_renamer->format == NULL || *date_renamer->format == '\0'))
@@ -548,6 +747,21 @@ thunar_sbr_date_renamer_process (ThunarxRenamer  *renamer,
 
   /* get the file time */
   file_time = thunar_sbr_get_time (file, date_renamer->mode);
+
+#ifdef HAVE_EXIF
+  /* the names are not final while files are being parsed */
+  if (date_renamer->mode == THUNAR_SBR_DATE_MODE_TAKEN)
+    {
+      G_LOCK (exif_cache);
+      n_pending = exif_n_pending;
+      G_UNLOCK (exif_cache);
+
+      /* notify outside the lock, the handlers may call back into us */
+      if (n_pending > 0)
+        thunarx_renamer_set_busy (renamer, TRUE);
+    }
+#endif
+
   if (file_time == 0)
     return g_strdup (text);
 
@@ -631,6 +845,12 @@ thunar_sbr_date_renamer_set_mode (ThunarSbrDateRenamer *date_renamer,
       /* apply the new mode */
       date_renamer->mode = mode;
 
+#ifdef HAVE_EXIF
+      /* only the exif mode waits for files being parsed */
+      if (mode != THUNAR_SBR_DATE_MODE_TAKEN)
+        thunarx_renamer_set_busy (THUNARX_RENAMER (date_renamer), FALSE);
+#endif
+
       /* update the renamer */
       thunarx_renamer_changed (THUNARX_RENAMER (date_renamer));
 
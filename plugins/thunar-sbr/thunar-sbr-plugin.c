@@ -60,6 +60,12 @@ thunar_extension_initialize (ThunarxProviderPlugin *plugin)
   g_message ("Initializing ThunarSbr extension");
 #endif
 
+#ifdef HAVE_EXIF
+  /* the date renamer parses exif data on a thread pool, which
+   * must not run code from an unloaded module */
+  thunarx_provider_plugin_set_resident (plugin, TRUE);
+#endif
+
   /* register the enum types for this plugin */
   thunar_sbr_register_enum_types (plugin);
 
@@ -48,6 +48,9 @@ static void         thunar_abstract_icon_view_unselect_all          (ThunarStand
 static void         thunar_abstract_icon_view_selection_invert      (ThunarStandardView           *standard_view);
 static void         thunar_abstract_icon_view_select_path           (ThunarStandardView           *standard_view,
                                                                      GtkTreePath                  *path);
+static void         thunar_abstract_icon_view_select_range          (ThunarStandardView           *standard_view,
+                                                                     GtkTreePath                  *start_path,
+                                                                     GtkTreePath                  *end_path);
 static void         thunar_abstract_icon_view_set_cursor            (ThunarStandardView           *standard_view,
                                                                      GtkTreePath                  *path,
                                                                      gboolean                      start_editing);
@@ -157,6 +160,7 @@ thunar_abstract_icon_view_class_init (ThunarAbstractIconViewClass *klass)
   thunarstandard_view_class->unselect_all = thunar_abstract_icon_view_unselect_all;
   thunarstandard_view_class->selection_invert = thunar_abstract_icon_view_selection_invert;
   thunarstandard_view_class->select_path = thunar_abstract_icon_view_select_path;
+  thunarstandard_view_class->select_range = thunar_abstract_icon_view_select_range;
   thunarstandard_view_class->set_cursor = thunar_abstract_icon_view_set_cursor;
   thunarstandard_view_class->scroll_to_path = thunar_abstract_icon_view_scroll_to_path;
   thunarstandard_view_class->get_path_at_pos = thunar_abstract_icon_view_get_path_at_pos;
@@ -351,6 +355,31 @@ thunar_abstract_icon_view_select_path (ThunarStandardView *standard_view,
 
 
 
+static void
+thunar_abstract_icon_view_select_range (ThunarStandardView *standard_view,
+                                        GtkTreePath        *start_path,
+                                        GtkTreePath        *end_path)
+{
+  GtkTreePath *path;
+  ExoIconView *view;
+  gint         end;
+
+  _thunar_return_if_fail (THUNAR_IS_ABSTRACT_ICON_VIEW (standard_view));
+
+  /* ExoIconView has no range selection, so select the items one by one */
+  view = EXO_ICON_VIEW (gtk_bin_get_child (GTK_BIN (standard_view)));
+  end = gtk_tree_path_get_indices (end_path)[0];
+  for (path = gtk_tree_path_copy (start_path);
+       gtk_tree_path_get_indices (path)[0] <= end;
+       gtk_tree_path_next (path))
+    {
+      exo_icon_view_select_path (view, path);
+    }
+  gtk_tree_path_free (path);
+}
+
+
+
 static void
 thunar_abstract_icon_view_set_cursor (ThunarStandardView *standard_view,
                                       GtkTreePath        *path,
@@ -48,6 +48,7 @@
 #include <thunar/thunar-application.h>
 #include <thunar/thunar-browser.h>
 #include <thunar/thunar-create-dialog.h>
+#include <thunar/thunar-deep-count-cache.h>
 #include <thunar/thunar-dialogs.h>
 #include <thunar/thunar-gdk-extensions.h>
 #include <thunar/thunar-gobject-extensions.h>
@@ -408,6 +409,9 @@ thunar_application_shutdown (GApplication *gapp)
   if (application->accel_map != NULL)
     g_object_unref (G_OBJECT (application->accel_map));
 
+  /* write the directories counted since the last save */
+  thunar_deep_count_cache_save ();
+
 #ifdef HAVE_GUDEV
   /* cancel any pending volman watch source */
   if (G_UNLIKELY (application->volman_watch_id != 0))
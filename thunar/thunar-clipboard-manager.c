@@ -82,6 +82,7 @@ static void thunar_clipboard_manager_get_callback       (GtkClipboard
                                                          gpointer                     user_data);
 static void thunar_clipboard_manager_clear_callback     (GtkClipboard                *clipboard,
                                                          gpointer                     user_data);
+static void thunar_clipboard_manager_release_files      (ThunarClipboardManager      *manager);
 static void thunar_clipboard_manager_transfer_files     (ThunarClipboardManager      *manager,
                                                          gboolean                     copy,
                                                          GList                       *files);
@@ -105,6 +106,14 @@ struct _ThunarClipboardManager
 
   gboolean      files_cutted;
   GList        *files;
+
+  /* ThunarFile -> link in files, for fast lookups while drawing */
+  GHashTable   *files_table;
+
+  /* the files that were cut before the last change, and a
+   * counter that is bumped whenever the files change */
+  GHashTable   *previous_cut_files;
+  guint         generation;
 };
 
 typedef struct
@@ -179,6 +188,7 @@ static void
 thunar_clipboard_manager_init (ThunarClipboardManager *manager)
 {
   manager->x_special_gnome_copied_files = gdk_atom_intern_static_string ("x-special/gnome-copied-files");
+  manager->files_table = g_hash_table_new (g_direct_hash, g_direct_equal);
 }
 
 
@@ -208,15 +218,12 @@ static void
 thunar_clipboard_manager_finalize (GObject *object)
 {
   ThunarClipboardManager *manager = THUNAR_CLIPBOARD_MANAGER (object);
-  GList                  *lp;
 
   /* release any pending files */
-  for (lp = manager->files; lp != NULL; lp = lp->next)
-    {
-      g_signal_handlers_disconnect_by_func (G_OBJECT (lp->data), thunar_clipboard_manager_file_destroyed, manager);
-      g_object_unref (G_OBJECT (lp->data));
-    }
-  g_list_free (manager->files);
+  thunar_clipboard_manager_release_files (manager);
+  g_hash_table_destroy (manager->files_table);
+  if (manager->previous_cut_files != NULL)
+    g_hash_table_destroy (manager->previous_cut_files);
 
   /* disconnect from the clipboard */
   g_signal_handlers_disconnect_by_func (G_OBJECT (manager->clipboard), thunar_clipboard_manager_owner_changed, manager);
@@ -254,11 +261,18 @@ static void
 thunar_clipboard_manager_file_destroyed (ThunarFile             *file,
                                          ThunarClipboardManager *manager)
 {
+  GList *lp;
+
   _thunar_return_if_fail (THUNAR_IS_CLIPBOARD_MANAGER (manager));
-  _thunar_return_if_fail (g_list_find (manager->files, file) != NULL);
+
+  lp = g_hash_table_lookup (manager->files_table, file);
+
+  _thunar_return_if_fail (lp != NULL);
 
   /* remove the file from our list */
-  manager->files = g_list_remove (manager->files, file);
+  g_hash_table_remove (manager->files_table, file);
+  manager->files = g_list_delete_link (manager->files, lp);
+  manager->generation++;
 
   /* disconnect from the file */
   g_signal_handlers_disconnect_by_func (G_OBJECT (file), thunar_clipboard_manager_file_destroyed, manager);
@@ -497,13 +511,22 @@ thunar_clipboard_manager_clear_callback (GtkClipboard *clipboard,
                                          gpointer      user_data)
 {
   ThunarClipboardManager *manager = THUNAR_CLIPBOARD_MANAGER (user_data);
-  GList                  *lp;
 
   _thunar_return_if_fail (GTK_IS_CLIPBOARD (clipboard));
   _thunar_return_if_fail (THUNAR_IS_CLIPBOARD_MANAGER (manager));
   _thunar_return_if_fail (manager->clipboard == clipboard);
 
   /* release the pending files */
+  thunar_clipboard_manager_release_files (manager);
+}
+
+
+
+static void
+thunar_clipboard_manager_release_files (ThunarClipboardManager *manager)
+{
+  GList *lp;
+
   for (lp = manager->files; lp != NULL; lp = lp->next)
     {
       g_signal_handlers_disconnect_by_func (G_OBJECT (lp->data), thunar_clipboard_manager_file_destroyed, manager);
@@ -511,6 +534,25 @@ thunar_clipboard_manager_clear_callback (GtkClipboard *clipboard,
     }
   g_list_free (manager->files);
   manager->files = NULL;
+
+  /* remember which files were cut, so views can redraw only the
+   * rows whose state changed. the table is only used to compare
+   * pointers, so it does not hold references on the files */
+  if (manager->previous_cut_files != NULL)
+    g_hash_table_destroy (manager->previous_cut_files);
+
+  if (manager->files_cutted && g_hash_table_size (manager->files_table) > 0)
+    {
+      manager->previous_cut_files = manager->files_table;
+      manager->files_table = g_hash_table_new (g_direct_hash, g_direct_equal);
+    }
+  else
+    {
+      manager->previous_cut_files = NULL;
+      g_hash_table_remove_all (manager->files_table);
+    }
+
+  manager->generation++;
 }
 
 
@@ -524,21 +566,21 @@ thunar_clipboard_manager_transfer_files (ThunarClipboardManager *manager,
   GList      *lp;
 
   /* release any pending files */
-  for (lp = manager->files; lp != NULL; lp = lp->next)
-    {
-      g_signal_handlers_disconnect_by_func (G_OBJECT (lp->data), thunar_clipboard_manager_file_destroyed, manager);
-      g_object_unref (G_OBJECT (lp->data));
-    }
-  g_list_free (manager->files);
+  thunar_clipboard_manager_release_files (manager);
 
   /* remember the transfer operation */
   manager->files_cutted = !copy;
 
   /* setup the new file list */
-  for (lp = g_list_last (files), manager->files = NULL; lp != NULL; lp = lp->prev)
+  for (lp = g_list_last (files); lp != NULL; lp = lp->prev)
     {
+      /* skip duplicates, the table maps each file to one link */
+      if (g_hash_table_lookup (manager->files_table, lp->data) != NULL)
+        continue;
+
       file = THUNAR_FILE (g_object_ref (G_OBJECT (lp->data)));
       manager->files = g_list_prepend (manager->files, file);
+      g_hash_table_insert (manager->files_table, file, manager->files);
       g_signal_connect (G_OBJECT (file), "destroy", G_CALLBACK (thunar_clipboard_manager_file_destroyed), manager);
     }
 
@@ -644,7 +686,50 @@ thunar_clipboard_manager_has_cutted_file (ThunarClipboardManager *manager,
   _thunar_return_val_if_fail (THUNAR_IS_CLIPBOARD_MANAGER (manager), FALSE);
   _thunar_return_val_if_fail (THUNAR_IS_FILE (file), FALSE);
 
-  return (manager->files_cutted && g_list_find (manager->files, file) != NULL);
+  return (manager->files_cutted && g_hash_table_lookup (manager->files_table, file) != NULL);
+}
+
+
+
+/**
+ * thunar_clipboard_manager_had_cutted_file:
+ * @manager : a #ThunarClipboardManager.
+ * @file    : a #ThunarFile.
+ *
+ * Checks whether @file was on the cutted list of @manager before
+ * the files of @manager were last replaced or cleared. Together with
+ * thunar_clipboard_manager_has_cutted_file() this tells views which
+ * rows need to be redrawn.
+ *
+ * Return value: %TRUE if @file was on the previous cutted list of @manager.
+ **/
+gboolean
+thunar_clipboard_manager_had_cutted_file (ThunarClipboardManager *manager,
+                                          const ThunarFile       *file)
+{
+  _thunar_return_val_if_fail (THUNAR_IS_CLIPBOARD_MANAGER (manager), FALSE);
+  _thunar_return_val_if_fail (THUNAR_IS_FILE (file), FALSE);
+
+  return (manager->previous_cut_files != NULL
+          && g_hash_table_lookup (manager->previous_cut_files, file) != NULL);
+}
+
+
+
+/**
+ * thunar_clipboard_manager_get_generation:
+ * @manager : a #ThunarClipboardManager.
+ *
+ * Returns a counter that is incremented whenever the files on
+ * the clipboard represented by @manager change.
+ *
+ * Return value: the generation of the clipboard files.
+ **/
+guint
+thunar_clipboard_manager_get_generation (ThunarClipboardManager *manager)
+{
+  _thunar_return_val_if_fail (THUNAR_IS_CLIPBOARD_MANAGER (manager), 0);
+  return manager->generation;
 }
 
 
@@ -43,6 +43,9 @@ gboolean                thunar_clipboard_manager_get_can_paste   (ThunarClipboar
 
 gboolean                thunar_clipboard_manager_has_cutted_file (ThunarClipboardManager *manager,
                                                                   const ThunarFile       *file);
+gboolean                thunar_clipboard_manager_had_cutted_file (ThunarClipboardManager *manager,
+                                                                  const ThunarFile       *file);
+guint                   thunar_clipboard_manager_get_generation  (ThunarClipboardManager *manager);
 
 void                    thunar_clipboard_manager_copy_files      (ThunarClipboardManager *manager,
                                                                   GList                  *files);
@@ -0,0 +1,431 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 Xfce Development Team <xfce4-dev@xfce.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <libxfce4util/libxfce4util.h>
+
+#include <thunar/thunar-deep-count-cache.h>
+#include <thunar/thunar-private.h>
+
+
+
+/* location and format of the cache file in $XDG_CACHE_HOME */
+#define DEEP_COUNT_CACHE_FILE    "Thunar/deep-count-cache"
+#define DEEP_COUNT_CACHE_VERSION "thunar-deep-count-cache-1"
+
+/* maximum number of directories in the cache, the least recently used are dropped */
+#define DEEP_COUNT_CACHE_MAX_ENTRIES 20000
+
+/* seconds to wait before writing a changed cache, so a burst of counts is saved once */
+#define DEEP_COUNT_CACHE_SAVE_DELAY 10
+
+
+
+typedef struct _ThunarDeepCountCacheEntry ThunarDeepCountCacheEntry;
+
+
+
+static void     thunar_deep_count_cache_entry_free   (gpointer data);
+static gboolean thunar_deep_count_cache_save_timeout (gpointer user_data);
+
+
+
+/* The cache stores the direct contents of a directory: the number and
+ * size of the non-directory children and the names of the subdirectories.
+ * An entry is only valid as long as the modification time and inode of
+ * the directory match, so the subdirectories still have to be checked
+ * one by one, but unchanged directories are not enumerated again.
+ */
+struct _ThunarDeepCountCacheEntry
+{
+  gchar   *path;
+  GList    lru_link;
+  guint64  mtime;
+  guint64  inode;
+  guint64  total_size;
+  guint    file_count;
+  gchar  **subdirectories;
+};
+
+
+
+/* path -> ThunarDeepCountCacheEntry, loaded on first use, and
+ * the entries with the most recently used one at the head */
+static GHashTable *deep_count_cache = NULL;
+static GQueue      deep_count_cache_lru = G_QUEUE_INIT;
+static gboolean    deep_count_cache_dirty = FALSE;
+static guint       deep_count_cache_save_id = 0;
+G_LOCK_DEFINE_STATIC (deep_count_cache);
+
+
+
+static void
+thunar_deep_count_cache_entry_free (gpointer data)
+{
+  ThunarDeepCountCacheEntry *entry = data;
+
+  g_free (entry->path);
+  g_strfreev (entry->subdirectories);
+  g_slice_free (ThunarDeepCountCacheEntry, entry);
+}
+
+
+
+static void
+thunar_deep_count_cache_add (ThunarDeepCountCacheEntry *entry)
+{
+  ThunarDeepCountCacheEntry *old_entry;
+
+  /* drop the previous entry of the directory */
+  old_entry = g_hash_table_lookup (deep_count_cache, entry->path);
+  if (old_entry != NULL)
+    {
+      g_queue_unlink (&deep_count_cache_lru, &old_entry->lru_link);
+      g_hash_table_remove (deep_count_cache, old_entry->path);
+    }
+
+  entry->lru_link.data = entry;
+  g_queue_push_head_link (&deep_count_cache_lru, &entry->lru_link);
+  g_hash_table_insert (deep_count_cache, entry->path, entry);
+
+  /* keep the cache bounded, dropping the least recently used directories */
+  while (deep_count_cache_lru.length > DEEP_COUNT_CACHE_MAX_ENTRIES)
+    {
+      old_entry = deep_count_cache_lru.tail->data;
+      g_queue_unlink (&deep_count_cache_lru, &old_entry->lru_link);
+      g_hash_table_remove (deep_count_cache, old_entry->path);
+    }
+}
+
+
+
+static const gchar *
+thunar_deep_count_cache_read_field (const gchar **p,
+                                    const gchar  *end)
+{
+  const gchar *field = *p;
+  const gchar *nul;
+
+  /* every field is terminated by a nul byte */
+  if (field >= end)
+    return NULL;
+
+  nul = memchr (field, '\0', end - field);
+  if (G_UNLIKELY (nul == NULL))
+    return NULL;
+
+  *p = nul + 1;
+  return field;
+}
+
+
+
+static void
+thunar_deep_count_cache_load (void)
+{
+  ThunarDeepCountCacheEntry *entry;
+  const gchar               *p;
+  const gchar               *end;
+  const gchar               *path;
+  const gchar               *field[5];
+  gchar                     *filename;
+  gchar                     *contents = NULL;
+  gsize                      length;
+  guint64                    n;
+  guint                      i;
+  guint                      k;
+
+  deep_count_cache = g_hash_table_new_full (g_str_hash, g_str_equal, NULL,
+                                            thunar_deep_count_cache_entry_free);
+
+  /* check if we have a cache file */
+  filename = xfce_resource_lookup (XFCE_RESOURCE_CACHE, DEEP_COUNT_CACHE_FILE);
+  if (filename == NULL)
+    return;
+
+  if (!g_file_get_contents (filename, &contents, &length, NULL))
+    {
+      g_free (filename);
+      return;
+    }
+
+  g_free (filename);
+
+  p = contents;
+  end = contents + length;
+
+  /* ignore caches written in another format */
+  path = thunar_deep_count_cache_read_field (&p, end);
+  if (path == NULL || strcmp (path, DEEP_COUNT_CACHE_VERSION) != 0)
+    {
+      g_free (contents);
+      return;
+    }
+
+  /* path, mtime, inode, file count, total size, subdirectory count, subdirectories,
+   * with the least recently used directory first */
+  for (;;)
+    {
+      path = thunar_deep_count_cache_read_field (&p, end);
+      if (path == NULL)
+        break;
+
+      for (i = 0; i < G_N_ELEMENTS (field); ++i)
+        if ((field[i] = thunar_deep_count_cache_read_field (&p, end)) == NULL)
+          break;
+
+      /* stop on a truncated file */
+      if (G_UNLIKELY (i < G_N_ELEMENTS (field)))
+        break;
+
+      n = g_ascii_strtoull (field[4], NULL, 10);
+
+      entry = g_slice_new0 (ThunarDeepCountCacheEntry);
+      entry->path = g_strdup (path);
+      entry->mtime = g_ascii_strtoull (field[0], NULL, 10);
+      entry->inode = g_ascii_strtoull (field[1], NULL, 10);
+      entry->file_count = g_ascii_strtoull (field[2], NULL, 10);
+      entry->total_size = g_ascii_strtoull (field[3], NULL, 10);
+      entry->subdirectories = g_new0 (gchar *, MIN (n, (guint64) (end - p)) + 1);
+
+      for (k = 0; k < n; ++k)
+        {
+          field[0] = thunar_deep_count_cache_read_field (&p, end);
+          if (G_UNLIKELY (field[0] == NULL))
+            break;
+
+          entry->subdirectories[k] = g_strdup (field[0]);
+        }
+
+      if (G_UNLIKELY (k < n))
+        {
+          thunar_deep_count_cache_entry_free (entry);
+          break;
+        }
+
+      thunar_deep_count_cache_add (entry);
+    }
+
+  g_free (contents);
+}
+
+
+
+/**
+ * thunar_deep_count_cache_lookup:
+ * @path           : the local path of a directory.
+ * @mtime          : the modification time of the directory in microseconds.
+ * @inode          : the inode of the directory.
+ * @file_count     : return location for the number of non-directory children.
+ * @total_size     : return location for the size of the non-directory children.
+ * @subdirectories : return location for the names of the subdirectories.
+ *
+ * Looks up the direct contents of the directory at @path, as they were
+ * when the directory had the given @mtime and @inode.
+ *
+ * The caller is responsible to free @subdirectories using g_strfreev().
+ *
+ * Return value: %TRUE if the cache contains up-to-date information about
+ *               the directory, %FALSE otherwise.
+ **/
+gboolean
+thunar_deep_count_cache_lookup (const gchar   *path,
+                                guint64        mtime,
+                                guint64        inode,
+                                guint         *file_count,
+                                guint64       *total_size,
+                                gchar       ***subdirectories)
+{
+  ThunarDeepCountCacheEntry *entry;
+  gboolean                   found = FALSE;
+
+  _thunar_return_val_if_fail (path != NULL, FALSE);
+
+  G_LOCK (deep_count_cache);
+
+  if (G_UNLIKELY (deep_count_cache == NULL))
+    thunar_deep_count_cache_load ();
+
+  entry = g_hash_table_lookup (deep_count_cache, path);
+  if (entry != NULL && entry->mtime == mtime && entry->inode == inode)
+    {
+      *file_count = entry->file_count;
+      *total_size = entry->total_size;
+      *subdirectories = g_strdupv (entry->subdirectories);
+      found = TRUE;
+
+      /* move the entry to the head of the lru list */
+      g_queue_unlink (&deep_count_cache_lru, &entry->lru_link);
+      g_queue_push_head_link (&deep_count_cache_lru, &entry->lru_link);
+    }
+
+  G_UNLOCK (deep_count_cache);
+
+  return found;
+}
+
+
+
+/**
+ * thunar_deep_count_cache_insert:
+ * @path           : the local path of a directory.
+ * @mtime          : the modification time of the directory in microseconds.
+ * @inode          : the inode of the directory.
+ * @file_count     : the number of non-directory children.
+ * @total_size     : the size of the non-directory children.
+ * @subdirectories : %NULL-terminated names of the subdirectories.
+ *
+ * Remembers the direct contents of the directory at @path. The cache
+ * is written to disk a few seconds later, so the inserts of several
+ * jobs in a row are saved at once.
+ **/
+void
+thunar_deep_count_cache_insert (const gchar  *path,
+                                guint64       mtime,
+                                guint64       inode,
+                                guint         file_count,
+                                guint64       total_size,
+                                gchar       **subdirectories)
+{
+  ThunarDeepCountCacheEntry *entry;
+
+  _thunar_return_if_fail (path != NULL);
+  _thunar_return_if_fail (subdirectories != NULL);
+
+  entry = g_slice_new0 (ThunarDeepCountCacheEntry);
+  entry->path = g_strdup (path);
+  entry->mtime = mtime;
+  entry->inode = inode;
+  entry->file_count = file_count;
+  entry->total_size = total_size;
+  entry->subdirectories = g_strdupv (subdirectories);
+
+  G_LOCK (deep_count_cache);
+
+  if (G_UNLIKELY (deep_count_cache == NULL))
+    thunar_deep_count_cache_load ();
+
+  thunar_deep_count_cache_add (entry);
+  deep_count_cache_dirty = TRUE;
+
+  /* schedule a save, this is called from the job threads, but
+   * the timeout runs in the main loop */
+  if (deep_count_cache_save_id == 0)
+    {
+      deep_count_cache_save_id = g_timeout_add_seconds (DEEP_COUNT_CACHE_SAVE_DELAY,
+                                                        thunar_deep_count_cache_save_timeout,
+                                                        NULL);
+    }
+
+  G_UNLOCK (deep_count_cache);
+}
+
+
+
+/**
+ * thunar_deep_count_cache_save:
+ *
+ * Writes the cache to $XDG_CACHE_HOME if it was changed since
+ * it was loaded or last saved. Saves are scheduled automatically,
+ * this only needs to be called to flush the cache on shutdown.
+ **/
+void
+thunar_deep_count_cache_save (void)
+{
+  ThunarDeepCountCacheEntry *entry;
+  GList                     *lp;
+  GString                   *contents;
+  gchar                     *filename;
+  guint                      n;
+
+  G_LOCK (deep_count_cache);
+
+  /* drop any pending save, we're saving right now */
+  if (deep_count_cache_save_id != 0)
+    {
+      g_source_remove (deep_count_cache_save_id);
+      deep_count_cache_save_id = 0;
+    }
+
+  if (deep_count_cache == NULL || !deep_count_cache_dirty)
+    {
+      G_UNLOCK (deep_count_cache);
+      return;
+    }
+
+  contents = g_string_sized_new (4096);
+  g_string_append_len (contents, DEEP_COUNT_CACHE_VERSION, sizeof (DEEP_COUNT_CACHE_VERSION));
+
+  /* write the least recently used entries first, so loading restores the order */
+  for (lp = deep_count_cache_lru.tail; lp != NULL; lp = lp->prev)
+    {
+      entry = lp->data;
+      g_string_append_len (contents, entry->path, strlen (entry->path) + 1);
+      g_string_append_printf (contents, "%" G_GUINT64_FORMAT, entry->mtime);
+      g_string_append_c (contents, '\0');
+      g_string_append_printf (contents, "%" G_GUINT64_FORMAT, entry->inode);
+      g_string_append_c (contents, '\0');
+      g_string_append_printf (contents, "%u", entry->file_count);
+      g_string_append_c (contents, '\0');
+      g_string_append_printf (contents, "%" G_GUINT64_FORMAT, entry->total_size);
+      g_string_append_c (contents, '\0');
+      g_string_append_printf (contents, "%u", g_strv_length (entry->subdirectories));
+      g_string_append_c (contents, '\0');
+
+      for (n = 0; entry->subdirectories[n] != NULL; ++n)
+        g_string_append_len (contents, entry->subdirectories[n], strlen (entry->subdirectories[n]) + 1);
+    }
+
+  deep_count_cache_dirty = FALSE;
+
+  G_UNLOCK (deep_count_cache);
+
+  /* write the cache file, failures are not fatal */
+  filename = xfce_resource_save_location (XFCE_RESOURCE_CACHE, DEEP_COUNT_CACHE_FILE, TRUE);
+  if (G_LIKELY (filename != NULL))
+    {
+      g_file_set_contents (filename, contents->str, contents->len, NULL);
+      g_free (filename);
+    }
+
+  g_string_free (contents, TRUE);
+}
+
+
+
+static gboolean
+thunar_deep_count_cache_save_timeout (gpointer user_data)
+{
+  /* the source is removed when we return */
+  G_LOCK (deep_count_cache);
+  deep_count_cache_save_id = 0;
+  G_UNLOCK (deep_count_cache);
+
+  thunar_deep_count_cache_save ();
+
+  return FALSE;
+}
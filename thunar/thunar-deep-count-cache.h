@@ -0,0 +1,46 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 Xfce Development Team <xfce4-dev@xfce.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA  02111-1307  USA
+ */
+
+#ifndef __THUNAR_DEEP_COUNT_CACHE_H__
+#define __THUNAR_DEEP_COUNT_CACHE_H__
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+gboolean thunar_deep_count_cache_lookup (const gchar  *path,
+                                         guint64       mtime,
+                                         guint64       inode,
+                                         guint        *file_count,
+                                         guint64      *total_size,
+                                         gchar      ***subdirectories);
+
+void     thunar_deep_count_cache_insert (const gchar  *path,
+                                         guint64       mtime,
+                                         guint64       inode,
+                                         guint         file_count,
+                                         guint64       total_size,
+                                         gchar       **subdirectories);
+
+void     thunar_deep_count_cache_save   (void);
+
+G_END_DECLS
+
+#endif /* !__THUNAR_DEEP_COUNT_CACHE_H__ */
@@ -27,6 +27,7 @@
 #include <glib-object.h>
 #include <gio/gio.h>
 
+#include <thunar/thunar-deep-count-cache.h>
 #include <thunar/thunar-deep-count-job.h>
 #include <thunar/thunar-job.h>
 #include <thunar/thunar-marshal.h>
@@ -44,13 +45,34 @@ enum
 
 
 #define DEEP_COUNT_FILE_INFO_NAMESPACE \
+  G_FILE_ATTRIBUTE_STANDARD_NAME "," \
   G_FILE_ATTRIBUTE_STANDARD_TYPE "," \
   G_FILE_ATTRIBUTE_STANDARD_SIZE "," \
-  G_FILE_ATTRIBUTE_ID_FILESYSTEM
+  G_FILE_ATTRIBUTE_ID_FILESYSTEM "," \
+  G_FILE_ATTRIBUTE_TIME_MODIFIED "," \
+  G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC "," \
+  G_FILE_ATTRIBUTE_UNIX_INODE
+
+/* maximum number of directories read at the same time */
+#define DEEP_COUNT_MAX_THREADS 8
+
+#if GLIB_CHECK_VERSION (2, 32, 0)
+#define _deep_count_job_lock(job)   g_mutex_lock (&((job)->lock))
+#define _deep_count_job_unlock(job) g_mutex_unlock (&((job)->lock))
+#define _deep_count_job_wait(job)   g_cond_wait (&((job)->cond), &((job)->lock))
+#define _deep_count_job_signal(job) g_cond_signal (&((job)->cond))
+#else
+#define _deep_count_job_lock(job)   g_mutex_lock ((job)->lock)
+#define _deep_count_job_unlock(job) g_mutex_unlock ((job)->lock)
+#define _deep_count_job_wait(job)   g_cond_wait ((job)->cond, (job)->lock)
+#define _deep_count_job_signal(job) g_cond_signal ((job)->cond)
+#endif
 
 static void     thunar_deep_count_job_finalize   (GObject                 *object);
 static gboolean thunar_deep_count_job_execute    (ExoJob                  *job,
                                                   GError                 **error);
+static void     thunar_deep_count_job_worker     (gpointer                 data,
+                                                  gpointer                 user_data);
 
 
 
@@ -81,10 +103,34 @@ struct _ThunarDeepCountJob
   guint               file_count;
   guint               directory_count;
   guint               unreadable_directory_count;
+
+  /* filesystem of the toplevel file that is being counted */
+  gchar              *toplevel_fs_id;
+
+  /* subdirectories are read in parallel by the pool */
+  GThreadPool        *pool;
+  guint               n_pending;
+
+  /* protects the status information and n_pending */
+#if GLIB_CHECK_VERSION (2, 32, 0)
+  GMutex              lock;
+  GCond               cond;
+#else
+  GMutex             *lock;
+  GCond              *cond;
+#endif
 };
 
 
 
+typedef struct
+{
+  GFile     *directory;
+  GFileInfo *info;
+} ThunarDeepCountDirectory;
+
+
+
 static guint deep_count_signals[LAST_SIGNAL];
 
 
@@ -136,6 +182,14 @@ static void
 thunar_deep_count_job_init (ThunarDeepCountJob *job)
 {
   job->query_flags = G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS;
+
+#if GLIB_CHECK_VERSION (2, 32, 0)
+  g_mutex_init (&job->lock);
+  g_cond_init (&job->cond);
+#else
+  job->lock = g_mutex_new ();
+  job->cond = g_cond_new ();
+#endif
 }
 
 
@@ -147,183 +201,362 @@ thunar_deep_count_job_finalize (GObject *object)
 
   g_list_free_full (job->files, g_object_unref);
 
+  g_free (job->toplevel_fs_id);
+
+#if GLIB_CHECK_VERSION (2, 32, 0)
+  g_mutex_clear (&job->lock);
+  g_cond_clear (&job->cond);
+#else
+  g_mutex_free (job->lock);
+  g_cond_free (job->cond);
+#endif
+
   (*G_OBJECT_CLASS (thunar_deep_count_job_parent_class)->finalize) (object);
 }
 
 
 
 static void
-thunar_deep_count_job_status_update (ThunarDeepCountJob *job)
+thunar_deep_count_job_status_update (ThunarDeepCountJob *job,
+                                     guint64             total_size,
+                                     guint               file_count,
+                                     guint               directory_count,
+                                     guint               unreadable_directory_count)
 {
   _thunar_return_if_fail (THUNAR_IS_DEEP_COUNT_JOB (job));
 
   exo_job_emit (EXO_JOB (job),
                 deep_count_signals[STATUS_UPDATE],
                 0,
-                job->total_size,
-                job->file_count,
-                job->directory_count,
-                job->unreadable_directory_count);
+                total_size,
+                file_count,
+                directory_count,
+                unreadable_directory_count);
 }
 
 
 
-static gboolean
-thunar_deep_count_job_process (ExoJob       *job,
-                               GFile        *file,
-                               GFileInfo    *file_info,
-                               const gchar  *toplevel_fs_id,
-                               GError      **error)
+static void
+thunar_deep_count_job_push_directory (ThunarDeepCountJob *job,
+                                      GFile              *directory,
+                                      GFileInfo          *info)
 {
-  ThunarDeepCountJob *count_job = THUNAR_DEEP_COUNT_JOB (job);
-  GFileEnumerator    *enumerator;
-  GFileInfo          *child_info;
-  GFileInfo          *info;
-  gboolean            success = TRUE;
-  GFile              *child;
-  gint64              real_time;
-  const gchar        *fs_id;
-  gboolean            toplevel_file = (toplevel_fs_id == NULL);
+  ThunarDeepCountDirectory *data;
 
-  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
-  _thunar_return_val_if_fail (G_IS_FILE (file), FALSE);
-  _thunar_return_val_if_fail (file_info == NULL || G_IS_FILE_INFO (file_info), FALSE);
-  _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+  _thunar_return_if_fail (THUNAR_IS_DEEP_COUNT_JOB (job));
+  _thunar_return_if_fail (G_IS_FILE (directory));
+  _thunar_return_if_fail (G_IS_FILE_INFO (info));
 
-  /* abort if job was already cancelled */
-  if (exo_job_is_cancelled (job))
-    return FALSE;
+  data = g_slice_new0 (ThunarDeepCountDirectory);
+  data->directory = g_object_ref (directory);
+  data->info = g_object_ref (info);
 
-  if (file_info != NULL)
+  if (G_LIKELY (job->pool != NULL))
     {
-      /* use the enumerator info */
-      info = g_object_ref (file_info);
+      /* let the next free thread read the directory */
+      _deep_count_job_lock (job);
+      job->n_pending++;
+      _deep_count_job_unlock (job);
+
+      g_thread_pool_push (job->pool, data, NULL);
     }
   else
     {
-      /* query size and type of the current file */
-      info = g_file_query_info (file,
-                                DEEP_COUNT_FILE_INFO_NAMESPACE,
-                                count_job->query_flags,
-                                exo_job_get_cancellable (job),
-                                error);
+      /* no threads available, recurse in this thread */
+      thunar_deep_count_job_worker (data, job);
     }
+}
 
-  /* abort on invalid info or cancellation */
-  if (info == NULL)
-    return FALSE;
 
-  /* abort on cancellation */
-  if (exo_job_is_cancelled (job))
-    {
-      g_object_unref (info);
-      return FALSE;
-    }
+
+static void
+thunar_deep_count_job_process_child (ThunarDeepCountJob *job,
+                                     GFile              *directory,
+                                     GFileInfo          *child_info,
+                                     guint              *file_count,
+                                     guint64            *total_size)
+{
+  const gchar *fs_id;
+  GFile       *child;
 
   /* only check files on the same filesystem so no remote mounts or
    * dummy filesystems are counted */
-  fs_id = g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_ID_FILESYSTEM);
+  fs_id = g_file_info_get_attribute_string (child_info, G_FILE_ATTRIBUTE_ID_FILESYSTEM);
   if (fs_id == NULL)
     fs_id = "";
 
-  if (toplevel_fs_id == NULL)
+  if (strcmp (fs_id, job->toplevel_fs_id) != 0)
+    return;
+
+  if (g_file_info_get_file_type (child_info) == G_FILE_TYPE_DIRECTORY)
     {
-      /* first toplevel, so use this id */
-      toplevel_fs_id = fs_id;
+      /* hand the subdirectory over to the pool */
+      child = g_file_resolve_relative_path (directory, g_file_info_get_name (child_info));
+      thunar_deep_count_job_push_directory (job, child, child_info);
+      g_object_unref (child);
     }
-  else if (strcmp (fs_id, toplevel_fs_id) != 0)
+  else
     {
-      /* release the file info */
-      g_object_unref (info);
-
-      /* other filesystem, continue */
-      return TRUE;
+      /* we have a regular file or at least not a directory */
+      *file_count += 1;
+      *total_size += g_file_info_get_size (child_info);
     }
+}
 
-  /* recurse if we have a directory */
-  if (g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY)
+
+
+static gboolean
+thunar_deep_count_job_scan_directory (ThunarDeepCountJob  *job,
+                                      GFile               *directory,
+                                      GFileInfo           *info,
+                                      GError             **error)
+{
+  GFileEnumerator *enumerator = NULL;
+  GFileInfo       *child_info;
+  GPtrArray       *subdirectories;
+  GFile           *child;
+  GError          *err = NULL;
+  guint64          total_size = 0;
+  guint            file_count = 0;
+  guint64          mtime;
+  guint64          inode;
+  gboolean         readable;
+  gchar           *path;
+  gchar          **names;
+  guint            n;
+  gint64           real_time;
+  gboolean         notify = FALSE;
+  guint64          status_total_size = 0;
+  guint            status_file_count = 0;
+  guint            status_directory_count = 0;
+  guint            status_unreadable_directory_count = 0;
+
+  _thunar_return_val_if_fail (THUNAR_IS_DEEP_COUNT_JOB (job), FALSE);
+  _thunar_return_val_if_fail (G_IS_FILE (directory), FALSE);
+  _thunar_return_val_if_fail (G_IS_FILE_INFO (info), FALSE);
+  _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  /* the cache is keyed by the local path, mtime and inode of the directory */
+  path = g_file_get_path (directory);
+  inode = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_UNIX_INODE);
+  mtime = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED) * G_USEC_PER_SEC
+          + g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC);
+
+  if (path != NULL && inode != 0
+      && thunar_deep_count_cache_lookup (path, mtime, inode, &file_count, &total_size, &names))
+    {
+      /* the directory is unchanged since it was last read, so
+       * only the subdirectories have to be checked */
+      for (n = 0; names[n] != NULL && !exo_job_is_cancelled (EXO_JOB (job)); ++n)
+        {
+          child = g_file_get_child (directory, names[n]);
+          child_info = g_file_query_info (child,
+                                          DEEP_COUNT_FILE_INFO_NAMESPACE,
+                                          job->query_flags,
+                                          exo_job_get_cancellable (EXO_JOB (job)),
+                                          NULL);
+          if (child_info != NULL)
+            {
+              thunar_deep_count_job_process_child (job, directory, child_info, &file_count, &total_size);
+              g_object_unref (child_info);
+            }
+          g_object_unref (child);
+        }
+
+      g_strfreev (names);
+      readable = TRUE;
+    }
+  else
     {
       /* try to read from the directory */
-      enumerator = g_file_enumerate_children (file,
-                                              DEEP_COUNT_FILE_INFO_NAMESPACE ","
-                                              G_FILE_ATTRIBUTE_STANDARD_NAME,
-                                              count_job->query_flags,
-                                              exo_job_get_cancellable (job),
+      enumerator = g_file_enumerate_children (directory,
+                                              DEEP_COUNT_FILE_INFO_NAMESPACE,
+                                              job->query_flags,
+                                              exo_job_get_cancellable (EXO_JOB (job)),
                                               error);
 
-      if (!exo_job_is_cancelled (job))
+      readable = (enumerator != NULL);
+      if (enumerator != NULL)
         {
-          if (enumerator == NULL)
+          subdirectories = g_ptr_array_new_with_free_func (g_free);
+
+          while (!exo_job_is_cancelled (EXO_JOB (job)))
             {
-              /* directory was unreadable */
-              count_job->unreadable_directory_count++;
-
-              if (toplevel_file
-                  && g_list_length (count_job->files) < 2)
-                {
-                  /* we only bail out if the job file is unreadable */
-                  success = FALSE;
-                }
-              else
-                {
-                  /* ignore errors from files other than the job file */
-                  g_clear_error (error);
-                }
+              /* query next child info */
+              child_info = g_file_enumerator_next_file (enumerator,
+                                                        exo_job_get_cancellable (EXO_JOB (job)),
+                                                        &err);
+
+              /* abort on invalid child info (iteration ends) */
+              if (child_info == NULL)
+                break;
+
+              /* remember the subdirectories for the cache */
+              if (g_file_info_get_file_type (child_info) == G_FILE_TYPE_DIRECTORY)
+                g_ptr_array_add (subdirectories, g_strdup (g_file_info_get_name (child_info)));
+
+              thunar_deep_count_job_process_child (job, directory, child_info, &file_count, &total_size);
+              g_object_unref (child_info);
             }
-          else
+
+          /* only cache directories we've read completely */
+          if (path != NULL && inode != 0 && err == NULL && !exo_job_is_cancelled (EXO_JOB (job)))
             {
-              /* directory was readable */
-              count_job->directory_count++;
-
-              while (!exo_job_is_cancelled (job))
-                {
-                  /* query next child info */
-                  child_info = g_file_enumerator_next_file (enumerator,
-                                                            exo_job_get_cancellable (job),
-                                                            error);
-
-                  /* abort on invalid child info (iteration ends) or cancellation */
-                  if (child_info == NULL)
-                    break;
-
-                  if (!exo_job_is_cancelled (job))
-                    {
-                      /* generate a GFile for the child */
-                      child = g_file_resolve_relative_path (file, g_file_info_get_name (child_info));
-
-                      /* recurse unless the job was cancelled before */
-                      thunar_deep_count_job_process (job, child, child_info, toplevel_fs_id, error);
-
-                      /* free resources */
-                      g_object_unref (child);
-                    }
-
-                  g_object_unref (child_info);
-                }
+              g_ptr_array_add (subdirectories, NULL);
+              thunar_deep_count_cache_insert (path, mtime, inode, file_count, total_size,
+                                              (gchar **) subdirectories->pdata);
             }
+
+          g_clear_error (&err);
+          g_ptr_array_free (subdirectories, TRUE);
+
+          /* destroy the enumerator */
+          g_object_unref (enumerator);
         }
+    }
 
-      /* destroy the enumerator */
-      if (enumerator != NULL)
-        g_object_unref (enumerator);
+  g_free (path);
+
+  _deep_count_job_lock (job);
 
-      /* emit status update whenever we've finished a directory,
-       * but not more than four times per second */
-      real_time = g_get_real_time ();
-      if (real_time >= count_job->last_time)
+  /* add the results of this directory */
+  if (readable)
+    job->directory_count++;
+  else
+    job->unreadable_directory_count++;
+  job->file_count += file_count;
+  job->total_size += total_size;
+
+  /* emit status update whenever we've finished a directory,
+   * but not more than four times per second */
+  real_time = g_get_real_time ();
+  if (real_time >= job->last_time)
+    {
+      if (job->last_time != 0)
         {
-          if (count_job->last_time != 0)
-            thunar_deep_count_job_status_update (count_job);
-          count_job->last_time = real_time + (G_USEC_PER_SEC / 4);
+          notify = TRUE;
+          status_total_size = job->total_size;
+          status_file_count = job->file_count;
+          status_directory_count = job->directory_count;
+          status_unreadable_directory_count = job->unreadable_directory_count;
         }
+      job->last_time = real_time + (G_USEC_PER_SEC / 4);
+    }
+
+  _deep_count_job_unlock (job);
+
+  if (notify)
+    {
+      thunar_deep_count_job_status_update (job, status_total_size, status_file_count,
+                                           status_directory_count,
+                                           status_unreadable_directory_count);
+    }
+
+  return readable;
+}
+
+
+
+static void
+thunar_deep_count_job_worker (gpointer data,
+                              gpointer user_data)
+{
+  ThunarDeepCountDirectory *directory = data;
+  ThunarDeepCountJob       *job = THUNAR_DEEP_COUNT_JOB (user_data);
+
+  /* errors of subdirectories are ignored, they are counted as unreadable */
+  if (!exo_job_is_cancelled (EXO_JOB (job)))
+    thunar_deep_count_job_scan_directory (job, directory->directory, directory->info, NULL);
+
+  g_object_unref (directory->directory);
+  g_object_unref (directory->info);
+  g_slice_free (ThunarDeepCountDirectory, directory);
+
+  /* wake up the job thread once all directories are done */
+  if (G_LIKELY (job->pool != NULL))
+    {
+      _deep_count_job_lock (job);
+      if (--job->n_pending == 0)
+        _deep_count_job_signal (job);
+      _deep_count_job_unlock (job);
+    }
+}
+
+
+
+static gboolean
+thunar_deep_count_job_process (ThunarDeepCountJob  *job,
+                               GFile               *file,
+                               GError             **error)
+{
+  GFileInfo   *info;
+  gboolean     success = TRUE;
+  const gchar *fs_id;
+  GError      *err = NULL;
+
+  _thunar_return_val_if_fail (THUNAR_IS_DEEP_COUNT_JOB (job), FALSE);
+  _thunar_return_val_if_fail (G_IS_FILE (file), FALSE);
+  _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  /* abort if job was already cancelled */
+  if (exo_job_is_cancelled (EXO_JOB (job)))
+    return FALSE;
+
+  /* query size and type of the toplevel file */
+  info = g_file_query_info (file,
+                            DEEP_COUNT_FILE_INFO_NAMESPACE,
+                            job->query_flags,
+                            exo_job_get_cancellable (EXO_JOB (job)),
+                            error);
+
+  /* abort on invalid info or cancellation */
+  if (info == NULL)
+    return FALSE;
+
+  /* abort on cancellation */
+  if (exo_job_is_cancelled (EXO_JOB (job)))
+    {
+      g_object_unref (info);
+      return FALSE;
+    }
+
+  /* only files on the filesystem of the toplevel file are counted */
+  fs_id = g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_ID_FILESYSTEM);
+  g_free (job->toplevel_fs_id);
+  job->toplevel_fs_id = g_strdup (fs_id != NULL ? fs_id : "");
+
+  /* recurse if we have a directory */
+  if (g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY)
+    {
+      /* read the toplevel directory in this thread */
+      if (!thunar_deep_count_job_scan_directory (job, file, info, &err)
+          && !exo_job_is_cancelled (EXO_JOB (job)))
+        {
+          /* we only bail out if the job file is unreadable */
+          if (g_list_length (job->files) < 2)
+            {
+              g_propagate_error (error, err);
+              err = NULL;
+              success = FALSE;
+            }
+        }
+
+      /* ignore errors from files other than the job file */
+      g_clear_error (&err);
+
+      /* wait until the pool has read all subdirectories */
+      _deep_count_job_lock (job);
+      while (job->n_pending > 0)
+        _deep_count_job_wait (job);
+      _deep_count_job_unlock (job);
     }
   else
     {
       /* we have a regular file or at least not a directory */
-      count_job->file_count++;
+      job->file_count++;
 
       /* add size of the file to the total size */
-      count_job->total_size += g_file_info_get_size (info);
+      job->total_size += g_file_info_get_size (info);
     }
 
   /* destroy the file info */
@@ -331,7 +564,7 @@ thunar_deep_count_job_process (ExoJob       *job,
 
   /* we've succeeded if there was no error when loading information
    * about the job file itself and the job was not cancelled */
-  return !exo_job_is_cancelled (job) && success;
+  return !exo_job_is_cancelled (EXO_JOB (job)) && success;
 }
 
 
@@ -359,16 +592,28 @@ thunar_deep_count_job_execute (ExoJob  *job,
   count_job->directory_count = 0;
   count_job->unreadable_directory_count = 0;
   count_job->last_time = 0;
+  count_job->n_pending = 0;
+
+  /* threads to read the subdirectories, we recurse in this thread if that fails */
+  count_job->pool = g_thread_pool_new (thunar_deep_count_job_worker, count_job,
+                                       DEEP_COUNT_MAX_THREADS, FALSE, NULL);
 
   /* count files, directories and compute size of the job files */
   for (lp = count_job->files; lp != NULL; lp = lp->next)
     {
       gfile = thunar_file_get_file (THUNAR_FILE (lp->data));
-      success = thunar_deep_count_job_process (job, gfile, NULL, NULL, &err);
+      success = thunar_deep_count_job_process (count_job, gfile, &err);
       if (G_UNLIKELY (!success))
         break;
     }
 
+  /* all directories are done, release the threads */
+  if (count_job->pool != NULL)
+    {
+      g_thread_pool_free (count_job->pool, TRUE, TRUE);
+      count_job->pool = NULL;
+    }
+
   if (!success)
     {
       g_assert (err != NULL || exo_job_is_cancelled (job));
@@ -389,7 +634,11 @@ thunar_deep_count_job_execute (ExoJob  *job,
   else if (!exo_job_is_cancelled (job))
     {
       /* emit final status update at the very end of the computation */
-      thunar_deep_count_job_status_update (count_job);
+      thunar_deep_count_job_status_update (count_job,
+                                           count_job->total_size,
+                                           count_job->file_count,
+                                           count_job->directory_count,
+                                           count_job->unreadable_directory_count);
     }
 
   return success;
@@ -61,6 +61,9 @@ static void         thunar_details_view_unselect_all            (ThunarStandardV
 static void         thunar_details_view_selection_invert        (ThunarStandardView     *standard_view);
 static void         thunar_details_view_select_path             (ThunarStandardView     *standard_view,
                                                                  GtkTreePath            *path);
+static void         thunar_details_view_select_range            (ThunarStandardView     *standard_view,
+                                                                 GtkTreePath            *start_path,
+                                                                 GtkTreePath            *end_path);
 static void         thunar_details_view_set_cursor              (ThunarStandardView     *standard_view,
                                                                  GtkTreePath            *path,
                                                                  gboolean                start_editing);
@@ -166,6 +169,7 @@ thunar_details_view_class_init (ThunarDetailsViewClass *klass)
   thunarstandard_view_class->unselect_all = thunar_details_view_unselect_all;
   thunarstandard_view_class->selection_invert = thunar_details_view_selection_invert;
   thunarstandard_view_class->select_path = thunar_details_view_select_path;
+  thunarstandard_view_class->select_range = thunar_details_view_select_range;
   thunarstandard_view_class->set_cursor = thunar_details_view_set_cursor;
   thunarstandard_view_class->scroll_to_path = thunar_details_view_scroll_to_path;
   thunarstandard_view_class->get_path_at_pos = thunar_details_view_get_path_at_pos;
@@ -540,6 +544,21 @@ thunar_details_view_select_path (ThunarStandardView *standard_view,
 
 
 
+static void
+thunar_details_view_select_range (ThunarStandardView *standard_view,
+                                  GtkTreePath        *start_path,
+                                  GtkTreePath        *end_path)
+{
+  GtkTreeSelection *selection;
+
+  _thunar_return_if_fail (THUNAR_IS_DETAILS_VIEW (standard_view));
+
+  selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (gtk_bin_get_child (GTK_BIN (standard_view))));
+  gtk_tree_selection_select_range (selection, start_path, end_path);
+}
+
+
+
 static void
 thunar_details_view_set_cursor (ThunarStandardView *standard_view,
                                 GtkTreePath        *path,
@@ -71,9 +71,12 @@
 
 
 
-/* Dump the file cache every X second, set to 0 to disable */
+/* Dump the file cache statistics every X second, set to 0 to disable */
 #define DUMP_FILE_CACHE 0
 
+/* Number of lock-striped shards of the file cache, must be a power of 2 */
+#define FILE_CACHE_N_SHARDS 16
+
 
 
 /* Signal identifiers */
@@ -116,21 +119,39 @@ static gboolean           thunar_file_load                     (ThunarFile
 static gboolean           thunar_file_is_readable              (const ThunarFile       *file);
 static gboolean           thunar_file_same_filesystem          (const ThunarFile       *file_a,
                                                                 const ThunarFile       *file_b);
+static void               thunar_file_content_type_worker      (gpointer                data,
+                                                                gpointer                user_data);
+static gboolean           thunar_file_content_type_results     (gpointer                user_data);
 
 
 
-G_LOCK_DEFINE_STATIC (file_cache_mutex);
 G_LOCK_DEFINE_STATIC (file_content_type_mutex);
+G_LOCK_DEFINE_STATIC (file_content_type_results_mutex);
 G_LOCK_DEFINE_STATIC (file_rename_mutex);
 
 
 
 static ThunarUserManager *user_manager;
-static GHashTable        *file_cache;
 static guint32            effective_user_id;
 static GQuark             thunar_file_watch_quark;
 static guint              file_signals[LAST_SIGNAL];
 
+/* GFile -> GWeakRef of the ThunarFile, split in shards by the hash
+ * of the GFile so lookups from different threads rarely contend */
+static ThunarFileCacheShard file_cache[FILE_CACHE_N_SHARDS];
+static volatile gint        file_cache_n_hits;
+static volatile gint        file_cache_n_misses;
+static volatile gint        file_cache_n_evictions;
+
+/* background content type loading */
+static GThreadPool       *content_type_pool;
+static GSList            *content_type_results;
+static guint              content_type_results_idle_id;
+
+/* interned content type -> ThunarFileApplications, dropped whenever
+ * the installed applications or the mime associations change */
+static GHashTable        *applications_cache;
+
 
 
 #define FLAG_SET_THUMB_STATE(file,new_state) G_STMT_START{ (file)->flags = ((file)->flags & ~THUNAR_FILE_FLAG_THUMB_MASK) | (new_state); }G_STMT_END
@@ -141,6 +162,9 @@ static guint              file_signals[LAST_SIGNAL];
 
 #define DEFAULT_CONTENT_TYPE "application/octet-stream"
 
+/* maximum number of threads sniffing content types */
+#define CONTENT_TYPE_MAX_THREADS 4
+
 
 
 typedef enum
@@ -148,6 +172,8 @@ typedef enum
   THUNAR_FILE_FLAG_THUMB_MASK     = 0x03,   /* storage for ThunarFileThumbState */
   THUNAR_FILE_FLAG_IN_DESTRUCTION = 1 << 2, /* for avoiding recursion during destroy */
   THUNAR_FILE_FLAG_IS_MOUNTED     = 1 << 3, /* whether this file is mounted */
+  THUNAR_FILE_FLAG_CONTENT_TYPE   = 1 << 4, /* content type is being loaded in the background */
+  THUNAR_FILE_FLAG_INFO_NAME      = 1 << 5, /* display name is owned by the GFileInfo */
 }
 ThunarFileFlags;
 
@@ -167,7 +193,8 @@ struct _ThunarFile
   GFileInfo            *info;
   GFileType             kind;
   GFile                *gfile;
-  gchar                *content_type;
+  const gchar          *content_type;       /* interned */
+  const gchar          *content_type_guess; /* interned */
   gchar                *icon_name;
 
   gchar                *custom_icon_name;
@@ -175,7 +202,7 @@ struct _ThunarFile
   gchar                *basename;
   gchar                *thumbnail_path;
 
-  /* sorting */
+  /* sorting, created on demand */
   gchar                *collate_key;
   gchar                *collate_key_nocase;
 
@@ -193,6 +220,23 @@ typedef struct
 }
 ThunarFileWatch;
 
+typedef struct
+{
+  GRWLock        lock;
+  GHashTable    *table;
+}
+ThunarFileCacheShard;
+
+typedef struct
+{
+  ThunarFile    *file;
+  GFile         *gfile;
+  GFileInfo     *info;
+  GCancellable  *cancellable;
+  const gchar   *content_type;
+}
+ThunarFileContentTypeRequest;
+
 typedef struct
 {
   ThunarFileGetFunc  func;
@@ -201,6 +245,14 @@ typedef struct
 }
 ThunarFileGetData;
 
+typedef struct
+{
+  GList         *applications;  /* the default application comes first */
+  const gchar  **ids;           /* the ids of the applications, sorted */
+  guint          n_ids;
+}
+ThunarFileApplications;
+
 static struct
 {
   GUserDirectory  type;
@@ -241,6 +293,119 @@ weak_ref_free (GWeakRef *ref)
 }
 
 
+
+static ThunarFileCacheShard *
+thunar_file_cache_get_shard (const GFile *gfile)
+{
+  static gsize initialized = 0;
+  guint        n;
+
+  /* allocate the ThunarFile cache on-demand */
+  if (g_once_init_enter (&initialized))
+    {
+      for (n = 0; n < FILE_CACHE_N_SHARDS; ++n)
+        {
+          g_rw_lock_init (&file_cache[n].lock);
+          file_cache[n].table = g_hash_table_new_full (g_file_hash,
+                                                       (GEqualFunc) g_file_equal,
+                                                       (GDestroyNotify) g_object_unref,
+                                                       (GDestroyNotify) weak_ref_free);
+        }
+
+      g_once_init_leave (&initialized, 1);
+    }
+
+  return &file_cache[g_file_hash (gfile) & (FILE_CACHE_N_SHARDS - 1)];
+}
+
+
+
+static void
+thunar_file_cache_insert (ThunarFile *file)
+{
+  ThunarFileCacheShard *shard;
+
+  shard = thunar_file_cache_get_shard (file->gfile);
+
+  g_rw_lock_writer_lock (&shard->lock);
+  g_hash_table_insert (shard->table,
+                       g_object_ref (file->gfile),
+                       weak_ref_new (G_OBJECT (file)));
+  g_rw_lock_writer_unlock (&shard->lock);
+}
+
+
+
+static gboolean
+thunar_file_cache_remove (GFile *gfile)
+{
+  ThunarFileCacheShard *shard;
+  GWeakRef             *ref;
+  GObject              *object = NULL;
+  gboolean              removed = FALSE;
+
+  shard = thunar_file_cache_get_shard (gfile);
+
+  g_rw_lock_writer_lock (&shard->lock);
+
+  /* the entry of a finalized file is dead, leave entries of other files alone */
+  ref = g_hash_table_lookup (shard->table, gfile);
+  if (ref != NULL)
+    {
+      object = g_weak_ref_get (ref);
+      if (object == NULL)
+        removed = g_hash_table_remove (shard->table, gfile);
+    }
+
+  g_rw_lock_writer_unlock (&shard->lock);
+
+  /* release outside the lock, this may finalize the other file */
+  if (object != NULL)
+    g_object_unref (object);
+
+  return removed;
+}
+
+
+
+static void
+thunar_file_cache_move (ThunarFile *file,
+                        GFile      *previous_file)
+{
+  ThunarFileCacheShard *previous_shard;
+  ThunarFileCacheShard *shard;
+
+  previous_shard = thunar_file_cache_get_shard (previous_file);
+  shard = thunar_file_cache_get_shard (file->gfile);
+
+  /* hold both shards, so lookups never see the file under neither
+   * location, always locking the shards in array order */
+  if (previous_shard < shard)
+    {
+      g_rw_lock_writer_lock (&previous_shard->lock);
+      g_rw_lock_writer_lock (&shard->lock);
+    }
+  else if (previous_shard > shard)
+    {
+      g_rw_lock_writer_lock (&shard->lock);
+      g_rw_lock_writer_lock (&previous_shard->lock);
+    }
+  else
+    {
+      g_rw_lock_writer_lock (&shard->lock);
+    }
+
+  g_hash_table_remove (previous_shard->table, previous_file);
+  g_hash_table_insert (shard->table,
+                       g_object_ref (file->gfile),
+                       weak_ref_new (G_OBJECT (file)));
+
+  if (previous_shard != shard)
+    g_rw_lock_writer_unlock (&previous_shard->lock);
+  g_rw_lock_writer_unlock (&shard->lock);
+}
+
+
 #ifdef G_ENABLE_DEBUG
 #ifdef HAVE_ATEXIT
 static gboolean thunar_file_atexit_registered = FALSE;
@@ -266,22 +431,23 @@ thunar_file_atexit_foreach (gpointer key,
 static void
 thunar_file_atexit (void)
 {
-  G_LOCK (file_cache_mutex);
+  guint n_files;
+  guint n;
 
-  if (file_cache == NULL || g_hash_table_size (file_cache) == 0)
-    {
-      G_UNLOCK (file_cache_mutex);
-      return;
-    }
+  thunar_file_cache_get_statistics (NULL, NULL, NULL, &n_files);
+  if (n_files == 0)
+    return;
 
-  g_print ("--- Leaked a total of %u ThunarFile objects:\n",
-           g_hash_table_size (file_cache));
+  g_print ("--- Leaked a total of %u ThunarFile objects:\n", n_files);
 
-  g_hash_table_foreach (file_cache, thunar_file_atexit_foreach, NULL);
+  for (n = 0; n < FILE_CACHE_N_SHARDS; ++n)
+    {
+      g_rw_lock_reader_lock (&file_cache[n].lock);
+      g_hash_table_foreach (file_cache[n].table, thunar_file_atexit_foreach, NULL);
+      g_rw_lock_reader_unlock (&file_cache[n].lock);
+    }
 
   g_print ("\n");
-
-  G_UNLOCK (file_cache_mutex);
 }
 #endif
 #endif
@@ -289,36 +455,18 @@ thunar_file_atexit (void)
 
 
 #if DUMP_FILE_CACHE
-static void
-thunar_file_cache_dump_foreach (gpointer gfile,
-                                gpointer value,
-                                gpointer user_data)
-{
-  gchar *name;
-
-  name = g_file_get_parse_name (G_FILE (gfile));
-  g_print ("    %s\n", name);
-  g_free (name);
-}
-
-
-
 static gboolean
 thunar_file_cache_dump (gpointer user_data)
 {
-  G_LOCK (file_cache_mutex);
-
-  if (file_cache != NULL)
-    {
-      g_print ("--- %d ThunarFile objects in cache:\n",
-               g_hash_table_size (file_cache));
-
-      g_hash_table_foreach (file_cache, thunar_file_cache_dump_foreach, NULL);
+  guint n_hits;
+  guint n_misses;
+  guint n_evictions;
+  guint n_files;
 
-      g_print ("\n");
-    }
+  thunar_file_cache_get_statistics (&n_hits, &n_misses, &n_evictions, &n_files);
 
-  G_UNLOCK (file_cache_mutex);
+  g_print ("--- ThunarFile cache: %u objects, %u hits, %u misses, %u evictions\n",
+           n_files, n_hits, n_misses, n_evictions);
 
   return TRUE;
 }
@@ -436,10 +584,9 @@ thunar_file_finalize (GObject *object)
     }
 #endif
 
-  /* drop the entry from the cache */
-  G_LOCK (file_cache_mutex);
-  g_hash_table_remove (file_cache, file->gfile);
-  G_UNLOCK (file_cache_mutex);
+  /* drop the entry from the cache, files that failed to load were never inserted */
+  if (thunar_file_cache_remove (file->gfile))
+    g_atomic_int_inc (&file_cache_n_evictions);
 
   /* release file info */
   if (file->info != NULL)
@@ -449,11 +596,11 @@ thunar_file_finalize (GObject *object)
   g_free (file->custom_icon_name);
 
   /* content type info */
-  g_free (file->content_type);
   g_free (file->icon_name);
 
   /* free display name and basename */
-  g_free (file->display_name);
+  if (!FLAG_IS_SET (file, THUNAR_FILE_FLAG_INFO_NAME))
+    g_free (file->display_name);
   g_free (file->basename);
 
   /* free collate keys */
@@ -739,20 +886,11 @@ thunar_file_monitor_moved (ThunarFile *file,
   /* need to re-register the monitor handle for the new uri */
   thunar_file_watch_reconnect (file);
 
-  G_LOCK (file_cache_mutex);
-
-  /* drop the previous entry from the cache */
-  g_hash_table_remove (file_cache, previous_file);
+  /* replace the previous entry in the cache */
+  thunar_file_cache_move (file, previous_file);
 
   /* drop the reference on the previous file */
   g_object_unref (previous_file);
-
-  /* insert the new entry */
-  g_hash_table_insert (file_cache,
-                       g_object_ref (file->gfile),
-                       weak_ref_new (G_OBJECT (file)));
-
-  G_UNLOCK (file_cache_mutex);
 }
 
 
@@ -933,15 +1071,18 @@ thunar_file_info_clear (ThunarFile *file)
   file->custom_icon_name = NULL;
 
   /* free display name and basename */
-  g_free (file->display_name);
+  if (!FLAG_IS_SET (file, THUNAR_FILE_FLAG_INFO_NAME))
+    g_free (file->display_name);
   file->display_name = NULL;
+  FLAG_UNSET (file, THUNAR_FILE_FLAG_INFO_NAME);
 
   g_free (file->basename);
   file->basename = NULL;
 
-  /* content type */
-  g_free (file->content_type);
+  /* content type, a request still running is for the old info */
   file->content_type = NULL;
+  file->content_type_guess = NULL;
+  FLAG_UNSET (file, THUNAR_FILE_FLAG_CONTENT_TYPE);
   g_free (file->icon_name);
   file->icon_name = NULL;
 
@@ -975,7 +1116,6 @@ thunar_file_info_reload (ThunarFile   *file,
   gchar       *p;
   const gchar *display_name;
   gboolean     is_secure = FALSE;
-  gchar       *casefold;
   gchar       *path;
 
   _thunar_return_if_fail (THUNAR_IS_FILE (file));
@@ -1007,7 +1147,7 @@ thunar_file_info_reload (ThunarFile   *file,
     {
       path = g_file_get_path (file->gfile);
       if (g_strcmp0 (path, "/proc/kmsg") == 0)
-        file->content_type = g_strdup (DEFAULT_CONTENT_TYPE);
+        file->content_type = g_intern_static_string (DEFAULT_CONTENT_TYPE);
       g_free (path);
     }
 
@@ -1077,7 +1217,11 @@ thunar_file_info_reload (ThunarFile   *file,
               if (strcmp (display_name, "/") == 0)
                 file->display_name = g_strdup (_("File System"));
               else
-                file->display_name = g_strdup (display_name);
+                {
+                  /* the info outlives the display name, no need to copy it */
+                  file->display_name = (gchar *) display_name;
+                  FLAG_SET (file, THUNAR_FILE_FLAG_INFO_NAME);
+                }
             }
         }
 
@@ -1086,20 +1230,36 @@ thunar_file_info_reload (ThunarFile   *file,
         file->display_name = thunar_g_file_get_display_name (file->gfile);
     }
 
-  /* create case sensitive collation key */
-  file->collate_key = g_utf8_collate_key_for_filename (file->display_name, -1);
+  /* the collation keys are created when the file is compared by name */
+}
 
-  /* lowercase the display name */
-  casefold = g_utf8_casefold (file->display_name, -1);
 
-  /* if the lowercase name is equal, only peek the already hash key */
-  if (casefold != NULL && strcmp (casefold, file->display_name) != 0)
-    file->collate_key_nocase = g_utf8_collate_key_for_filename (casefold, -1);
-  else
-    file->collate_key_nocase = file->collate_key;
 
-  /* cleanup */
-  g_free (casefold);
+static const gchar *
+thunar_file_get_collate_key (ThunarFile *file,
+                             gboolean    case_sensitive)
+{
+  gchar *casefold;
+
+  if (G_UNLIKELY (file->collate_key == NULL))
+    {
+      /* create case sensitive collation key */
+      file->collate_key = g_utf8_collate_key_for_filename (file->display_name, -1);
+
+      /* lowercase the display name */
+      casefold = g_utf8_casefold (file->display_name, -1);
+
+      /* if the lowercase name is equal, only peek the already hash key */
+      if (casefold != NULL && strcmp (casefold, file->display_name) != 0)
+        file->collate_key_nocase = g_utf8_collate_key_for_filename (casefold, -1);
+      else
+        file->collate_key_nocase = file->collate_key;
+
+      /* cleanup */
+      g_free (casefold);
+    }
+
+  return case_sensitive ? file->collate_key : file->collate_key_nocase;
 }
 
 
@@ -1144,11 +1304,7 @@ thunar_file_get_async_finish (GObject      *object,
    }
 
   /* insert the file into the cache */
-  G_LOCK (file_cache_mutex);
-  g_hash_table_insert (file_cache,
-                       g_object_ref (file->gfile),
-                       weak_ref_new (G_OBJECT (file)));
-  G_UNLOCK (file_cache_mutex);
+  thunar_file_cache_insert (file);
 
   /* pass the loaded file and possible errors to the return function */
   (data->func) (location, file, error, data->user_data);
@@ -1265,16 +1421,8 @@ thunar_file_get (GFile   *gfile,
 
       if (thunar_file_load (file, NULL, error))
         {
-          /* setup lock until the file is inserted */
-          G_LOCK (file_cache_mutex);
-
           /* insert the file into the cache */
-          g_hash_table_insert (file_cache,
-                               g_object_ref (file->gfile),
-                               weak_ref_new (G_OBJECT (file)));
-
-          /* done inserting in the cache */
-          G_UNLOCK (file_cache_mutex);
+          thunar_file_cache_insert (file);
         }
       else
         {
@@ -1344,16 +1492,8 @@ thunar_file_get_with_info (GFile     *gfile,
       if (not_mounted)
         FLAG_UNSET (file, THUNAR_FILE_FLAG_IS_MOUNTED);
 
-      /* setup lock until the file is inserted */
-      G_LOCK (file_cache_mutex);
-
       /* insert the file into the cache */
-      g_hash_table_insert (file_cache,
-                           g_object_ref (file->gfile),
-                           weak_ref_new (G_OBJECT (file)));
-
-      /* done inserting in the cache */
-      G_UNLOCK (file_cache_mutex);
+      thunar_file_cache_insert (file);
     }
 
   return file;
@@ -2485,7 +2625,7 @@ thunar_file_get_content_type (ThunarFile *file)
       if (G_UNLIKELY (file->kind == G_FILE_TYPE_DIRECTORY))
         {
           /* this we known for sure */
-          file->content_type = g_strdup ("inode/directory");
+          file->content_type = g_intern_static_string ("inode/directory");
         }
       else
         {
@@ -2500,7 +2640,7 @@ thunar_file_get_content_type (ThunarFile *file)
               /* store the new content type */
               content_type = g_file_info_get_content_type (info);
               if (G_UNLIKELY (content_type != NULL))
-                file->content_type = g_strdup (content_type);
+                file->content_type = g_intern_string (content_type);
               g_object_unref (G_OBJECT (info));
             }
           else
@@ -2513,7 +2653,7 @@ thunar_file_get_content_type (ThunarFile *file)
 
           /* always provide a fallback */
           if (file->content_type == NULL)
-            file->content_type = g_strdup (DEFAULT_CONTENT_TYPE);
+            file->content_type = g_intern_static_string (DEFAULT_CONTENT_TYPE);
         }
 
       bailout:
@@ -2526,21 +2666,224 @@ thunar_file_get_content_type (ThunarFile *file)
 
 
 
+/**
+ * thunar_file_peek_content_type:
+ * @file : a #ThunarFile.
+ *
+ * Returns the content type of @file if it is already known.
+ * Otherwise returns a guess based on the file name and loads the
+ * real content type in the background, emitting "changed" on
+ * @file if it differs from the guess.
+ *
+ * Use this instead of thunar_file_get_content_type() in places
+ * that must not block, like sorting or rendering of views.
+ *
+ * Return value: content type of @file.
+ **/
+const gchar *
+thunar_file_peek_content_type (ThunarFile *file)
+{
+  gchar *guess;
+
+  _thunar_return_val_if_fail (THUNAR_IS_FILE (file), NULL);
+
+  if (G_LIKELY (file->content_type != NULL))
+    return file->content_type;
+
+  /* queue the file, directories are resolved immediately */
+  thunar_file_load_content_type (file, NULL);
+  if (file->content_type != NULL)
+    return file->content_type;
+
+  /* guess the type from the file name until the real one is loaded */
+  if (file->content_type_guess == NULL)
+    {
+      guess = g_content_type_guess (file->basename, NULL, 0, NULL);
+      file->content_type_guess = g_intern_string (guess);
+      g_free (guess);
+    }
+
+  return file->content_type_guess;
+}
+
+
+
+/**
+ * thunar_file_load_content_type:
+ * @file        : a #ThunarFile.
+ * @cancellable : a #GCancellable or %NULL.
+ *
+ * Queues @file for loading its content type on a worker thread,
+ * unless it is already known or being loaded. If @cancellable is
+ * cancelled before the request finished, the result is dropped and
+ * the content type can be requested again.
+ *
+ * Return value: %TRUE if the content type of @file was unknown.
+ **/
 gboolean
-thunar_file_load_content_type (ThunarFile *file)
+thunar_file_load_content_type (ThunarFile   *file,
+                               GCancellable *cancellable)
 {
+  ThunarFileContentTypeRequest *request;
+
   _thunar_return_val_if_fail (THUNAR_IS_FILE (file), TRUE);
+  _thunar_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), TRUE);
 
-  if (file->content_type != NULL)
+  if (file->content_type != NULL
+      || FLAG_IS_SET (file, THUNAR_FILE_FLAG_CONTENT_TYPE))
     return FALSE;
 
-  thunar_file_get_content_type (file);
+  /* this we known for sure */
+  if (file->kind == G_FILE_TYPE_DIRECTORY)
+    {
+      thunar_file_get_content_type (file);
+      return TRUE;
+    }
+
+  if (G_UNLIKELY (content_type_pool == NULL))
+    {
+      content_type_pool = g_thread_pool_new (thunar_file_content_type_worker, NULL,
+                                             CONTENT_TYPE_MAX_THREADS, FALSE, NULL);
+    }
+
+  FLAG_SET (file, THUNAR_FILE_FLAG_CONTENT_TYPE);
+
+  request = g_slice_new0 (ThunarFileContentTypeRequest);
+  request->file = g_object_ref (file);
+  request->gfile = g_object_ref (file->gfile);
+  if (file->info != NULL)
+    request->info = g_object_ref (file->info);
+  if (cancellable != NULL)
+    request->cancellable = g_object_ref (cancellable);
+  g_thread_pool_push (content_type_pool, request, NULL);
 
   return TRUE;
 }
 
 
 
+static void
+thunar_file_content_type_request_free (ThunarFileContentTypeRequest *request)
+{
+  g_object_unref (request->file);
+  g_object_unref (request->gfile);
+  if (request->info != NULL)
+    g_object_unref (request->info);
+  if (request->cancellable != NULL)
+    g_object_unref (request->cancellable);
+  g_slice_free (ThunarFileContentTypeRequest, request);
+}
+
+
+
+static void
+thunar_file_content_type_worker (gpointer data,
+                                 gpointer user_data)
+{
+  ThunarFileContentTypeRequest *request = data;
+  GFileInfo                    *info;
+
+  /* sniff the content type, the file is only touched in the main thread */
+  if (!g_cancellable_is_cancelled (request->cancellable))
+    {
+      info = g_file_query_info (request->gfile,
+                                G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE,
+                                G_FILE_QUERY_INFO_NONE,
+                                request->cancellable, NULL);
+    }
+  else
+    {
+      info = NULL;
+    }
+
+  if (G_LIKELY (info != NULL))
+    {
+      request->content_type = g_intern_string (g_file_info_get_content_type (info));
+      g_object_unref (G_OBJECT (info));
+    }
+
+  /* hand the result over to the main thread, where all results
+   * that arrived in the meantime are applied in one go */
+  G_LOCK (file_content_type_results_mutex);
+  content_type_results = g_slist_prepend (content_type_results, request);
+  if (content_type_results_idle_id == 0)
+    content_type_results_idle_id = g_idle_add (thunar_file_content_type_results, NULL);
+  G_UNLOCK (file_content_type_results_mutex);
+}
+
+
+
+static gboolean
+thunar_file_content_type_results (gpointer user_data)
+{
+  ThunarFileContentTypeRequest *request;
+  ThunarFile                   *file;
+  GSList                       *results;
+  GSList                       *lp;
+  gboolean                      changed;
+
+  G_LOCK (file_content_type_results_mutex);
+  results = content_type_results;
+  content_type_results = NULL;
+  content_type_results_idle_id = 0;
+  G_UNLOCK (file_content_type_results_mutex);
+
+  for (lp = results; lp != NULL; lp = lp->next)
+    {
+      request = lp->data;
+      file = request->file;
+
+      /* ignore results for a previous info, the file was reloaded meanwhile
+       * and the flag belongs to a newer request, if any */
+      if (file->info != request->info)
+        {
+          thunar_file_content_type_request_free (request);
+          continue;
+        }
+
+      FLAG_UNSET (file, THUNAR_FILE_FLAG_CONTENT_TYPE);
+
+      /* store the result, unless the request was cancelled or the file moved meanwhile */
+      G_LOCK (file_content_type_mutex);
+      if (file->content_type == NULL
+          && file->gfile == request->gfile
+          && !g_cancellable_is_cancelled (request->cancellable))
+        {
+          if (G_LIKELY (request->content_type != NULL))
+            file->content_type = request->content_type;
+          else
+            file->content_type = g_intern_static_string (DEFAULT_CONTENT_TYPE);
+        }
+      G_UNLOCK (file_content_type_mutex);
+
+      /* the views only need an update if they used a wrong guess */
+      if (file->content_type != NULL && file->content_type_guess != NULL)
+        {
+          /* both strings are interned */
+          changed = (file->content_type != file->content_type_guess);
+          file->content_type_guess = NULL;
+
+          if (changed)
+            {
+              /* the icon and thumbnail depend on the content type */
+              g_free (file->icon_name);
+              file->icon_name = NULL;
+              FLAG_SET_THUMB_STATE (file, THUNAR_FILE_THUMB_STATE_UNKNOWN);
+
+              thunar_file_changed (file);
+            }
+        }
+
+      thunar_file_content_type_request_free (request);
+    }
+
+  g_slist_free (results);
+
+  return FALSE;
+}
+
+
+
 /**
  * thunar_file_get_symlink_target:
  * @file : a #ThunarFile.
@@ -3536,12 +3879,79 @@ thunar_file_is_desktop (const ThunarFile *file)
 
 
 
-const gchar *
-thunar_file_get_thumbnail_path (ThunarFile *file, ThunarThumbnailSize thumbnail_size)
+/**
+ * thunar_file_find_thumbnail_path:
+ * @uri            : the uri of a file.
+ * @thumbnail_size : the #ThunarThumbnailSize to look for.
+ *
+ * Looks up the thumbnail of the file at @uri on disk. Unlike
+ * thunar_file_get_thumbnail_path() this does not need a #ThunarFile,
+ * so it can be used from worker threads.
+ *
+ * The caller is responsible to free the returned string.
+ *
+ * Return value: the path of the thumbnail or %NULL if there is none.
+ **/
+gchar *
+thunar_file_find_thumbnail_path (const gchar        *uri,
+                                 ThunarThumbnailSize thumbnail_size)
 {
   GChecksum *checksum;
   gchar     *filename;
-  gchar     *uri;
+  gchar     *path;
+
+  _thunar_return_val_if_fail (uri != NULL, NULL);
+
+  checksum = g_checksum_new (G_CHECKSUM_MD5);
+  if (G_UNLIKELY (checksum == NULL))
+    return NULL;
+
+  g_checksum_update (checksum, (const guchar *) uri, strlen (uri));
+
+  filename = g_strconcat (g_checksum_get_string (checksum), ".png", NULL);
+  g_checksum_free (checksum);
+
+  /* The thumbnail is in the format/location
+   * $XDG_CACHE_HOME/thumbnails/(nromal|large)/MD5_Hash_Of_URI.png
+   * for version 0.8.0 if XDG_CACHE_HOME is defined, otherwise
+   * /homedir/.thumbnails/(normal|large)/MD5_Hash_Of_URI.png
+   * will be used, which is also always used for versions prior
+   * to 0.7.0.
+   */
+
+  /* build and check if the thumbnail is in the new location */
+  path = g_build_path ("/", g_get_user_cache_dir(),
+                       "thumbnails", thunar_thumbnail_size_get_nick (thumbnail_size),
+                       filename, NULL);
+
+  if (!g_file_test(path, G_FILE_TEST_EXISTS))
+    {
+      /* Fallback to old version */
+      g_free(path);
+
+      path = g_build_filename (xfce_get_homedir (),
+                               ".thumbnails", thunar_thumbnail_size_get_nick (thumbnail_size),
+                               filename, NULL);
+
+      if(!g_file_test(path, G_FILE_TEST_EXISTS))
+      {
+        /* Thumbnail doesn't exist in either spot */
+        g_free(path);
+        path = NULL;
+      }
+    }
+
+  g_free (filename);
+
+  return path;
+}
+
+
+
+const gchar *
+thunar_file_get_thumbnail_path (ThunarFile *file, ThunarThumbnailSize thumbnail_size)
+{
+  gchar *uri;
 
   _thunar_return_val_if_fail (THUNAR_IS_FILE (file), NULL);
 
@@ -3551,48 +3961,9 @@ thunar_file_get_thumbnail_path (ThunarFile *file, ThunarThumbnailSize thumbnail_
 
   if (G_UNLIKELY (file->thumbnail_path == NULL))
     {
-      checksum = g_checksum_new (G_CHECKSUM_MD5);
-      if (G_LIKELY (checksum != NULL))
-        {
-          uri = thunar_file_dup_uri (file);
-          g_checksum_update (checksum, (const guchar *) uri, strlen (uri));
-          g_free (uri);
-
-          filename = g_strconcat (g_checksum_get_string (checksum), ".png", NULL);
-          g_checksum_free (checksum);
-
-          /* The thumbnail is in the format/location
-           * $XDG_CACHE_HOME/thumbnails/(nromal|large)/MD5_Hash_Of_URI.png
-           * for version 0.8.0 if XDG_CACHE_HOME is defined, otherwise
-           * /homedir/.thumbnails/(normal|large)/MD5_Hash_Of_URI.png
-           * will be used, which is also always used for versions prior
-           * to 0.7.0.
-           */
-
-          /* build and check if the thumbnail is in the new location */
-          file->thumbnail_path = g_build_path ("/", g_get_user_cache_dir(),
-                                               "thumbnails", thunar_thumbnail_size_get_nick (thumbnail_size),
-                                               filename, NULL);
-
-          if (!g_file_test(file->thumbnail_path, G_FILE_TEST_EXISTS))
-            {
-              /* Fallback to old version */
-              g_free(file->thumbnail_path);
-
-              file->thumbnail_path = g_build_filename (xfce_get_homedir (),
-                                                       ".thumbnails", thunar_thumbnail_size_get_nick (thumbnail_size),
-                                                       filename, NULL);
-
-              if(!g_file_test(file->thumbnail_path, G_FILE_TEST_EXISTS))
-              {
-                /* Thumbnail doesn't exist in either spot */
-                g_free(file->thumbnail_path);
-                file->thumbnail_path = NULL;
-              }
-            }
-
-          g_free (filename);
-        }
+      uri = thunar_file_dup_uri (file);
+      file->thumbnail_path = thunar_file_find_thumbnail_path (uri, thumbnail_size);
+      g_free (uri);
     }
 
   return file->thumbnail_path;
@@ -3865,7 +4236,7 @@ thunar_file_get_icon_name (ThunarFile          *file,
     return NULL;
 
   /* lookup for content type, just like gio does for local files */
-  icon = g_content_type_get_icon (thunar_file_get_content_type (file));
+  icon = g_content_type_get_icon (thunar_file_peek_content_type (file));
   if (G_LIKELY (icon != NULL))
     {
       check_icon:
@@ -4144,11 +4515,17 @@ thunar_file_compare_by_name (const ThunarFile *file_a,
 
   /* case insensitive checking */
   if (G_LIKELY (!case_sensitive))
-    result = g_strcmp0 (file_a->collate_key_nocase, file_b->collate_key_nocase);
+    {
+      result = g_strcmp0 (thunar_file_get_collate_key (THUNAR_FILE (file_a), FALSE),
+                          thunar_file_get_collate_key (THUNAR_FILE (file_b), FALSE));
+    }
 
   /* fall-back to case sensitive */
   if (result == 0)
-    result = g_strcmp0 (file_a->collate_key, file_b->collate_key);
+    {
+      result = g_strcmp0 (thunar_file_get_collate_key (THUNAR_FILE (file_a), TRUE),
+                          thunar_file_get_collate_key (THUNAR_FILE (file_b), TRUE));
+    }
 
   /* this happens in the trash */
   if (result == 0)
@@ -4209,36 +4586,79 @@ thunar_file_same_filesystem (const ThunarFile *file_a,
 ThunarFile *
 thunar_file_cache_lookup (const GFile *file)
 {
-  GWeakRef   *ref;
-  ThunarFile *cached_file;
+  ThunarFileCacheShard *shard;
+  GWeakRef             *ref;
+  ThunarFile           *cached_file;
 
   _thunar_return_val_if_fail (G_IS_FILE (file), NULL);
 
-  G_LOCK (file_cache_mutex);
+  shard = thunar_file_cache_get_shard (file);
 
-  /* allocate the ThunarFile cache on-demand */
-  if (G_UNLIKELY (file_cache == NULL))
-    {
-      file_cache = g_hash_table_new_full (g_file_hash,
-                                          (GEqualFunc) g_file_equal,
-                                          (GDestroyNotify) g_object_unref,
-                                          (GDestroyNotify) weak_ref_free);
-    }
+  /* lookups only need a read lock, so they run concurrently */
+  g_rw_lock_reader_lock (&shard->lock);
 
-  ref = g_hash_table_lookup (file_cache, file);
+  ref = g_hash_table_lookup (shard->table, file);
 
   if (ref == NULL)
     cached_file = NULL;
   else
     cached_file = g_weak_ref_get (ref);
 
-  G_UNLOCK (file_cache_mutex);
+  g_rw_lock_reader_unlock (&shard->lock);
+
+  if (cached_file != NULL)
+    g_atomic_int_inc (&file_cache_n_hits);
+  else
+    g_atomic_int_inc (&file_cache_n_misses);
 
   return cached_file;
 }
 
 
 
+/**
+ * thunar_file_cache_get_statistics:
+ * @n_hits      : return location for the number of successful lookups or %NULL.
+ * @n_misses    : return location for the number of failed lookups or %NULL.
+ * @n_evictions : return location for the number of files dropped from the cache or %NULL.
+ * @n_files     : return location for the number of files in the cache or %NULL.
+ *
+ * Returns usage statistics of the internal file cache, which are
+ * counted since the start of the application.
+ **/
+void
+thunar_file_cache_get_statistics (guint *n_hits,
+                                  guint *n_misses,
+                                  guint *n_evictions,
+                                  guint *n_files)
+{
+  guint n;
+
+  if (n_hits != NULL)
+    *n_hits = g_atomic_int_get (&file_cache_n_hits);
+  if (n_misses != NULL)
+    *n_misses = g_atomic_int_get (&file_cache_n_misses);
+  if (n_evictions != NULL)
+    *n_evictions = g_atomic_int_get (&file_cache_n_evictions);
+
+  if (n_files != NULL)
+    {
+      *n_files = 0;
+      for (n = 0; n < FILE_CACHE_N_SHARDS; ++n)
+        {
+          /* the shards are allocated on the first lookup */
+          if (file_cache[n].table == NULL)
+            break;
+
+          g_rw_lock_reader_lock (&file_cache[n].lock);
+          *n_files += g_hash_table_size (file_cache[n].table);
+          g_rw_lock_reader_unlock (&file_cache[n].lock);
+        }
+    }
+}
+
+
+
 gchar *
 thunar_file_cached_display_name (const GFile *file)
 {
@@ -4264,11 +4684,97 @@ thunar_file_cached_display_name (const GFile *file)
 
 
 
+static void
+thunar_file_applications_free (gpointer data)
+{
+  ThunarFileApplications *entry = data;
+
+  g_list_free_full (entry->applications, g_object_unref);
+  g_free (entry->ids);
+  g_slice_free (ThunarFileApplications, entry);
+}
+
+
+
 static gint
-compare_app_infos (gconstpointer a,
-                   gconstpointer b)
+thunar_file_applications_compare_ids (gconstpointer a,
+                                      gconstpointer b)
 {
-  return g_app_info_equal (G_APP_INFO (a), G_APP_INFO (b)) ? 0 : 1;
+  return strcmp (*(const gchar *const *) a, *(const gchar *const *) b);
+}
+
+
+
+#if GLIB_CHECK_VERSION (2, 40, 0)
+static void
+thunar_file_applications_changed (GAppInfoMonitor *monitor)
+{
+  /* the lists are built again on demand */
+  g_hash_table_remove_all (applications_cache);
+}
+#endif
+
+
+
+static ThunarFileApplications *
+thunar_file_applications_lookup (const gchar *content_type)
+{
+  ThunarFileApplications *entry;
+  GAppInfo               *default_application;
+  GList                  *ap;
+  const gchar            *id;
+
+  if (G_UNLIKELY (applications_cache == NULL))
+    {
+      applications_cache = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                                  NULL, thunar_file_applications_free);
+
+#if GLIB_CHECK_VERSION (2, 40, 0)
+      /* the monitor is never released, just like the cache */
+      g_signal_connect (G_OBJECT (g_app_info_monitor_get ()), "changed",
+                        G_CALLBACK (thunar_file_applications_changed), NULL);
+#endif
+    }
+
+  /* content types are interned, so the pointer is the key */
+  entry = g_hash_table_lookup (applications_cache, content_type);
+  if (G_LIKELY (entry != NULL))
+    return entry;
+
+  entry = g_slice_new0 (ThunarFileApplications);
+  entry->applications = g_app_info_get_all_for_type (content_type);
+
+  /* move any default application in front of the list */
+  default_application = g_app_info_get_default_for_type (content_type, FALSE);
+  if (G_LIKELY (default_application != NULL))
+    {
+      for (ap = entry->applications; ap != NULL; ap = ap->next)
+        {
+          if (g_app_info_equal (ap->data, default_application))
+            {
+              g_object_unref (ap->data);
+              entry->applications = g_list_delete_link (entry->applications, ap);
+              break;
+            }
+        }
+      entry->applications = g_list_prepend (entry->applications, default_application);
+    }
+
+  /* collect the sorted ids, so the applications of different content
+   * types can be intersected with a single merge */
+  entry->ids = g_new (const gchar *, g_list_length (entry->applications) + 1);
+  for (ap = entry->applications; ap != NULL; ap = ap->next)
+    {
+      id = g_app_info_get_id (ap->data);
+      if (G_LIKELY (id != NULL))
+        entry->ids[entry->n_ids++] = id;
+    }
+  entry->ids[entry->n_ids] = NULL;
+  qsort (entry->ids, entry->n_ids, sizeof (gchar *), thunar_file_applications_compare_ids);
+
+  g_hash_table_insert (applications_cache, (gpointer) content_type, entry);
+
+  return entry;
 }
 
 
@@ -4291,85 +4797,111 @@ compare_app_infos (gconstpointer a,
 GList*
 thunar_file_list_get_applications (GList *file_list)
 {
-  GList       *applications = NULL;
-  GList       *list;
-  GList       *next;
-  GList       *ap;
-  GList       *lp;
-  GAppInfo    *default_application;
-  const gchar *previous_type = NULL;
-  const gchar *current_type;
+  ThunarFileApplications  *first = NULL;
+  ThunarFileApplications  *entry;
+  GHashTable              *types;
+  GList                   *applications = NULL;
+  GList                   *next;
+  GList                   *ap;
+  GList                   *lp;
+  const gchar            **ids = NULL;
+  const gchar             *previous_type = NULL;
+  const gchar             *current_type;
+  const gchar             *id;
+  gboolean                 intersected;
+  guint                    n_ids = 0;
+  guint                    i, j, k;
+  gint                     cmp;
+
+#if !GLIB_CHECK_VERSION (2, 40, 0)
+  /* without a monitor the lists are only valid for a single call */
+  if (applications_cache != NULL)
+    g_hash_table_remove_all (applications_cache);
+#endif
 
   /* determine the set of applications that can open all files */
+  types = g_hash_table_new (g_direct_hash, g_direct_equal);
   for (lp = file_list; lp != NULL; lp = lp->next)
     {
       current_type = thunar_file_get_content_type (lp->data);
 
-      /* no need to check anything if this file has the same mimetype as the previous file */
-      if (current_type != NULL && previous_type != NULL)
-        if (G_LIKELY (g_content_type_equals (previous_type, current_type)))
-          continue;
+      /* no application can open a file without a content type */
+      if (G_UNLIKELY (current_type == NULL))
+        {
+          first = NULL;
+          break;
+        }
 
-      /* store the previous type */
+      /* no need to check anything if this file has the same mimetype as a previous file */
+      if (current_type == previous_type)
+        continue;
       previous_type = current_type;
+      if (g_hash_table_lookup (types, current_type) != NULL)
+        continue;
+      g_hash_table_insert (types, (gpointer) current_type, (gpointer) current_type);
 
-      /* determine the list of applications that can open this file */
-      if (G_UNLIKELY (current_type != NULL))
+      entry = thunar_file_applications_lookup (current_type);
+      if (first == NULL)
         {
-          list = g_app_info_get_all_for_type (current_type);
-
-          /* move any default application in front of the list */
-          default_application = g_app_info_get_default_for_type (current_type, FALSE);
-          if (G_LIKELY (default_application != NULL))
+          /* first content type, so just use its applications */
+          first = entry;
+          ids = g_new (const gchar *, entry->n_ids + 1);
+          memcpy (ids, entry->ids, (entry->n_ids + 1) * sizeof (gchar *));
+          n_ids = entry->n_ids;
+        }
+      else
+        {
+          /* keep only the applications that are also present for this type */
+          for (i = j = k = 0; i < n_ids && j < entry->n_ids; )
             {
-              for (ap = list; ap != NULL; ap = ap->next)
+              cmp = strcmp (ids[i], entry->ids[j]);
+              if (cmp < 0)
                 {
-                  if (g_app_info_equal (ap->data, default_application))
-                    {
-                      g_object_unref (ap->data);
-                      list = g_list_delete_link (list, ap);
-                      break;
-                    }
+                  i++;
+                }
+              else if (cmp > 0)
+                {
+                  j++;
+                }
+              else
+                {
+                  ids[k++] = ids[i];
+                  i++;
+                  j++;
                 }
-              list = g_list_prepend (list, default_application);
             }
+          n_ids = k;
         }
-      else
-        list = NULL;
 
-      if (G_UNLIKELY (applications == NULL))
+      /* check if the set is still not empty */
+      if (G_UNLIKELY (first->applications == NULL || (first != entry && n_ids == 0)))
         {
-          /* first file, so just use the applications list */
-          applications = list;
+          first = NULL;
+          break;
         }
-      else
+    }
+
+  if (G_LIKELY (first != NULL))
+    {
+      intersected = (g_hash_table_size (types) > 1);
+      for (ap = g_list_last (first->applications); ap != NULL; ap = ap->prev)
         {
-          /* keep only the applications that are also present in list */
-          for (ap = applications; ap != NULL; ap = next)
+          /* with multiple content types, only the applications left in the
+           * intersection are kept (applications without id never match) */
+          if (intersected)
             {
-              /* grab a pointer on the next application */
-              next = ap->next;
-
-              /* check if the application is present in list */
-              if (g_list_find_custom (list, ap->data, compare_app_infos) == NULL)
-                {
-                  /* drop our reference on the application */
-                  g_object_unref (G_OBJECT (ap->data));
-
-                  /* drop this application from the list */
-                  applications = g_list_delete_link (applications, ap);
-                }
+              id = g_app_info_get_id (ap->data);
+              if (id == NULL || bsearch (&id, ids, n_ids, sizeof (gchar *), thunar_file_applications_compare_ids) == NULL)
+                continue;
             }
 
-          /* release the list of applications for this file */
-          g_list_free_full (list, g_object_unref);
+          applications = g_list_prepend (applications, g_object_ref (ap->data));
         }
-
-      /* check if the set is still not empty */
-      if (G_LIKELY (applications == NULL))
-        break;
     }
 
+  g_hash_table_destroy (types);
+  g_free (ids);
+
   /* remove hidden applications */
   for (ap = applications; ap != NULL; ap = next)
     {
@@ -181,7 +181,9 @@ ThunarGroup      *thunar_file_get_group                  (const ThunarFile
 ThunarUser       *thunar_file_get_user                   (const ThunarFile       *file);
 
 const gchar      *thunar_file_get_content_type           (ThunarFile             *file);
-gboolean          thunar_file_load_content_type          (ThunarFile             *file);
+const gchar      *thunar_file_peek_content_type          (ThunarFile             *file);
+gboolean          thunar_file_load_content_type          (ThunarFile             *file,
+                                                          GCancellable           *cancellable);
 const gchar      *thunar_file_get_symlink_target         (const ThunarFile       *file);
 const gchar      *thunar_file_get_basename               (const ThunarFile       *file) G_GNUC_CONST;
 gboolean          thunar_file_is_symlink                 (const ThunarFile       *file);
@@ -231,6 +233,8 @@ gboolean          thunar_file_set_custom_icon            (ThunarFile
                                                           const gchar             *custom_icon,
                                                           GError                 **error);
 
+gchar           *thunar_file_find_thumbnail_path         (const gchar             *uri,
+                                                          ThunarThumbnailSize      thumbnail_size);
 const gchar     *thunar_file_get_thumbnail_path          (ThunarFile              *file,
                                                           ThunarThumbnailSize      thumbnail_size);
 ThunarFileThumbState thunar_file_get_thumb_state         (const ThunarFile        *file);
@@ -255,10 +259,14 @@ void              thunar_file_destroy                    (ThunarFile
 
 gint              thunar_file_compare_by_name            (const ThunarFile        *file_a,
                                                           const ThunarFile        *file_b,
-                                                          gboolean                 case_sensitive) G_GNUC_PURE;
+                                                          gboolean                 case_sensitive);
 
 ThunarFile       *thunar_file_cache_lookup               (const GFile             *file);
 gchar            *thunar_file_cached_display_name        (const GFile             *file);
+void              thunar_file_cache_get_statistics       (guint                   *n_hits,
+                                                          guint                   *n_misses,
+                                                          guint                   *n_evictions,
+                                                          guint                   *n_files);
 
 
 GList            *thunar_file_list_get_applications      (GList                  *file_list);
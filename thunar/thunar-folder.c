@@ -31,6 +31,9 @@
 
 #define DEBUG_FILE_CHANGES FALSE
 
+/* number of files queued for content type loading per idle run */
+#define CONTENT_TYPE_BATCH_SIZE 100
+
 
 
 /* property identifiers */
@@ -109,10 +112,13 @@ struct _ThunarFolder
   ThunarFile        *corresponding_file;
   GList             *new_files;
   GList             *files;
+  GHashTable        *files_map;
   gboolean           reload_info;
+  gboolean           incremental;
 
   GList             *content_type_ptr;
   guint              content_type_idle_id;
+  GCancellable      *content_type_cancellable;
 
   guint              in_destruction : 1;
 
@@ -250,6 +256,13 @@ thunar_folder_init (ThunarFolder *folder)
 
   folder->monitor = NULL;
   folder->reload_info = FALSE;
+  folder->incremental = FALSE;
+
+  /* lookup table for the links in the files list */
+  folder->files_map = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+  /* cancels the content type requests of the files */
+  folder->content_type_cancellable = g_cancellable_new ();
 }
 
 
@@ -307,14 +320,17 @@ thunar_folder_finalize (GObject *object)
       g_object_unref (G_OBJECT (folder->corresponding_file));
     }
 
-  /* stop metadata collector */
+  /* stop metadata collector and drop the queued requests */
   if (folder->content_type_idle_id != 0)
     g_source_remove (folder->content_type_idle_id);
+  g_cancellable_cancel (folder->content_type_cancellable);
+  g_object_unref (folder->content_type_cancellable);
 
   /* release references to the new files */
   thunar_g_file_list_free (folder->new_files);
 
   /* release references to the current files */
+  g_hash_table_destroy (folder->files_map);
   thunar_g_file_list_free (folder->files);
 
   (*G_OBJECT_CLASS (thunar_folder_parent_class)->finalize) (object);
@@ -405,12 +421,31 @@ thunar_folder_files_ready (ThunarJob    *job,
                            GList        *files,
                            ThunarFolder *folder)
 {
+  GList *added;
+  GList *lp;
+
   _thunar_return_val_if_fail (THUNAR_IS_FOLDER (folder), FALSE);
   _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
   _thunar_return_val_if_fail (folder->monitor == NULL, FALSE);
 
-  /* merge the list with the existing list of new files */
-  folder->new_files = g_list_concat (folder->new_files, files);
+  if (folder->incremental)
+    {
+      /* remember the list links and add the files to the internal files list,
+       * the signal handlers may already look at the files of the folder */
+      for (lp = files; lp != NULL; lp = lp->next)
+        g_hash_table_insert (folder->files_map, lp->data, lp);
+      added = g_list_copy (files);
+      folder->files = g_list_concat (files, folder->files);
+
+      /* there is nothing to merge with, so tell others about the new files right away */
+      g_signal_emit (G_OBJECT (folder), folder_signals[FILES_ADDED], 0, added);
+      g_list_free (added);
+    }
+  else
+    {
+      /* merge the list with the existing list of new files */
+      folder->new_files = g_list_concat (folder->new_files, files);
+    }
 
   /* indicate that we took over ownership of the file list */
   return TRUE;
@@ -423,14 +458,16 @@ thunar_folder_content_type_loader_idle (gpointer data)
 {
   ThunarFolder *folder;
   GList        *lp;
+  guint         n_queued = 0;
 
   _thunar_return_val_if_fail (THUNAR_IS_FOLDER (data), FALSE);
 
   folder = THUNAR_FOLDER (data);
 
-  /* load another files content type */
+  /* queue another batch of files for content type loading */
   for (lp = folder->content_type_ptr; lp != NULL; lp = lp->next)
-    if (thunar_file_load_content_type (lp->data))
+    if (thunar_file_load_content_type (lp->data, folder->content_type_cancellable)
+        && ++n_queued >= CONTENT_TYPE_BATCH_SIZE)
       {
         /* if this was the last file, abort */
         if (G_UNLIKELY (lp->next == NULL))
@@ -479,7 +516,9 @@ thunar_folder_finished (ExoJob       *job,
                         ThunarFolder *folder)
 {
   ThunarFile *file;
+  GHashTable *new_files_set;
   GList      *files;
+  GList      *next;
   GList      *lp;
 
   _thunar_return_if_fail (THUNAR_IS_FOLDER (folder));
@@ -488,18 +527,25 @@ thunar_folder_finished (ExoJob       *job,
   _thunar_return_if_fail (folder->monitor == NULL);
   _thunar_return_if_fail (folder->content_type_idle_id == 0);
 
-  /* check if we need to merge new files with existing files */
-  if (G_UNLIKELY (folder->files != NULL))
+  /* merge the new files with the existing files, unless they were
+   * already added while the folder was loading */
+  if (G_UNLIKELY (!folder->incremental))
     {
+      /* collect the new files in a set for fast lookups */
+      new_files_set = g_hash_table_new (g_direct_hash, g_direct_equal);
+      for (lp = folder->new_files; lp != NULL; lp = lp->next)
+        g_hash_table_insert (new_files_set, lp->data, lp->data);
+
       /* determine all added files (files on new_files, but not on files) */
       for (files = NULL, lp = folder->new_files; lp != NULL; lp = lp->next)
-        if (g_list_find (folder->files, lp->data) == NULL)
+        if (g_hash_table_lookup (folder->files_map, lp->data) == NULL)
           {
             /* put the file on the added list */
             files = g_list_prepend (files, lp->data);
 
             /* add to the internal files list */
             folder->files = g_list_prepend (folder->files, lp->data);
+            g_hash_table_insert (folder->files_map, lp->data, folder->files);
             g_object_ref (G_OBJECT (lp->data));
           }
 
@@ -520,19 +566,24 @@ thunar_folder_finished (ExoJob       *job,
           file = THUNAR_FILE (lp->data);
 
           /* determine the next list item */
-          lp = lp->next;
+          next = lp->next;
 
           /* check if the file is not on new_files */
-          if (g_list_find (folder->new_files, file) == NULL)
+          if (g_hash_table_lookup (new_files_set, file) == NULL)
             {
               /* put the file on the removed list (owns the reference now) */
               files = g_list_prepend (files, file);
 
               /* remove from the internal files list */
-              folder->files = g_list_remove (folder->files, file);
+              g_hash_table_remove (folder->files_map, file);
+              folder->files = g_list_delete_link (folder->files, lp);
             }
+
+          lp = next;
         }
 
+      g_hash_table_destroy (new_files_set);
+
       /* check if any files were removed */
       if (G_UNLIKELY (files != NULL))
         {
@@ -547,18 +598,6 @@ thunar_folder_finished (ExoJob       *job,
       thunar_g_file_list_free (folder->new_files);
       folder->new_files = NULL;
     }
-  else
-    {
-      /* just use the new files for the files list */
-      folder->files = folder->new_files;
-      folder->new_files = NULL;
-
-      if (folder->files != NULL)
-        {
-          /* emit a "files-added" signal for the new files */
-          g_signal_emit (G_OBJECT (folder), folder_signals[FILES_ADDED], 0, folder->files);
-        }
-    }
 
   /* schedule a reload of the file information of all files if requested */
   if (folder->reload_info)
@@ -634,13 +673,14 @@ thunar_folder_file_destroyed (ThunarFileMonitor *file_monitor,
   else
     {
       /* check if we have that file */
-      lp = g_list_find (folder->files, file);
+      lp = g_hash_table_lookup (folder->files_map, file);
       if (G_LIKELY (lp != NULL))
         {
           if (folder->content_type_idle_id != 0)
             restart = g_source_remove (folder->content_type_idle_id);
 
           /* remove the file from our list */
+          g_hash_table_remove (folder->files_map, file);
           folder->files = g_list_delete_link (folder->files, lp);
 
           /* tell everybody that the file is gone */
@@ -741,9 +781,16 @@ thunar_folder_monitor (GFileMonitor     *monitor,
   if (!g_file_equal (event_file, thunar_file_get_file (folder->corresponding_file)))
     {
       /* check if we already ship the file */
-      for (lp = folder->files; lp != NULL; lp = lp->next)
-        if (g_file_equal (event_file, thunar_file_get_file (lp->data)))
-          break;
+      file = thunar_file_cache_lookup (event_file);
+      if (G_LIKELY (file != NULL))
+        {
+          lp = g_hash_table_lookup (folder->files_map, file);
+          g_object_unref (file);
+        }
+      else
+        {
+          lp = NULL;
+        }
 
       /* stop the content type collector */
       if (folder->content_type_idle_id != 0)
@@ -758,6 +805,7 @@ thunar_folder_monitor (GFileMonitor     *monitor,
             {
               /* prepend it to our internal list */
               folder->files = g_list_prepend (folder->files, file);
+              g_hash_table_insert (folder->files_map, file, folder->files);
 
               /* tell others about the new file */
               list.data = file; list.next = list.prev = NULL;
@@ -977,9 +1025,12 @@ thunar_folder_reload (ThunarFolder *folder,
   /* reload file info too? */
   folder->reload_info = reload_info;
 
-  /* stop metadata collector */
+  /* stop metadata collector and drop the queued requests */
   if (folder->content_type_idle_id != 0)
     g_source_remove (folder->content_type_idle_id);
+  g_cancellable_cancel (folder->content_type_cancellable);
+  g_object_unref (folder->content_type_cancellable);
+  folder->content_type_cancellable = g_cancellable_new ();
 
   /* check if we are currently connect to a job */
   if (G_UNLIKELY (folder->job != NULL))
@@ -1003,6 +1054,9 @@ thunar_folder_reload (ThunarFolder *folder,
   thunar_g_file_list_free (folder->new_files);
   folder->new_files = NULL;
 
+  /* without files to merge with, the files can be added while loading */
+  folder->incremental = (folder->files == NULL);
+
   /* start a new job */
   folder->job = thunar_io_jobs_list_directory (thunar_file_get_file (folder->corresponding_file));
   g_signal_connect (folder->job, "error", G_CALLBACK (thunar_folder_error), folder);
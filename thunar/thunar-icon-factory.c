@@ -30,6 +30,7 @@
 #include <string.h>
 #endif
 
+#include <thunar/thunar-file-monitor.h>
 #include <thunar/thunar-gobject-extensions.h>
 #include <thunar/thunar-icon-factory.h>
 #include <thunar/thunar-preferences.h>
@@ -41,6 +42,23 @@
 /* the timeout until the sweeper is run (in seconds) */
 #define THUNAR_ICON_FACTORY_SWEEP_TIMEOUT (30)
 
+/* number of threads decoding thumbnails */
+#define THUNAR_ICON_FACTORY_THUMBNAIL_THREADS (4)
+
+/* maximum number of queued thumbnails, older requests are dropped */
+#define THUNAR_ICON_FACTORY_THUMBNAIL_MAX_QUEUE (256)
+
+#if GLIB_CHECK_VERSION (2, 32, 0)
+#define _thumbnail_lock(factory)   g_mutex_lock (&((factory)->thumbnail_lock))
+#define _thumbnail_unlock(factory) g_mutex_unlock (&((factory)->thumbnail_lock))
+#else
+#define _thumbnail_lock(factory)   g_mutex_lock ((factory)->thumbnail_lock)
+#define _thumbnail_unlock(factory) g_mutex_unlock ((factory)->thumbnail_lock)
+#endif
+
+/* size of a pixbuf in memory */
+#define THUNAR_ICON_PIXBUF_SIZE(pixbuf) ((gsize) gdk_pixbuf_get_rowstride (pixbuf) * gdk_pixbuf_get_height (pixbuf))
+
 
 
 /* Property identifiers */
@@ -51,11 +69,14 @@ enum
   PROP_THUMBNAIL_MODE,
   PROP_THUMBNAIL_DRAW_FRAMES,
   PROP_THUMBNAIL_SIZE,
+  PROP_CACHE_SIZE,
 };
 
 
 
-typedef struct _ThunarIconKey ThunarIconKey;
+typedef struct _ThunarIconKey     ThunarIconKey;
+typedef struct _ThunarIconRequest ThunarIconRequest;
+typedef struct _ThunarIconStore   ThunarIconStore;
 
 
 
@@ -88,6 +109,29 @@ static gboolean   thunar_icon_key_equal                     (gconstpointer
 static void       thunar_icon_key_free                      (gpointer                  data);
 static GdkPixbuf *thunar_icon_factory_load_fallback         (ThunarIconFactory        *factory,
                                                              gint                      size);
+static void       thunar_icon_factory_queue_thumbnail       (ThunarIconFactory        *factory,
+                                                             ThunarFile               *file,
+                                                             ThunarFileIconState       icon_state,
+                                                             gint                      icon_size);
+static void       thunar_icon_factory_thumbnail_worker      (gpointer                  data,
+                                                             gpointer                  user_data);
+static gboolean   thunar_icon_factory_thumbnail_results     (gpointer                  user_data);
+static void       thunar_icon_request_free                  (ThunarIconRequest        *request);
+static void       thunar_icon_factory_store_icon            (ThunarIconFactory        *factory,
+                                                             ThunarFile               *file,
+                                                             ThunarFileIconState       icon_state,
+                                                             ThunarFileThumbState      thumb_state,
+                                                             gint                      icon_size,
+                                                             GdkPixbuf                *icon,
+                                                             gboolean                  shared);
+static void       thunar_icon_factory_release_store         (ThunarIconFactory        *factory,
+                                                             ThunarIconStore          *store);
+static void       thunar_icon_factory_trim_stores           (ThunarIconFactory        *factory);
+static GdkPixbuf *thunar_icon_factory_load_file_icon_real   (ThunarIconFactory        *factory,
+                                                             ThunarFile               *file,
+                                                             ThunarFileIconState       icon_state,
+                                                             gint                      icon_size,
+                                                             gboolean                  wait_for_thumbnail);
 
 
 
@@ -118,6 +162,40 @@ struct _ThunarIconFactory
 
   /* stamp that gets bumped when the theme changes */
   guint                theme_stamp;
+
+  /* thumbnails are decoded and scaled in the background, requests
+   * are queued most recent first, since those are the visible rows.
+   * the lock protects the queue, the results, the idle id and the
+   * visible stamps */
+  GThreadPool         *thumbnail_pool;
+  GQueue               thumbnail_queue;
+  GSList              *thumbnail_results;
+  guint                thumbnail_idle_id;
+  guint                visible_stamp;
+#if GLIB_CHECK_VERSION (2, 32, 0)
+  GMutex               thumbnail_lock;
+#else
+  GMutex              *thumbnail_lock;
+#endif
+
+  /* ThunarFile -> the last ThunarIconRequest for the file */
+  GHashTable          *thumbnail_requests;
+
+  /* the icons stored on the files, most recently used first. only
+   * pixbufs that are not shared with the icon cache count against
+   * the budget */
+  GQueue               store_lru;
+  gsize                store_size;
+  guint                cache_size;
+
+  /* number of stores whose file was finalized, they are
+   * released in thunar_icon_factory_trim_stores() */
+  volatile gint        n_dead_stores;
+
+  /* statistics for the stored file icons */
+  guint                n_hits;
+  guint                n_misses;
+  guint                n_evictions;
 };
 
 struct _ThunarIconKey
@@ -126,15 +204,44 @@ struct _ThunarIconKey
   gint   size;
 };
 
-typedef struct
+struct _ThunarIconRequest
 {
+  ThunarFile           *file;
+  gchar                *uri;
+  ThunarThumbnailSize   thumbnail_size;
   ThunarFileIconState   icon_state;
   ThunarFileThumbState  thumb_state;
   gint                  icon_size;
   guint                 stamp;
+
+  /* the visible stamp of the factory when the file was last
+   * drawn or reported visible */
+  guint                 visible_stamp;
+
+  /* the decoded thumbnail, set by the worker, or skipped if the
+   * request was dropped before it was decoded */
   GdkPixbuf            *icon;
-}
-ThunarIconStore;
+  gboolean              skipped;
+};
+
+struct _ThunarIconStore
+{
+  ThunarFileIconState   icon_state;
+  ThunarFileThumbState  thumb_state;
+  gint                  icon_size;
+  guint                 stamp;
+  GdkPixbuf            *icon;
+
+  /* link in the store_lru of the factory, the file owning the
+   * store and the number of bytes it accounts for */
+  GList                 lru;
+  ThunarIconFactory    *factory;
+  GWeakRef              file;
+  gsize                 size;
+
+  /* set when the store was removed from the file */
+  volatile gint         dead;
+};
 
 
 
@@ -217,6 +324,20 @@ thunar_icon_factory_class_init (ThunarIconFactoryClass *klass)
                                                       THUNAR_TYPE_THUMBNAIL_SIZE,
                                                       THUNAR_THUMBNAIL_SIZE_NORMAL,
                                                       EXO_PARAM_READWRITE));
+
+  /**
+   * ThunarIconFactory:cache-size:
+   *
+   * The maximum memory in megabytes used by thumbnails and
+   * other icons stored on the #ThunarFile<!---->s.
+   **/
+  g_object_class_install_property (gobject_class,
+                                   PROP_CACHE_SIZE,
+                                   g_param_spec_uint ("cache-size",
+                                                      "cache-size",
+                                                      "cache-size",
+                                                      1u, 4096u, 64u,
+                                                      EXO_PARAM_READWRITE));
 }
 
 
@@ -226,6 +347,7 @@ thunar_icon_factory_init (ThunarIconFactory *factory)
 {
   factory->thumbnail_mode = THUNAR_THUMBNAIL_MODE_ONLY_LOCAL;
   factory->thumbnail_size = THUNAR_THUMBNAIL_SIZE_NORMAL;
+  factory->cache_size = 64;
 
   /* connect emission hook for the "changed" signal on the GtkIconTheme class. We use the emission
    * hook way here, because that way we can make sure that the icon cache is definetly cleared
@@ -237,6 +359,15 @@ thunar_icon_factory_init (ThunarIconFactory *factory)
   /* allocate the hash table for the icon cache */
   factory->icon_cache = g_hash_table_new_full (thunar_icon_key_hash, thunar_icon_key_equal,
                                                thunar_icon_key_free, g_object_unref);
+
+  /* pending thumbnail requests, the pool is created on demand */
+  g_queue_init (&factory->thumbnail_queue);
+  factory->thumbnail_requests = g_hash_table_new (g_direct_hash, g_direct_equal);
+#if GLIB_CHECK_VERSION (2, 32, 0)
+  g_mutex_init (&factory->thumbnail_lock);
+#else
+  factory->thumbnail_lock = g_mutex_new ();
+#endif
 }
 
 
@@ -260,9 +391,38 @@ static void
 thunar_icon_factory_finalize (GObject *object)
 {
   ThunarIconFactory *factory = THUNAR_ICON_FACTORY (object);
+  GList             *lp;
+  GList             *lp_next;
 
   _thunar_return_if_fail (THUNAR_IS_ICON_FACTORY (factory));
 
+  /* drop the queued thumbnails and wait for the running workers */
+  if (factory->thumbnail_pool != NULL)
+    g_thread_pool_free (factory->thumbnail_pool, TRUE, TRUE);
+
+  /* release the requests that were not handled yet */
+  if (G_UNLIKELY (factory->thumbnail_idle_id != 0))
+    g_source_remove (factory->thumbnail_idle_id);
+  g_slist_free_full (factory->thumbnail_results, (GDestroyNotify) thunar_icon_request_free);
+  g_queue_foreach (&factory->thumbnail_queue, (GFunc) thunar_icon_request_free, NULL);
+  g_queue_clear (&factory->thumbnail_queue);
+  g_hash_table_destroy (factory->thumbnail_requests);
+#if GLIB_CHECK_VERSION (2, 32, 0)
+  g_mutex_clear (&factory->thumbnail_lock);
+#else
+  g_mutex_free (factory->thumbnail_lock);
+#endif
+
+  /* the stores stay on the files, but no longer belong to the factory */
+  for (lp = factory->store_lru.head; lp != NULL; lp = lp_next)
+    {
+      lp_next = lp->next;
+      if (g_atomic_int_get (&((ThunarIconStore *) lp->data)->dead))
+        thunar_icon_factory_release_store (factory, lp->data);
+      else
+        ((ThunarIconStore *) lp->data)->factory = NULL;
+    }
+
   /* clear the icon cache hash table */
   g_hash_table_destroy (factory->icon_cache);
 
@@ -310,6 +470,10 @@ thunar_icon_factory_get_property (GObject    *object,
       g_value_set_enum (value, factory->thumbnail_size);
       break;
 
+    case PROP_CACHE_SIZE:
+      g_value_set_uint (value, factory->cache_size);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -340,6 +504,11 @@ thunar_icon_factory_set_property (GObject      *object,
       factory->thumbnail_size = g_value_get_enum (value);
       break;
 
+    case PROP_CACHE_SIZE:
+      factory->cache_size = g_value_get_uint (value);
+      thunar_icon_factory_trim_stores (factory);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -386,6 +555,9 @@ thunar_icon_factory_sweep_timer (gpointer user_data)
 
 THUNAR_THREADS_ENTER
 
+  /* release the stores of finalized files, they may hold cached icons */
+  thunar_icon_factory_trim_stores (factory);
+
   /* ditch all icons whose ref_count is 1 */
   g_hash_table_foreach_remove (factory->icon_cache, (GHRFunc) thunar_icon_check_sweep, factory);
 
@@ -455,18 +627,23 @@ static GdkPixbuf*
 thunar_icon_factory_get_thumbnail_frame (void)
 {
   GInputStream *stream;
-  static GdkPixbuf *frame = NULL;
+  GdkPixbuf    *pixbuf = NULL;
+  static gsize  frame = 0;
 
-  if (G_LIKELY (frame != NULL))
-     return frame;
-
-  stream = g_resources_open_stream ("/org/xfce/thunar/thumbnail-frame.png", 0, NULL);
-  if (G_UNLIKELY (stream != NULL)) {
-    frame = gdk_pixbuf_new_from_stream (stream, NULL, NULL);
-    g_object_unref (stream);
-  }
+  /* thumbnails are framed by the workers, so load the frame only once */
+  if (g_once_init_enter (&frame))
+    {
+      stream = g_resources_open_stream ("/org/xfce/thunar/thumbnail-frame.png", 0, NULL);
+      if (G_UNLIKELY (stream != NULL)) {
+        pixbuf = gdk_pixbuf_new_from_stream (stream, NULL, NULL);
+        g_object_unref (stream);
+      }
+
+      /* g_once_init_leave() does not accept 0 */
+      g_once_init_leave (&frame, pixbuf != NULL ? (gsize) pixbuf : 1);
+    }
 
-  return frame;
+  return (frame != 1) ? (GdkPixbuf *) frame : NULL;
 }
 
 
@@ -666,10 +843,9 @@ thunar_icon_key_free (gpointer data)
 
 
 static void
-thunar_icon_store_free (gpointer data)
+thunar_icon_store_release (ThunarIconStore *store)
 {
-  ThunarIconStore *store = data;
-
+  g_weak_ref_clear (&store->file);
   if (store->icon != NULL)
     g_object_unref (store->icon);
   g_slice_free (ThunarIconStore, store);
@@ -677,6 +853,151 @@ thunar_icon_store_free (gpointer data)
 
 
 
+static void
+thunar_icon_store_free (gpointer data)
+{
+  ThunarIconStore *store = data;
+
+  /* this also runs when the file is finalized, which may happen in
+   * another thread, so only flag the store and leave the lru to the
+   * factory in the main thread */
+  if (G_LIKELY (store->factory != NULL))
+    {
+      g_atomic_int_set (&store->dead, TRUE);
+      g_atomic_int_inc (&store->factory->n_dead_stores);
+    }
+  else
+    {
+      thunar_icon_store_release (store);
+    }
+}
+
+
+
+static void
+thunar_icon_factory_store_icon (ThunarIconFactory   *factory,
+                                ThunarFile          *file,
+                                ThunarFileIconState  icon_state,
+                                ThunarFileThumbState thumb_state,
+                                gint                 icon_size,
+                                GdkPixbuf           *icon,
+                                gboolean             shared)
+{
+  ThunarIconStore *store;
+
+  /* we hold a reference on the file, so its previous store is still
+   * alive and can be released right here instead of by a full sweep */
+  store = g_object_steal_qdata (G_OBJECT (file), thunar_icon_factory_store_quark);
+  if (store != NULL)
+    {
+      if (store->factory == factory)
+        thunar_icon_factory_release_store (factory, store);
+      else
+        thunar_icon_store_free (store);
+    }
+
+  store = g_slice_new0 (ThunarIconStore);
+  store->icon_size = icon_size;
+  store->icon_state = icon_state;
+  store->stamp = factory->theme_stamp;
+  store->thumb_state = thumb_state;
+  store->icon = g_object_ref (icon);
+  store->factory = factory;
+  g_weak_ref_init (&store->file, file);
+
+  /* icons from the icon cache are shared by many files and already
+   * kept alive by the cache, so only count private pixbufs */
+  if (!shared)
+    store->size = THUNAR_ICON_PIXBUF_SIZE (icon);
+
+  /* the store is flagged dead once the file is finalized */
+  g_object_set_qdata_full (G_OBJECT (file), thunar_icon_factory_store_quark,
+                           store, thunar_icon_store_free);
+
+  store->lru.data = store;
+  g_queue_push_head_link (&factory->store_lru, &store->lru);
+  factory->store_size += store->size;
+
+  thunar_icon_factory_trim_stores (factory);
+}
+
+
+
+static void
+thunar_icon_factory_release_store (ThunarIconFactory *factory,
+                                   ThunarIconStore   *store)
+{
+  /* remove the store from the factory's lru */
+  g_queue_unlink (&factory->store_lru, &store->lru);
+  factory->store_size -= store->size;
+
+  thunar_icon_store_release (store);
+}
+
+
+
+static void
+thunar_icon_factory_trim_stores (ThunarIconFactory *factory)
+{
+  ThunarIconStore *store;
+  ThunarFile      *file;
+  GList           *lp;
+  GList           *lp_prev;
+  gsize            max_size = (gsize) factory->cache_size * 1024 * 1024;
+
+  /* release the stores that were removed from their files */
+  if (g_atomic_int_get (&factory->n_dead_stores) > 0)
+    {
+      for (lp = factory->store_lru.tail; lp != NULL; lp = lp_prev)
+        {
+          lp_prev = lp->prev;
+          store = lp->data;
+
+          if (g_atomic_int_get (&store->dead))
+            {
+              thunar_icon_factory_release_store (factory, store);
+              g_atomic_int_add (&factory->n_dead_stores, -1);
+            }
+        }
+    }
+
+  /* drop the least recently used icons until we are below the budget,
+   * but always keep the icon that was used last */
+  for (lp = factory->store_lru.tail;
+       lp != NULL && lp != factory->store_lru.head && factory->store_size > max_size;
+       lp = lp_prev)
+    {
+      lp_prev = lp->prev;
+      store = lp->data;
+
+      /* shared icons don't count against the budget, so dropping
+       * them would only throw away cached icons */
+      if (store->size == 0)
+        continue;
+
+      /* skip files that are being finalized, the next run releases their store */
+      file = g_weak_ref_get (&store->file);
+      if (file == NULL)
+        continue;
+
+      /* take the store from the file, so we can release it right here */
+      if (!g_atomic_int_get (&store->dead))
+        {
+          g_object_steal_qdata (G_OBJECT (file), thunar_icon_factory_store_quark);
+          factory->n_evictions++;
+        }
+      else
+        {
+          g_atomic_int_add (&factory->n_dead_stores, -1);
+        }
+
+      thunar_icon_factory_release_store (factory, store);
+      g_object_unref (file);
+    }
+}
+
+
+
 static GdkPixbuf*
 thunar_icon_factory_load_fallback (ThunarIconFactory *factory,
                                    gint               size)
@@ -754,6 +1075,8 @@ thunar_icon_factory_get_for_icon_theme (GtkIconTheme *icon_theme)
       factory->preferences = thunar_preferences_get ();
       exo_binding_new (G_OBJECT (factory->preferences), "misc-thumbnail-mode",
                        G_OBJECT (factory), "thumbnail-mode");
+      exo_binding_new (G_OBJECT (factory->preferences), "misc-icon-cache-size",
+                       G_OBJECT (factory), "cache-size");
     }
   else
     {
@@ -850,23 +1173,173 @@ thunar_icon_factory_load_icon (ThunarIconFactory        *factory,
 
 
 
-/**
- * thunar_icon_factory_load_file_icon:
- * @factory    : a #ThunarIconFactory instance.
- * @file       : a #ThunarFile.
- * @icon_state : the desired icon state.
- * @icon_size  : the desired icon size.
- *
- * The caller is responsible to free the returned object using
- * g_object_unref() when no longer needed.
- *
- * Return value: the #GdkPixbuf icon.
- **/
-GdkPixbuf*
-thunar_icon_factory_load_file_icon (ThunarIconFactory  *factory,
-                                    ThunarFile         *file,
-                                    ThunarFileIconState icon_state,
-                                    gint                icon_size)
+static void
+thunar_icon_request_free (ThunarIconRequest *request)
+{
+  if (request->icon != NULL)
+    g_object_unref (G_OBJECT (request->icon));
+  g_object_unref (G_OBJECT (request->file));
+  g_free (request->uri);
+  g_slice_free (ThunarIconRequest, request);
+}
+
+
+
+static void
+thunar_icon_factory_queue_thumbnail (ThunarIconFactory  *factory,
+                                     ThunarFile         *file,
+                                     ThunarFileIconState icon_state,
+                                     gint                icon_size)
+{
+  ThunarIconRequest *request;
+
+  /* check if the thumbnail is already being loaded */
+  request = g_hash_table_lookup (factory->thumbnail_requests, file);
+  if (request != NULL
+      && request->icon_state == icon_state
+      && request->icon_size == icon_size
+      && request->stamp == factory->theme_stamp
+      && request->thumb_state == thunar_file_get_thumb_state (file))
+    return;
+
+  if (G_UNLIKELY (factory->thumbnail_pool == NULL))
+    {
+      factory->thumbnail_pool = g_thread_pool_new (thunar_icon_factory_thumbnail_worker, factory,
+                                                   THUNAR_ICON_FACTORY_THUMBNAIL_THREADS, FALSE, NULL);
+    }
+
+  request = g_slice_new0 (ThunarIconRequest);
+  request->file = g_object_ref (G_OBJECT (file));
+  request->uri = thunar_file_dup_uri (file);
+  request->thumbnail_size = factory->thumbnail_size;
+  request->icon_state = icon_state;
+  request->thumb_state = thunar_file_get_thumb_state (file);
+  request->icon_size = icon_size;
+  request->stamp = factory->theme_stamp;
+
+  /* a previous request for the file is ignored when it finishes */
+  g_hash_table_replace (factory->thumbnail_requests, file, request);
+
+  /* the rows that were drawn last are the ones on screen, so they come first.
+   * the oldest requests are dropped when the queue is full, they are handed
+   * back as skipped, so a row that is still visible queues them again */
+  _thumbnail_lock (factory);
+  request->visible_stamp = factory->visible_stamp;
+  g_queue_push_head (&factory->thumbnail_queue, request);
+  if (g_queue_get_length (&factory->thumbnail_queue) > THUNAR_ICON_FACTORY_THUMBNAIL_MAX_QUEUE)
+    {
+      request = g_queue_pop_tail (&factory->thumbnail_queue);
+      request->skipped = TRUE;
+      factory->thumbnail_results = g_slist_prepend (factory->thumbnail_results, request);
+      if (factory->thumbnail_idle_id == 0)
+        factory->thumbnail_idle_id = g_idle_add (thunar_icon_factory_thumbnail_results, factory);
+    }
+  _thumbnail_unlock (factory);
+
+  /* wake up a worker, it picks the most recent request */
+  g_thread_pool_push (factory->thumbnail_pool, factory, NULL);
+}
+
+
+
+static void
+thunar_icon_factory_thumbnail_worker (gpointer data,
+                                      gpointer user_data)
+{
+  ThunarIconFactory *factory = THUNAR_ICON_FACTORY (user_data);
+  ThunarIconRequest *request;
+  gchar             *thumbnail_path;
+
+  _thumbnail_lock (factory);
+  request = g_queue_pop_head (&factory->thumbnail_queue);
+
+  /* files that were not reported visible since the request was queued
+   * were scrolled away, don't spend time on decoding their thumbnails */
+  if (request != NULL)
+    request->skipped = (request->visible_stamp != factory->visible_stamp);
+  _thumbnail_unlock (factory);
+
+  /* the queue was cleared */
+  if (request == NULL)
+    return;
+
+  /* lookup, decode and scale the thumbnail */
+  thumbnail_path = request->skipped ? NULL : thunar_file_find_thumbnail_path (request->uri, request->thumbnail_size);
+  if (thumbnail_path != NULL)
+    {
+      request->icon = thunar_icon_factory_load_from_file (factory, thumbnail_path, request->icon_size);
+      g_free (thumbnail_path);
+    }
+
+  /* hand the request back to the main thread, objects are only released there */
+  _thumbnail_lock (factory);
+  factory->thumbnail_results = g_slist_prepend (factory->thumbnail_results, request);
+  if (factory->thumbnail_idle_id == 0)
+    factory->thumbnail_idle_id = g_idle_add (thunar_icon_factory_thumbnail_results, factory);
+  _thumbnail_unlock (factory);
+}
+
+
+
+static gboolean
+thunar_icon_factory_thumbnail_results (gpointer user_data)
+{
+  ThunarIconFactory *factory = THUNAR_ICON_FACTORY (user_data);
+  ThunarIconRequest *request;
+  GSList            *results;
+  GSList            *lp;
+
+  _thumbnail_lock (factory);
+  results = factory->thumbnail_results;
+  factory->thumbnail_results = NULL;
+  factory->thumbnail_idle_id = 0;
+  _thumbnail_unlock (factory);
+
+  for (lp = results; lp != NULL; lp = lp->next)
+    {
+      request = lp->data;
+
+      /* ignore requests that were superseded in the meantime */
+      if (g_hash_table_lookup (factory->thumbnail_requests, request->file) != request)
+        continue;
+
+      g_hash_table_remove (factory->thumbnail_requests, request->file);
+
+      /* let the views draw the file again, if it is still visible
+       * somewhere, the thumbnail is queued again */
+      if (request->skipped)
+        {
+          thunar_file_monitor_file_changed (request->file);
+          continue;
+        }
+
+      /* without a thumbnail, the file keeps its themed icon */
+      if (request->icon == NULL
+          || request->stamp != factory->theme_stamp
+          || request->thumb_state != thunar_file_get_thumb_state (request->file))
+        continue;
+
+      thunar_icon_factory_store_icon (factory, request->file, request->icon_state,
+                                      request->thumb_state, request->icon_size,
+                                      request->icon, FALSE);
+
+      /* redraw the file with its thumbnail */
+      thunar_file_monitor_file_changed (request->file);
+    }
+
+  g_slist_free_full (results, (GDestroyNotify) thunar_icon_request_free);
+
+  return FALSE;
+}
+
+
+
+static GdkPixbuf*
+thunar_icon_factory_load_file_icon_real (ThunarIconFactory  *factory,
+                                         ThunarFile         *file,
+                                         ThunarFileIconState icon_state,
+                                         gint                icon_size,
+                                         gboolean            wait_for_thumbnail)
 {
   GInputStream    *stream;
   GtkIconInfo     *icon_info;
@@ -876,6 +1349,7 @@ thunar_icon_factory_load_file_icon (ThunarIconFactory  *factory,
   const gchar     *icon_name;
   const gchar     *custom_icon;
   ThunarIconStore *store;
+  gboolean         shared = FALSE;
 
   _thunar_return_val_if_fail (THUNAR_IS_ICON_FACTORY (factory), NULL);
   _thunar_return_val_if_fail (THUNAR_IS_FILE (file), NULL);
@@ -887,11 +1361,19 @@ thunar_icon_factory_load_file_icon (ThunarIconFactory  *factory,
       && store->icon_state == icon_state
       && store->icon_size == icon_size
       && store->stamp == factory->theme_stamp
-      && store->thumb_state == thunar_file_get_thumb_state (file))
+      && store->thumb_state == thunar_file_get_thumb_state (file)
+      && store->factory == factory)
     {
+      /* move the icon to the front of the lru */
+      g_queue_unlink (&factory->store_lru, &store->lru);
+      g_queue_push_head_link (&factory->store_lru, &store->lru);
+      factory->n_hits++;
+
       return g_object_ref (store->icon);
     }
 
+  factory->n_misses++;
+
   /* check if we have a custom icon for this file */
   custom_icon = thunar_file_get_custom_icon (file);
   if (custom_icon != NULL)
@@ -952,7 +1434,7 @@ thunar_icon_factory_load_file_icon (ThunarIconFactory  *factory,
           if (icon != NULL)
             return icon;
         }
-      else
+      else if (wait_for_thumbnail)
         {
           /* we have no preview icon but the thumbnail should be ready. determine
            * the filename of the thumbnail */
@@ -965,6 +1447,12 @@ thunar_icon_factory_load_file_icon (ThunarIconFactory  *factory,
               icon = thunar_icon_factory_load_from_file (factory, thumbnail_path, icon_size);
             }
         }
+      else
+        {
+          /* decode the thumbnail in the background, the
+           * themed icon is used until it is ready */
+          thunar_icon_factory_queue_thumbnail (factory, file, icon_state, icon_size);
+        }
     }
 
   /* lookup the icon name for the icon in the given state and load the icon */
@@ -972,19 +1460,14 @@ thunar_icon_factory_load_file_icon (ThunarIconFactory  *factory,
     {
       icon_name = thunar_file_get_icon_name (file, icon_state, factory->icon_theme);
       icon = thunar_icon_factory_load_icon (factory, icon_name, icon_size, TRUE);
+      shared = TRUE;
     }
 
   if (G_LIKELY (icon != NULL))
     {
-      store = g_slice_new (ThunarIconStore);
-      store->icon_size = icon_size;
-      store->icon_state = icon_state;
-      store->stamp = factory->theme_stamp;
-      store->thumb_state = thunar_file_get_thumb_state (file);
-      store->icon = g_object_ref (icon);
-
-      g_object_set_qdata_full (G_OBJECT (file), thunar_icon_factory_store_quark,
-                               store, thunar_icon_store_free);
+      thunar_icon_factory_store_icon (factory, file, icon_state,
+                                      thunar_file_get_thumb_state (file),
+                                      icon_size, icon, shared);
     }
 
   return icon;
@@ -992,6 +1475,145 @@ thunar_icon_factory_load_file_icon (ThunarIconFactory  *factory,
 
 
 
+/**
+ * thunar_icon_factory_load_file_icon:
+ * @factory    : a #ThunarIconFactory instance.
+ * @file       : a #ThunarFile.
+ * @icon_state : the desired icon state.
+ * @icon_size  : the desired icon size.
+ *
+ * The caller is responsible to free the returned object using
+ * g_object_unref() when no longer needed.
+ *
+ * Return value: the #GdkPixbuf icon.
+ **/
+GdkPixbuf*
+thunar_icon_factory_load_file_icon (ThunarIconFactory  *factory,
+                                    ThunarFile         *file,
+                                    ThunarFileIconState icon_state,
+                                    gint                icon_size)
+{
+  return thunar_icon_factory_load_file_icon_real (factory, file, icon_state, icon_size, TRUE);
+}
+
+
+
+/**
+ * thunar_icon_factory_peek_file_icon:
+ * @factory    : a #ThunarIconFactory instance.
+ * @file       : a #ThunarFile.
+ * @icon_state : the desired icon state.
+ * @icon_size  : the desired icon size.
+ *
+ * Like thunar_icon_factory_load_file_icon(), but does not block on
+ * loading the thumbnail of @file. The thumbnail is decoded in the
+ * background and the themed icon is returned meanwhile; @file is
+ * marked as changed once the thumbnail is ready. Meant to be used
+ * when drawing cells.
+ *
+ * The caller is responsible to free the returned object using
+ * g_object_unref() when no longer needed.
+ *
+ * Return value: the #GdkPixbuf icon.
+ **/
+GdkPixbuf*
+thunar_icon_factory_peek_file_icon (ThunarIconFactory  *factory,
+                                    ThunarFile         *file,
+                                    ThunarFileIconState icon_state,
+                                    gint                icon_size)
+{
+  return thunar_icon_factory_load_file_icon_real (factory, file, icon_state, icon_size, FALSE);
+}
+
+
+
+/**
+ * thunar_icon_factory_prefetch_icons:
+ * @factory   : a #ThunarIconFactory instance.
+ * @files     : a #GList of #ThunarFile<!---->s.
+ * @drop_file : the file currently drawn as drop target or %NULL.
+ * @icon_size : the icon size used to draw the @files.
+ *
+ * Hint from a view that @files are visible at @icon_size. The
+ * icons of @files are moved to the front of the cache, so they
+ * are not dropped in favor of icons that are off screen, and
+ * thumbnails that are not loaded yet are queued for decoding.
+ * Queued thumbnails of files that are no longer visible are
+ * skipped.
+ * The icons are looked up in the state the view draws them in.
+ **/
+void
+thunar_icon_factory_prefetch_icons (ThunarIconFactory *factory,
+                                    GList             *files,
+                                    ThunarFile        *drop_file,
+                                    gint               icon_size)
+{
+  ThunarFileIconState icon_state;
+  ThunarIconRequest  *request;
+  GdkPixbuf          *icon;
+  GList              *lp;
+
+  _thunar_return_if_fail (THUNAR_IS_ICON_FACTORY (factory));
+  _thunar_return_if_fail (drop_file == NULL || THUNAR_IS_FILE (drop_file));
+  _thunar_return_if_fail (icon_size > 0);
+
+  /* start a new visible range, queued thumbnails of files
+   * that are not in it anymore are skipped by the workers */
+  _thumbnail_lock (factory);
+  factory->visible_stamp++;
+  for (lp = files; lp != NULL; lp = lp->next)
+    {
+      request = g_hash_table_lookup (factory->thumbnail_requests, lp->data);
+      if (request != NULL)
+        request->visible_stamp = factory->visible_stamp;
+    }
+  _thumbnail_unlock (factory);
+
+  for (lp = files; lp != NULL; lp = lp->next)
+    {
+      /* same as the icon renderer, the views have no expanded rows */
+      icon_state = (lp->data != drop_file) ? THUNAR_FILE_ICON_STATE_DEFAULT : THUNAR_FILE_ICON_STATE_DROP;
+      icon = thunar_icon_factory_peek_file_icon (factory, lp->data, icon_state, icon_size);
+      if (G_LIKELY (icon != NULL))
+        g_object_unref (G_OBJECT (icon));
+    }
+}
+
+
+
+/**
+ * thunar_icon_factory_get_statistics:
+ * @factory     : a #ThunarIconFactory instance.
+ * @n_hits      : return location for the number of cache hits or %NULL.
+ * @n_misses    : return location for the number of cache misses or %NULL.
+ * @n_evictions : return location for the number of evicted icons or %NULL.
+ * @n_bytes     : return location for the memory used by the cache or %NULL.
+ *
+ * Returns the statistics of the icons stored on the files by @factory.
+ * The memory only includes thumbnails and other pixbufs that are not
+ * shared with the icon theme cache.
+ **/
+void
+thunar_icon_factory_get_statistics (ThunarIconFactory *factory,
+                                    guint             *n_hits,
+                                    guint             *n_misses,
+                                    guint             *n_evictions,
+                                    gsize             *n_bytes)
+{
+  _thunar_return_if_fail (THUNAR_IS_ICON_FACTORY (factory));
+
+  if (n_hits != NULL)
+    *n_hits = factory->n_hits;
+  if (n_misses != NULL)
+    *n_misses = factory->n_misses;
+  if (n_evictions != NULL)
+    *n_evictions = factory->n_evictions;
+  if (n_bytes != NULL)
+    *n_bytes = factory->store_size;
+}
+
+
+
 /**
  * thunar_icon_factory_clear_pixmap_cache:
  * @file : a #ThunarFile.
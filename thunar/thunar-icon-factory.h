@@ -53,6 +53,21 @@ GdkPixbuf             *thunar_icon_factory_load_file_icon     (ThunarIconFactory
                                                                ThunarFile               *file,
                                                                ThunarFileIconState       icon_state,
                                                                gint                      icon_size);
+GdkPixbuf             *thunar_icon_factory_peek_file_icon     (ThunarIconFactory        *factory,
+                                                               ThunarFile               *file,
+                                                               ThunarFileIconState       icon_state,
+                                                               gint                      icon_size);
+
+void                   thunar_icon_factory_prefetch_icons     (ThunarIconFactory        *factory,
+                                                               GList                    *files,
+                                                               ThunarFile               *drop_file,
+                                                               gint                      icon_size);
+
+void                   thunar_icon_factory_get_statistics     (ThunarIconFactory        *factory,
+                                                               guint                    *n_hits,
+                                                               guint                    *n_misses,
+                                                               guint                    *n_evictions,
+                                                               gsize                    *n_bytes);
 
 void                   thunar_icon_factory_clear_pixmap_cache (ThunarFile               *file);
 
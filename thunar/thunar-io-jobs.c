@@ -31,6 +31,7 @@
 #include <thunar/thunar-io-jobs.h>
 #include <thunar/thunar-io-jobs-util.h>
 #include <thunar/thunar-job.h>
+#include <thunar/thunar-preferences.h>
 #include <thunar/thunar-private.h>
 #include <thunar/thunar-simple-job.h>
 #include <thunar/thunar-thumbnail-cache.h>
@@ -38,47 +39,157 @@
 
 
 
-static GList *
-_tij_collect_nofollow (ThunarJob *job,
-                       GList     *base_file_list,
-                       gboolean   unlinking,
-                       GError   **error)
+typedef gboolean (*TijWalkFunc) (ThunarJob *job,
+                                 GFile     *file,
+                                 gpointer   user_data,
+                                 GError   **error);
+
+
+
+static gboolean
+_tij_walk_nofollow (ThunarJob   *job,
+                    GFile       *file,
+                    GFileType    file_type,
+                    gboolean     unlinking,
+                    TijWalkFunc  func,
+                    gpointer     user_data,
+                    GError     **error)
+{
+  GFileEnumerator *enumerator;
+  GFileInfo       *info;
+  GError          *err = NULL;
+  GFile           *child;
+
+  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
+  _thunar_return_val_if_fail (G_IS_FILE (file), FALSE);
+  _thunar_return_val_if_fail (func != NULL, FALSE);
+  _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  /* abort if the job was cancelled */
+  if (exo_job_set_error_if_cancelled (EXO_JOB (job), error))
+    return FALSE;
+
+  /* query the file type unless we got it from the parent */
+  if (file_type == G_FILE_TYPE_UNKNOWN)
+    {
+      file_type = g_file_query_file_type (file, G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                          exo_job_get_cancellable (EXO_JOB (job)));
+    }
+
+  /* don't recurse when we are unlinking and the current dir is in the
+   * trash. In GVfs, only the top-level directories in the trash can be
+   * modified and deleted directly. See
+   * http://bugzilla.xfce.org/show_bug.cgi?id=7147
+   * for more information */
+  if (file_type == G_FILE_TYPE_DIRECTORY
+      && !(unlinking && thunar_g_file_is_trashed (file) && !thunar_g_file_is_root (file)))
+    {
+      enumerator = g_file_enumerate_children (file,
+                                              G_FILE_ATTRIBUTE_STANDARD_TYPE ","
+                                              G_FILE_ATTRIBUTE_STANDARD_NAME,
+                                              G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                              exo_job_get_cancellable (EXO_JOB (job)),
+                                              &err);
+
+      if (enumerator != NULL)
+        {
+          /* process the children before the directory itself, only
+           * the enumerators of the parent directories are kept open */
+          while (err == NULL)
+            {
+              info = g_file_enumerator_next_file (enumerator,
+                                                  exo_job_get_cancellable (EXO_JOB (job)),
+                                                  &err);
+              if (info == NULL)
+                break;
+
+              child = g_file_get_child (file, g_file_info_get_name (info));
+              _tij_walk_nofollow (job, child, g_file_info_get_file_type (info),
+                                  unlinking, func, user_data, &err);
+              g_object_unref (child);
+              g_object_unref (info);
+            }
+
+          g_object_unref (enumerator);
+        }
+    }
+
+  /* process the file itself */
+  if (err == NULL && !exo_job_set_error_if_cancelled (EXO_JOB (job), &err))
+    func (job, file, user_data, &err);
+
+  if (G_UNLIKELY (err != NULL))
+    {
+      g_propagate_error (error, err);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+
+
+static gboolean
+_tij_walk_count (ThunarJob *job,
+                 GFile     *file,
+                 gpointer   user_data,
+                 GError   **error)
+{
+  guint *n_files = user_data;
+
+  *n_files += 1;
+
+  return TRUE;
+}
+
+
+
+static gboolean
+_tij_walk_file_list (ThunarJob   *job,
+                     GList       *file_list,
+                     gboolean     recursive,
+                     gboolean     unlinking,
+                     TijWalkFunc  func,
+                     gpointer     user_data,
+                     GError     **error)
 {
   GError *err = NULL;
-  GList  *child_file_list = NULL;
-  GList  *file_list = NULL;
   GList  *lp;
+  guint   n_files = 0;
 
-  /* recursively collect the files */
-  for (lp = base_file_list;
-       err == NULL && lp != NULL && !exo_job_is_cancelled (EXO_JOB (job));
-       lp = lp->next)
+  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
+  _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  /* count the files first, we only keep a counter for the progress */
+  if (recursive)
     {
-      /* try to scan the directory */
-      child_file_list = thunar_io_scan_directory (job, lp->data,
-                                                  G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
-                                                  TRUE, unlinking, FALSE, &err);
-
-      /* prepend the new files to the existing list */
-      file_list = thunar_g_file_list_prepend (file_list, lp->data);
-      file_list = g_list_concat (child_file_list, file_list);
+      for (lp = file_list; err == NULL && lp != NULL; lp = lp->next)
+        _tij_walk_nofollow (job, lp->data, G_FILE_TYPE_UNKNOWN, unlinking, _tij_walk_count, &n_files, &err);
     }
-
-  /* check if we failed */
-  if (err != NULL || exo_job_is_cancelled (EXO_JOB (job)))
+  else
     {
-      if (exo_job_set_error_if_cancelled (EXO_JOB (job), error))
-        g_error_free (err);
-      else
-        g_propagate_error (error, err);
+      n_files = g_list_length (file_list);
+    }
 
-      /* release the collected files */
-      thunar_g_file_list_free (file_list);
+  /* we know the total amount of files to process */
+  thunar_job_set_total_files (job, n_files);
 
-      return NULL;
+  /* process the files while walking the tree again */
+  for (lp = file_list; err == NULL && lp != NULL; lp = lp->next)
+    {
+      if (recursive)
+        _tij_walk_nofollow (job, lp->data, G_FILE_TYPE_UNKNOWN, unlinking, func, user_data, &err);
+      else if (!exo_job_set_error_if_cancelled (EXO_JOB (job), &err))
+        func (job, lp->data, user_data, &err);
     }
 
-  return file_list;
+  if (G_UNLIKELY (err != NULL))
+    {
+      g_propagate_error (error, err);
+      return FALSE;
+    }
+
+  return TRUE;
 }
 
 
@@ -109,7 +220,7 @@ _thunar_io_jobs_create (ThunarJob  *job,
   template_file = g_value_get_object (&g_array_index (param_values, GValue, 1));
 
   /* we know the total amount of files to be processed */
-  thunar_job_set_total_files (THUNAR_JOB (job), file_list);
+  thunar_job_set_total_files (THUNAR_JOB (job), g_list_length (file_list));
 
   /* check if we need to open the template */
   if (template_file != NULL)
@@ -131,7 +242,7 @@ _thunar_io_jobs_create (ThunarJob  *job,
       g_assert (G_IS_FILE (lp->data));
 
       /* update progress information */
-      thunar_job_processing_file (THUNAR_JOB (job), lp);
+      thunar_job_processing_file (THUNAR_JOB (job), lp->data);
 
 again:
       /* try to create the file */
@@ -281,7 +392,7 @@ _thunar_io_jobs_mkdir (ThunarJob  *job,
   file_list = g_value_get_boxed (&g_array_index (param_values, GValue, 0));
 
   /* we know the total list of files to process */
-  thunar_job_set_total_files (THUNAR_JOB (job), file_list);
+  thunar_job_set_total_files (THUNAR_JOB (job), g_list_length (file_list));
 
   for (lp = file_list;
        err == NULL && lp != NULL && !exo_job_is_cancelled (EXO_JOB (job));
@@ -290,7 +401,7 @@ _thunar_io_jobs_mkdir (ThunarJob  *job,
       g_assert (G_IS_FILE (lp->data));
 
       /* update progress information */
-      thunar_job_processing_file (THUNAR_JOB (job), lp);
+      thunar_job_processing_file (THUNAR_JOB (job), lp->data);
 
 again:
       /* try to create the directory */
@@ -396,6 +507,85 @@ thunar_io_jobs_make_directories (GList *file_list)
 
 
 
+static gboolean
+_tij_unlink_file (ThunarJob *job,
+                  GFile     *file,
+                  gpointer   user_data,
+                  GError   **error)
+{
+  ThunarThumbnailCache *thumbnail_cache = THUNAR_THUMBNAIL_CACHE (user_data);
+  ThunarJobResponse     response;
+  GFileInfo            *info;
+  GError               *err = NULL;
+  gchar                *base_name;
+  gchar                *display_name;
+
+  /* skip root folders which cannot be deleted anyway */
+  if (thunar_g_file_is_root (file))
+    return TRUE;
+
+  /* update progress information */
+  thunar_job_processing_file (THUNAR_JOB (job), file);
+
+again:
+  /* try to delete the file */
+  if (g_file_delete (file, exo_job_get_cancellable (EXO_JOB (job)), &err))
+    {
+      /* notify the thumbnail cache that the corresponding thumbnail can also
+       * be deleted now */
+      thunar_thumbnail_cache_delete_file (thumbnail_cache, file);
+    }
+  else
+    {
+      /* query the file info for the display name */
+      info = g_file_query_info (file,
+                                G_FILE_ATTRIBUTE_STANDARD_DISPLAY_NAME,
+                                G_FILE_QUERY_INFO_NONE,
+                                exo_job_get_cancellable (EXO_JOB (job)),
+                                NULL);
+
+      /* abort if the job was cancelled */
+      if (exo_job_is_cancelled (EXO_JOB (job)))
+        {
+          if (info != NULL)
+            g_object_unref (info);
+          g_clear_error (&err);
+          exo_job_set_error_if_cancelled (EXO_JOB (job), error);
+          return FALSE;
+        }
+
+      /* determine the display name, using the basename as a fallback */
+      if (info != NULL)
+        {
+          display_name = g_strdup (g_file_info_get_display_name (info));
+          g_object_unref (info);
+        }
+      else
+        {
+          base_name = g_file_get_basename (file);
+          display_name = g_filename_display_name (base_name);
+          g_free (base_name);
+        }
+
+      /* ask the user whether he wants to skip this file */
+      response = thunar_job_ask_skip (THUNAR_JOB (job),
+                                      _("Could not delete file \"%s\": %s"),
+                                      display_name, err->message);
+      g_free (display_name);
+
+      /* clear the error */
+      g_clear_error (&err);
+
+      /* check whether to retry */
+      if (response == THUNAR_JOB_RESPONSE_RETRY)
+        goto again;
+    }
+
+  return TRUE;
+}
+
+
+
 static gboolean
 _thunar_io_jobs_unlink (ThunarJob  *job,
                         GArray     *param_values,
@@ -403,13 +593,8 @@ _thunar_io_jobs_unlink (ThunarJob  *job,
 {
   ThunarThumbnailCache *thumbnail_cache;
   ThunarApplication    *application;
-  ThunarJobResponse     response;
-  GFileInfo            *info;
   GError               *err = NULL;
   GList                *file_list;
-  GList                *lp;
-  gchar                *base_name;
-  gchar                *display_name;
 
   _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
   _thunar_return_val_if_fail (param_values != NULL, FALSE);
@@ -422,103 +607,28 @@ _thunar_io_jobs_unlink (ThunarJob  *job,
   /* tell the user that we're preparing to unlink the files */
   exo_job_info_message (EXO_JOB (job), _("Preparing..."));
 
-  /* recursively collect files for removal, not following any symlinks */
-  file_list = _tij_collect_nofollow (job, file_list, TRUE, &err);
-
-  /* free the file list and fail if there was an error or the job was cancelled */
-  if (err != NULL || exo_job_is_cancelled (EXO_JOB (job)))
-    {
-      if (exo_job_set_error_if_cancelled (EXO_JOB (job), error))
-        g_error_free (err);
-      else
-        g_propagate_error (error, err);
-
-      thunar_g_file_list_free (file_list);
-      return FALSE;
-    }
-
-  /* we know the total list of files to process */
-  thunar_job_set_total_files (THUNAR_JOB (job), file_list);
-
   /* take a reference on the thumbnail cache */
   application = thunar_application_get ();
   thumbnail_cache = thunar_application_get_thumbnail_cache (application);
   g_object_unref (application);
 
-  /* remove all the files */
-  for (lp = file_list; lp != NULL && !exo_job_is_cancelled (EXO_JOB (job)); lp = lp->next)
-    {
-      g_assert (G_IS_FILE (lp->data));
-
-      /* skip root folders which cannot be deleted anyway */
-      if (thunar_g_file_is_root (lp->data))
-        continue;
+  /* remove the files while walking the tree, not following any symlinks */
+  _tij_walk_file_list (job, file_list, TRUE, TRUE, _tij_unlink_file, thumbnail_cache, &err);
 
-      /* update progress information */
-      thunar_job_processing_file (THUNAR_JOB (job), lp);
+  /* release the thumbnail cache */
+  g_object_unref (thumbnail_cache);
 
-again:
-      /* try to delete the file */
-      if (g_file_delete (lp->data, exo_job_get_cancellable (EXO_JOB (job)), &err))
-        {
-          /* notify the thumbnail cache that the corresponding thumbnail can also
-           * be deleted now */
-          thunar_thumbnail_cache_delete_file (thumbnail_cache, lp->data);
-        }
+  if (err != NULL)
+    {
+      if (exo_job_set_error_if_cancelled (EXO_JOB (job), error))
+        g_error_free (err);
       else
-        {
-          /* query the file info for the display name */
-          info = g_file_query_info (lp->data,
-                                    G_FILE_ATTRIBUTE_STANDARD_DISPLAY_NAME,
-                                    G_FILE_QUERY_INFO_NONE,
-                                    exo_job_get_cancellable (EXO_JOB (job)),
-                                    NULL);
-
-          /* abort if the job was cancelled */
-          if (exo_job_is_cancelled (EXO_JOB (job)))
-            {
-              g_clear_error (&err);
-              break;
-            }
-
-          /* determine the display name, using the basename as a fallback */
-          if (info != NULL)
-            {
-              display_name = g_strdup (g_file_info_get_display_name (info));
-              g_object_unref (info);
-            }
-          else
-            {
-              base_name = g_file_get_basename (lp->data);
-              display_name = g_filename_display_name (base_name);
-              g_free (base_name);
-            }
-
-          /* ask the user whether he wants to skip this file */
-          response = thunar_job_ask_skip (THUNAR_JOB (job),
-                                          _("Could not delete file \"%s\": %s"),
-                                          display_name, err->message);
-          g_free (display_name);
-
-          /* clear the error */
-          g_clear_error (&err);
+        g_propagate_error (error, err);
 
-          /* check whether to retry */
-          if (response == THUNAR_JOB_RESPONSE_RETRY)
-            goto again;
-        }
+      return FALSE;
     }
 
-  /* release the thumbnail cache */
-  g_object_unref (thumbnail_cache);
-
-  /* release the file list */
-  thunar_g_file_list_free (file_list);
-
-  if (exo_job_set_error_if_cancelled (EXO_JOB (job), error))
-    return FALSE;
-  else
-    return TRUE;
+  return TRUE;
 }
 
 
@@ -718,7 +828,7 @@ _thunar_io_jobs_link (ThunarJob  *job,
   target_file_list = g_value_get_boxed (&g_array_index (param_values, GValue, 1));
 
   /* we know the total list of paths to process */
-  thunar_job_set_total_files (THUNAR_JOB (job), source_file_list);
+  thunar_job_set_total_files (THUNAR_JOB (job), g_list_length (source_file_list));
 
   /* take a reference on the thumbnail cache */
   application = thunar_application_get ();
@@ -734,7 +844,7 @@ _thunar_io_jobs_link (ThunarJob  *job,
       _thunar_assert (G_IS_FILE (tp->data));
 
       /* update progress information */
-      thunar_job_processing_file (THUNAR_JOB (job), sp);
+      thunar_job_processing_file (THUNAR_JOB (job), sp->data);
 
       /* try to create the symbolic link */
       real_target_file = _thunar_io_jobs_link_file (job, sp->data, tp->data, &err);
@@ -792,6 +902,105 @@ thunar_io_jobs_link_files (GList *source_file_list,
 
 
 
+/* maximum number of files trashed concurrently */
+#define TRASH_MAX_THREADS 4
+
+
+
+#if GLIB_CHECK_VERSION (2, 32, 0)
+#define _tij_trash_lock(data)       g_mutex_lock (&((data)->lock))
+#define _tij_trash_unlock(data)     g_mutex_unlock (&((data)->lock))
+#define _tij_trash_ask_lock(data)   g_mutex_lock (&((data)->ask_lock))
+#define _tij_trash_ask_unlock(data) g_mutex_unlock (&((data)->ask_lock))
+#else
+#define _tij_trash_lock(data)       g_mutex_lock ((data)->lock)
+#define _tij_trash_unlock(data)     g_mutex_unlock ((data)->lock)
+#define _tij_trash_ask_lock(data)   g_mutex_lock ((data)->ask_lock)
+#define _tij_trash_ask_unlock(data) g_mutex_unlock ((data)->ask_lock)
+#endif
+
+
+
+typedef struct
+{
+  ThunarJob *job;
+  GList     *trashed_files;
+
+  /* serializes the access to the trashed files and the skip dialogs */
+#if GLIB_CHECK_VERSION (2, 32, 0)
+  GMutex     lock;
+  GMutex     ask_lock;
+#else
+  GMutex    *lock;
+  GMutex    *ask_lock;
+#endif
+} TijTrashData;
+
+
+
+static void
+_tij_trash_file (gpointer data,
+                 gpointer user_data)
+{
+  TijTrashData     *trash_data = user_data;
+  ThunarJobResponse response;
+  ThunarJob        *job = trash_data->job;
+  GFile            *file = G_FILE (data);
+  GError           *err = NULL;
+  gchar            *base_name;
+  gchar            *display_name;
+
+  /* the remaining files are dropped once the job was cancelled */
+  if (exo_job_is_cancelled (EXO_JOB (job)))
+    {
+      g_object_unref (file);
+      return;
+    }
+
+  /* update progress information */
+  thunar_job_processing_file (job, file);
+
+again:
+  /* trash the file or folder */
+  if (g_file_trash (file, exo_job_get_cancellable (EXO_JOB (job)), &err))
+    {
+      /* remember the file for the thumbnail cache */
+      _tij_trash_lock (trash_data);
+      trash_data->trashed_files = g_list_prepend (trash_data->trashed_files,
+                                                  g_object_ref (file));
+      _tij_trash_unlock (trash_data);
+    }
+  else if (!exo_job_is_cancelled (EXO_JOB (job)))
+    {
+      /* determine display name of the file */
+      base_name = g_file_get_basename (file);
+      display_name = g_filename_display_basename (base_name);
+      g_free (base_name);
+
+      /* ask the user whether to skip/retry this file (cancels the job if not) */
+      _tij_trash_ask_lock (trash_data);
+      response = thunar_job_ask_skip (job,
+                                      _("Could not move \"%s\" to the trash: %s"),
+                                      display_name, err->message);
+      _tij_trash_ask_unlock (trash_data);
+      g_free (display_name);
+
+      g_clear_error (&err);
+
+      /* go back to the beginning if the user wants to retry */
+      if (response == THUNAR_JOB_RESPONSE_RETRY)
+        goto again;
+    }
+  else
+    {
+      g_clear_error (&err);
+    }
+
+  g_object_unref (file);
+}
+
+
+
 static gboolean
 _thunar_io_jobs_trash (ThunarJob  *job,
                        GArray     *param_values,
@@ -799,7 +1008,8 @@ _thunar_io_jobs_trash (ThunarJob  *job,
 {
   ThunarThumbnailCache *thumbnail_cache;
   ThunarApplication    *application;
-  GError               *err = NULL;
+  TijTrashData          trash_data;
+  GThreadPool          *pool = NULL;
   GList                *file_list;
   GList                *lp;
 
@@ -813,34 +1023,60 @@ _thunar_io_jobs_trash (ThunarJob  *job,
   if (exo_job_set_error_if_cancelled (EXO_JOB (job), error))
     return FALSE;
 
-  /* take a reference on the thumbnail cache */
-  application = thunar_application_get ();
-  thumbnail_cache = thunar_application_get_thumbnail_cache (application);
-  g_object_unref (application);
+  /* we know the total list of files to process */
+  thunar_job_set_total_files (THUNAR_JOB (job), g_list_length (file_list));
+
+  trash_data.job = job;
+  trash_data.trashed_files = NULL;
+#if GLIB_CHECK_VERSION (2, 32, 0)
+  g_mutex_init (&trash_data.lock);
+  g_mutex_init (&trash_data.ask_lock);
+#else
+  trash_data.lock = g_mutex_new ();
+  trash_data.ask_lock = g_mutex_new ();
+#endif
 
-  for (lp = file_list; err == NULL && lp != NULL; lp = lp->next)
+  /* trashing a local file is a rename into the trash directory of its
+   * file system, so these can run concurrently without hurting the disk */
+  if (file_list != NULL && file_list->next != NULL)
+    pool = g_thread_pool_new (_tij_trash_file, &trash_data, TRASH_MAX_THREADS, FALSE, NULL);
+
+  for (lp = file_list; lp != NULL && !exo_job_is_cancelled (EXO_JOB (job)); lp = lp->next)
     {
       _thunar_assert (G_IS_FILE (lp->data));
 
-      /* trash the file or folder */
-      g_file_trash (lp->data, exo_job_get_cancellable (EXO_JOB (job)), &err);
-
-      /* update the thumbnail cache */
-      thunar_thumbnail_cache_cleanup_file (thumbnail_cache, lp->data);
+      if (pool != NULL && g_file_is_native (lp->data))
+        g_thread_pool_push (pool, g_object_ref (lp->data), NULL);
+      else
+        _tij_trash_file (g_object_ref (lp->data), &trash_data);
     }
 
-  /* release the thumbnail cache */
-  g_object_unref (thumbnail_cache);
+  /* wait for the remaining files */
+  if (pool != NULL)
+    g_thread_pool_free (pool, FALSE, TRUE);
 
-  if (err != NULL)
-    {
-      g_propagate_error (error, err);
-      return FALSE;
-    }
-  else
+#if GLIB_CHECK_VERSION (2, 32, 0)
+  g_mutex_clear (&trash_data.lock);
+  g_mutex_clear (&trash_data.ask_lock);
+#else
+  g_mutex_free (trash_data.lock);
+  g_mutex_free (trash_data.ask_lock);
+#endif
+
+  /* drop the thumbnails of all trashed files in one go */
+  if (trash_data.trashed_files != NULL)
     {
-      return TRUE;
+      application = thunar_application_get ();
+      thumbnail_cache = thunar_application_get_thumbnail_cache (application);
+      g_object_unref (application);
+
+      thunar_thumbnail_cache_cleanup_files (thumbnail_cache, trash_data.trashed_files);
+
+      g_object_unref (thumbnail_cache);
+      thunar_g_file_list_free (trash_data.trashed_files);
     }
+
+  return !exo_job_set_error_if_cancelled (EXO_JOB (job), error);
 }
 
 
@@ -874,38 +1110,35 @@ thunar_io_jobs_restore_files (GList *source_file_list,
 
 
 
+typedef struct
+{
+  gint uid;
+  gint gid;
+} TijChownData;
+
+
+
 static gboolean
-_thunar_io_jobs_chown (ThunarJob  *job,
-                       GArray     *param_values,
-                       GError    **error)
+_tij_chown_file (ThunarJob *job,
+                 GFile     *file,
+                 gpointer   user_data,
+                 GError   **error)
 {
+  TijChownData     *data = user_data;
   ThunarJobResponse response;
   const gchar      *message;
   GFileInfo        *info;
-  gboolean          recursive;
   GError           *err = NULL;
-  GList            *file_list;
-  GList            *lp;
-  gint              uid;
-  gint              gid;
-
-  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
-  _thunar_return_val_if_fail (param_values != NULL, FALSE);
-  _thunar_return_val_if_fail (param_values->len == 4, FALSE);
-  _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
-  file_list = g_value_get_boxed (&g_array_index (param_values, GValue, 0));
-  uid = g_value_get_int (&g_array_index (param_values, GValue, 1));
-  gid = g_value_get_int (&g_array_index (param_values, GValue, 2));
-  recursive = g_value_get_boolean (&g_array_index (param_values, GValue, 3));
+  /* update progress information */
+  thunar_job_processing_file (THUNAR_JOB (job), file);
 
-  _thunar_assert ((uid >= 0 || gid >= 0) && !(uid >= 0 && gid >= 0));
-
-  /* collect the files for the chown operation */
-  if (recursive)
-    file_list = _tij_collect_nofollow (job, file_list, FALSE, &err);
-  else
-    file_list = thunar_g_file_list_copy (file_list);
+  /* try to query information about the file */
+  info = g_file_query_info (file,
+                            G_FILE_ATTRIBUTE_STANDARD_DISPLAY_NAME,
+                            G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                            exo_job_get_cancellable (EXO_JOB (job)),
+                            &err);
 
   if (err != NULL)
     {
@@ -913,81 +1146,83 @@ _thunar_io_jobs_chown (ThunarJob  *job,
       return FALSE;
     }
 
-  /* we know the total list of files to process */
-  thunar_job_set_total_files (THUNAR_JOB (job), file_list);
-
-  /* change the ownership of all files */
-  for (lp = file_list; lp != NULL && err == NULL; lp = lp->next)
-    {
-      /* update progress information */
-      thunar_job_processing_file (THUNAR_JOB (job), lp);
-
-      /* try to query information about the file */
-      info = g_file_query_info (lp->data,
-                                G_FILE_ATTRIBUTE_STANDARD_DISPLAY_NAME,
-                                G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
-                                exo_job_get_cancellable (EXO_JOB (job)),
-                                &err);
-
-      if (err != NULL)
-        break;
-
 retry_chown:
-      if (uid >= 0)
-        {
-          /* try to change the owner UID */
-          g_file_set_attribute_uint32 (lp->data,
-                                       G_FILE_ATTRIBUTE_UNIX_UID, uid,
-                                       G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
-                                       exo_job_get_cancellable (EXO_JOB (job)),
-                                       &err);
-        }
-      else if (gid >= 0)
-        {
-          /* try to change the owner GID */
-          g_file_set_attribute_uint32 (lp->data,
-                                       G_FILE_ATTRIBUTE_UNIX_GID, gid,
-                                       G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
-                                       exo_job_get_cancellable (EXO_JOB (job)),
-                                       &err);
-        }
-
-      /* check if there was a recoverable error */
-      if (err != NULL && !exo_job_is_cancelled (EXO_JOB (job)))
-        {
-          /* generate a useful error message */
-          message = G_LIKELY (uid >= 0) ? _("Failed to change the owner of \"%s\": %s")
-                                        : _("Failed to change the group of \"%s\": %s");
+  if (data->uid >= 0)
+    {
+      /* try to change the owner UID */
+      g_file_set_attribute_uint32 (file,
+                                   G_FILE_ATTRIBUTE_UNIX_UID, data->uid,
+                                   G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                   exo_job_get_cancellable (EXO_JOB (job)),
+                                   &err);
+    }
+  else if (data->gid >= 0)
+    {
+      /* try to change the owner GID */
+      g_file_set_attribute_uint32 (file,
+                                   G_FILE_ATTRIBUTE_UNIX_GID, data->gid,
+                                   G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                   exo_job_get_cancellable (EXO_JOB (job)),
+                                   &err);
+    }
 
-          /* ask the user whether to skip/retry this file */
-          response = thunar_job_ask_skip (THUNAR_JOB (job), message,
-                                          g_file_info_get_display_name (info),
-                                          err->message);
+  /* check if there was a recoverable error */
+  if (err != NULL && !exo_job_is_cancelled (EXO_JOB (job)))
+    {
+      /* generate a useful error message */
+      message = G_LIKELY (data->uid >= 0) ? _("Failed to change the owner of \"%s\": %s")
+                                          : _("Failed to change the group of \"%s\": %s");
 
-          /* clear the error */
-          g_clear_error (&err);
+      /* ask the user whether to skip/retry this file */
+      response = thunar_job_ask_skip (THUNAR_JOB (job), message,
+                                      g_file_info_get_display_name (info),
+                                      err->message);
 
-          /* check whether to retry */
-          if (response == THUNAR_JOB_RESPONSE_RETRY)
-            goto retry_chown;
-        }
+      /* clear the error */
+      g_clear_error (&err);
 
-      /* release file information */
-      g_object_unref (info);
+      /* check whether to retry */
+      if (response == THUNAR_JOB_RESPONSE_RETRY)
+        goto retry_chown;
     }
 
-  /* release the file list */
-  thunar_g_file_list_free (file_list);
+  /* release file information */
+  g_object_unref (info);
 
   if (err != NULL)
     {
       g_propagate_error (error, err);
       return FALSE;
     }
-  else
-    {
-      return TRUE;
-    }
+
+  return TRUE;
+}
+
+
+
+static gboolean
+_thunar_io_jobs_chown (ThunarJob  *job,
+                       GArray     *param_values,
+                       GError    **error)
+{
+  TijChownData data;
+  gboolean     recursive;
+  GList       *file_list;
+
+  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
+  _thunar_return_val_if_fail (param_values != NULL, FALSE);
+  _thunar_return_val_if_fail (param_values->len == 4, FALSE);
+  _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  file_list = g_value_get_boxed (&g_array_index (param_values, GValue, 0));
+  data.uid = g_value_get_int (&g_array_index (param_values, GValue, 1));
+  data.gid = g_value_get_int (&g_array_index (param_values, GValue, 2));
+  recursive = g_value_get_boolean (&g_array_index (param_values, GValue, 3));
+
+  _thunar_assert ((data.uid >= 0 || data.gid >= 0) && !(data.uid >= 0 && data.gid >= 0));
+
+  /* change the ownership of all files while walking the tree */
+  return _tij_walk_file_list (job, file_list, recursive, FALSE, _tij_chown_file, &data, error);
 }
 
 
@@ -1011,43 +1246,42 @@ thunar_io_jobs_change_group (GList    *files,
 
 
 
+typedef struct
+{
+  ThunarFileMode dir_mask;
+  ThunarFileMode dir_mode;
+  ThunarFileMode file_mask;
+  ThunarFileMode file_mode;
+} TijChmodData;
+
+
+
 static gboolean
-_thunar_io_jobs_chmod (ThunarJob  *job,
-                       GArray     *param_values,
-                       GError    **error)
+_tij_chmod_file (ThunarJob *job,
+                 GFile     *file,
+                 gpointer   user_data,
+                 GError   **error)
 {
+  TijChmodData     *data = user_data;
   ThunarJobResponse response;
   GFileInfo        *info;
-  gboolean          recursive;
   GError           *err = NULL;
-  GList            *file_list;
-  GList            *lp;
-  ThunarFileMode    dir_mask;
-  ThunarFileMode    dir_mode;
-  ThunarFileMode    file_mask;
-  ThunarFileMode    file_mode;
   ThunarFileMode    mask;
   ThunarFileMode    mode;
   ThunarFileMode    old_mode;
   ThunarFileMode    new_mode;
 
-  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
-  _thunar_return_val_if_fail (param_values != NULL, FALSE);
-  _thunar_return_val_if_fail (param_values->len == 6, FALSE);
-  _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+  /* update progress information */
+  thunar_job_processing_file (THUNAR_JOB (job), file);
 
-  file_list = g_value_get_boxed (&g_array_index (param_values, GValue, 0));
-  dir_mask = g_value_get_flags (&g_array_index (param_values, GValue, 1));
-  dir_mode = g_value_get_flags (&g_array_index (param_values, GValue, 2));
-  file_mask = g_value_get_flags (&g_array_index (param_values, GValue, 3));
-  file_mode = g_value_get_flags (&g_array_index (param_values, GValue, 4));
-  recursive = g_value_get_boolean (&g_array_index (param_values, GValue, 5));
-
-  /* collect the files for the chown operation */
-  if (recursive)
-    file_list = _tij_collect_nofollow (job, file_list, FALSE, &err);
-  else
-    file_list = thunar_g_file_list_copy (file_list);
+  /* try to query information about the file */
+  info = g_file_query_info (file,
+                            G_FILE_ATTRIBUTE_STANDARD_DISPLAY_NAME ","
+                            G_FILE_ATTRIBUTE_STANDARD_TYPE ","
+                            G_FILE_ATTRIBUTE_UNIX_MODE,
+                            G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                            exo_job_get_cancellable (EXO_JOB (job)),
+                            &err);
 
   if (err != NULL)
     {
@@ -1055,95 +1289,94 @@ _thunar_io_jobs_chmod (ThunarJob  *job,
       return FALSE;
     }
 
-  /* we know the total list of files to process */
-  thunar_job_set_total_files (THUNAR_JOB (job), file_list);
-
-  /* change the ownership of all files */
-  for (lp = file_list; lp != NULL && err == NULL; lp = lp->next)
-    {
-      /* update progress information */
-      thunar_job_processing_file (THUNAR_JOB (job), lp);
-
-      /* try to query information about the file */
-      info = g_file_query_info (lp->data,
-                                G_FILE_ATTRIBUTE_STANDARD_DISPLAY_NAME ","
-                                G_FILE_ATTRIBUTE_STANDARD_TYPE ","
-                                G_FILE_ATTRIBUTE_UNIX_MODE,
-                                G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
-                                exo_job_get_cancellable (EXO_JOB (job)),
-                                &err);
-
-      if (err != NULL)
-        break;
-
 retry_chown:
-      /* different actions depending on the type of the file */
-      if (g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY)
-        {
-          mask = dir_mask;
-          mode = dir_mode;
-        }
-      else
-        {
-          mask = file_mask;
-          mode = file_mode;
-        }
-
-      /* determine the current mode */
-      old_mode = g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_UNIX_MODE);
-
-      /* generate the new mode, taking the old mode (which contains file type
-       * information) into account */
-      new_mode = ((old_mode & ~mask) | mode) & 07777;
-
-      if (old_mode != new_mode)
-        {
-          /* try to change the file mode */
-          g_file_set_attribute_uint32 (lp->data,
-                                       G_FILE_ATTRIBUTE_UNIX_MODE, new_mode,
-                                       G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
-                                       exo_job_get_cancellable (EXO_JOB (job)),
-                                       &err);
-        }
+  /* different actions depending on the type of the file */
+  if (g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY)
+    {
+      mask = data->dir_mask;
+      mode = data->dir_mode;
+    }
+  else
+    {
+      mask = data->file_mask;
+      mode = data->file_mode;
+    }
 
-      /* check if there was a recoverable error */
-      if (err != NULL && !exo_job_is_cancelled (EXO_JOB (job)))
-        {
-          /* ask the user whether to skip/retry this file */
-          response = thunar_job_ask_skip (job,
-                                          _("Failed to change the permissions of \"%s\": %s"),
-                                          g_file_info_get_display_name (info),
-                                          err->message);
+  /* determine the current mode */
+  old_mode = g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_UNIX_MODE);
 
-          /* clear the error */
-          g_clear_error (&err);
+  /* generate the new mode, taking the old mode (which contains file type
+   * information) into account */
+  new_mode = ((old_mode & ~mask) | mode) & 07777;
 
-          /* check whether to retry */
-          if (response == THUNAR_JOB_RESPONSE_RETRY)
-            goto retry_chown;
-        }
+  if (old_mode != new_mode)
+    {
+      /* try to change the file mode */
+      g_file_set_attribute_uint32 (file,
+                                   G_FILE_ATTRIBUTE_UNIX_MODE, new_mode,
+                                   G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                   exo_job_get_cancellable (EXO_JOB (job)),
+                                   &err);
+    }
 
-      /* release file information */
-      g_object_unref (info);
+  /* check if there was a recoverable error */
+  if (err != NULL && !exo_job_is_cancelled (EXO_JOB (job)))
+    {
+      /* ask the user whether to skip/retry this file */
+      response = thunar_job_ask_skip (job,
+                                      _("Failed to change the permissions of \"%s\": %s"),
+                                      g_file_info_get_display_name (info),
+                                      err->message);
+
+      /* clear the error */
+      g_clear_error (&err);
+
+      /* check whether to retry */
+      if (response == THUNAR_JOB_RESPONSE_RETRY)
+        goto retry_chown;
     }
 
-  /* release the file list */
-  thunar_g_file_list_free (file_list);
+  /* release file information */
+  g_object_unref (info);
 
   if (err != NULL)
     {
       g_propagate_error (error, err);
       return FALSE;
     }
-  else
-    {
-      return TRUE;
-    }
+
   return TRUE;
 }
 
 
 
+static gboolean
+_thunar_io_jobs_chmod (ThunarJob  *job,
+                       GArray     *param_values,
+                       GError    **error)
+{
+  TijChmodData data;
+  gboolean     recursive;
+  GList       *file_list;
+
+  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
+  _thunar_return_val_if_fail (param_values != NULL, FALSE);
+  _thunar_return_val_if_fail (param_values->len == 6, FALSE);
+  _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  file_list = g_value_get_boxed (&g_array_index (param_values, GValue, 0));
+  data.dir_mask = g_value_get_flags (&g_array_index (param_values, GValue, 1));
+  data.dir_mode = g_value_get_flags (&g_array_index (param_values, GValue, 2));
+  data.file_mask = g_value_get_flags (&g_array_index (param_values, GValue, 3));
+  data.file_mode = g_value_get_flags (&g_array_index (param_values, GValue, 4));
+  recursive = g_value_get_boolean (&g_array_index (param_values, GValue, 5));
+
+  /* change the permissions of all files while walking the tree */
+  return _tij_walk_file_list (job, file_list, recursive, FALSE, _tij_chmod_file, &data, error);
+}
+
+
+
 ThunarJob *
 thunar_io_jobs_change_mode (GList         *files,
                             ThunarFileMode dir_mask,
@@ -1168,6 +1401,119 @@ thunar_io_jobs_change_mode (GList         *files,
 
 
 
+static void
+_tij_ls_files_ready (ThunarJob *job,
+                     GList     *file_list)
+{
+  /* check if we have any files to report */
+  if (G_LIKELY (file_list != NULL))
+    {
+      /* emit the "files-ready" signal */
+      if (!thunar_job_files_ready (THUNAR_JOB (job), file_list))
+        {
+          /* none of the handlers took over the file list, so it's up to us
+           * to destroy it */
+          thunar_g_file_list_free (file_list);
+        }
+    }
+}
+
+
+
+static void
+_tij_ls_batched (ThunarJob  *job,
+                 GFile      *directory,
+                 guint       batch_size,
+                 GError    **error)
+{
+  GFileEnumerator *enumerator;
+  GFileInfo       *info;
+  ThunarFile      *file;
+  GError          *err = NULL;
+  GFile           *child_file;
+  GList           *file_list = NULL;
+  gboolean         is_mounted;
+  guint            n_files = 0;
+
+  /* try to read from the directory */
+  enumerator = g_file_enumerate_children (directory, THUNARX_FILE_INFO_NAMESPACE,
+                                          G_FILE_QUERY_INFO_NONE,
+                                          exo_job_get_cancellable (EXO_JOB (job)),
+                                          &err);
+  if (err != NULL)
+    {
+      /* a file that is not a directory has no contents */
+      if (g_error_matches (err, G_IO_ERROR, G_IO_ERROR_NOT_DIRECTORY))
+        g_error_free (err);
+      else
+        g_propagate_error (error, err);
+      return;
+    }
+
+  /* iterate over children one by one */
+  while (!exo_job_is_cancelled (EXO_JOB (job)))
+    {
+      /* query info of the child */
+      info = g_file_enumerator_next_file (enumerator,
+                                          exo_job_get_cancellable (EXO_JOB (job)),
+                                          &err);
+
+      if (G_UNLIKELY (info == NULL))
+        break;
+
+      is_mounted = TRUE;
+      if (err != NULL)
+        {
+          if (g_error_matches (err, G_IO_ERROR, G_IO_ERROR_NOT_MOUNTED))
+            {
+              is_mounted = FALSE;
+              g_clear_error (&err);
+            }
+          else
+            {
+              /* break on errors */
+              g_object_unref (info);
+              break;
+            }
+        }
+
+      /* prepend the ThunarFile for the child (the list owns the reference) */
+      child_file = g_file_get_child (directory, g_file_info_get_name (info));
+      file = thunar_file_get_with_info (child_file, info, !is_mounted);
+      file_list = g_list_prepend (file_list, file);
+      g_object_unref (child_file);
+      g_object_unref (info);
+
+      /* hand over the files collected so far once the batch is full */
+      if (++n_files == batch_size)
+        {
+          _tij_ls_files_ready (job, file_list);
+          file_list = NULL;
+          n_files = 0;
+        }
+    }
+
+  /* release the enumerator */
+  g_object_unref (enumerator);
+
+  /* report the remaining files, unless something went wrong */
+  if (G_UNLIKELY (err != NULL))
+    {
+      g_propagate_error (error, err);
+      thunar_g_file_list_free (file_list);
+    }
+  else if (exo_job_is_cancelled (EXO_JOB (job)))
+    {
+      thunar_g_file_list_free (file_list);
+    }
+  else
+    {
+      _tij_ls_files_ready (job, file_list);
+    }
+}
+
+
+
 static gboolean
 _thunar_io_jobs_ls (ThunarJob  *job,
                     GArray     *param_values,
@@ -1176,10 +1522,11 @@ _thunar_io_jobs_ls (ThunarJob  *job,
   GError *err = NULL;
   GFile  *directory;
   GList  *file_list = NULL;
+  guint   batch_size;
 
   _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
   _thunar_return_val_if_fail (param_values != NULL, FALSE);
-  _thunar_return_val_if_fail (param_values->len == 1, FALSE);
+  _thunar_return_val_if_fail (param_values->len == 2, FALSE);
   _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
   if (exo_job_set_error_if_cancelled (EXO_JOB (job), error))
@@ -1188,13 +1535,30 @@ _thunar_io_jobs_ls (ThunarJob  *job,
   /* determine the directory to list */
   directory = g_value_get_object (&g_array_index (param_values, GValue, 0));
 
+  /* determine the number of files to report at once */
+  batch_size = g_value_get_uint (&g_array_index (param_values, GValue, 1));
+
   /* make sure the object is valid */
   _thunar_assert (G_IS_FILE (directory));
 
-  /* collect directory contents (non-recursively) */
-  file_list = thunar_io_scan_directory (job, directory,
-                                        G_FILE_QUERY_INFO_NONE,
-                                        FALSE, FALSE, TRUE, &err);
+  if (batch_size > 0)
+    {
+      /* report the directory contents in batches while reading */
+      _tij_ls_batched (job, directory, batch_size, &err);
+    }
+  else
+    {
+      /* collect directory contents (non-recursively) */
+      file_list = thunar_io_scan_directory (job, directory,
+                                            G_FILE_QUERY_INFO_NONE,
+                                            FALSE, FALSE, TRUE, &err);
+
+      /* report the files if the scan succeeded */
+      if (err == NULL && !exo_job_is_cancelled (EXO_JOB (job)))
+        _tij_ls_files_ready (job, file_list);
+      else
+        thunar_g_file_list_free (file_list);
+    }
 
   /* abort on errors or cancellation */
   if (err != NULL)
@@ -1208,28 +1572,6 @@ _thunar_io_jobs_ls (ThunarJob  *job,
       return FALSE;
     }
 
-  /* check if we have any files to report */
-  if (G_LIKELY (file_list != NULL))
-    {
-      /* emit the "files-ready" signal */
-      if (!thunar_job_files_ready (THUNAR_JOB (job), file_list))
-        {
-          /* none of the handlers took over the file list, so it's up to us
-           * to destroy it */
-          thunar_g_file_list_free (file_list);
-        }
-    }
-
-  /* there should be no errors here */
-  _thunar_assert (err == NULL);
-
-  /* propagate cancellation error */
-  if (exo_job_set_error_if_cancelled (EXO_JOB (job), &err))
-    {
-      g_propagate_error (error, err);
-      return FALSE;
-    }
-
   return TRUE;
 }
 
@@ -1238,9 +1580,19 @@ _thunar_io_jobs_ls (ThunarJob  *job,
 ThunarJob *
 thunar_io_jobs_list_directory (GFile *directory)
 {
+  ThunarPreferences *preferences;
+  guint              batch_size;
+
   _thunar_return_val_if_fail (G_IS_FILE (directory), NULL);
 
-  return thunar_simple_job_launch (_thunar_io_jobs_ls, 1, G_TYPE_FILE, directory);
+  /* determine the number of files to report at once */
+  preferences = thunar_preferences_get ();
+  g_object_get (G_OBJECT (preferences), "misc-directory-load-batch-size", &batch_size, NULL);
+  g_object_unref (G_OBJECT (preferences));
+
+  return thunar_simple_job_launch (_thunar_io_jobs_ls, 2,
+                                   G_TYPE_FILE, directory,
+                                   G_TYPE_UINT, batch_size);
 }
 
 
@@ -69,7 +69,8 @@ struct _ThunarJobPrivate
   ThunarJobResponse earlier_ask_create_response;
   ThunarJobResponse earlier_ask_overwrite_response;
   ThunarJobResponse earlier_ask_skip_response;
-  GList            *total_files;
+  guint             n_total_files;
+  volatile gint     n_processed_files;
 };
 
 
@@ -591,52 +592,47 @@ thunar_job_new_files (ThunarJob   *job,
 
 void
 thunar_job_set_total_files (ThunarJob *job,
-                            GList     *total_files)
+                            guint      n_total_files)
 {
   _thunar_return_if_fail (THUNAR_IS_JOB (job));
-  _thunar_return_if_fail (job->priv->total_files == NULL);
-  _thunar_return_if_fail (total_files != NULL);
 
-  job->priv->total_files = total_files;
+  job->priv->n_total_files = n_total_files;
+  job->priv->n_processed_files = 0;
 }
 
 
 
 void
 thunar_job_processing_file (ThunarJob *job,
-                            GList     *current_file)
+                            GFile     *current_file)
 {
-  GList *lp;
   gchar *base_name;
   gchar *display_name;
   guint  n_processed;
-  guint  n_total;
 
   _thunar_return_if_fail (THUNAR_IS_JOB (job));
-  _thunar_return_if_fail (current_file != NULL);
+  _thunar_return_if_fail (G_IS_FILE (current_file));
 
-  base_name = g_file_get_basename (current_file->data);
+  base_name = g_file_get_basename (current_file);
   display_name = g_filename_display_name (base_name);
   g_free (base_name);
 
   exo_job_info_message (EXO_JOB (job), "%s", display_name);
   g_free (display_name);
 
+  /* the number of files processed before this one, this function
+   * may be called from several worker threads at once */
+  n_processed = g_atomic_int_add (&job->priv->n_processed_files, 1);
+
   /* verify that we have total files set */
-  if (G_LIKELY (job->priv->total_files != NULL))
+  if (G_LIKELY (job->priv->n_total_files > 0))
     {
-      /* determine the number of files processed so far */
-      for (lp = job->priv->total_files, n_processed = 0;
-           lp != current_file;
-           lp = lp->next, n_processed++);
-
       /* emit only if n_processed is a multiple of 8 */
       if ((n_processed % 8) == 0)
         {
-          /* determine the total_number of files */
-          n_total = g_list_length (job->priv->total_files);
-
-          exo_job_percent (EXO_JOB (job), (n_processed * 100.0) / n_total);
+          exo_job_percent (EXO_JOB (job),
+                           (MIN (n_processed, job->priv->n_total_files) * 100.0)
+                           / job->priv->n_total_files);
         }
     }
 }
@@ -67,9 +67,9 @@ struct _ThunarJob
 
 GType             thunar_job_get_type               (void) G_GNUC_CONST;
 void              thunar_job_set_total_files        (ThunarJob       *job,
-                                                     GList           *total_files);
+                                                     guint            n_total_files);
 void              thunar_job_processing_file        (ThunarJob       *job,
-                                                     GList           *current_file);
+                                                     GFile           *current_file);
 
 ThunarJobResponse thunar_job_ask_create             (ThunarJob       *job,
                                                      const gchar     *format,
@@ -64,6 +64,22 @@ enum
 
 
 
+/* what a selected file counts as in the launcher */
+typedef enum
+{
+  THUNAR_LAUNCHER_FILE_DIRECTORY = 1,
+  THUNAR_LAUNCHER_FILE_EXECUTABLE,
+  THUNAR_LAUNCHER_FILE_REGULAR,
+} ThunarLauncherFileKind;
+
+/* the values in the selected kinds table, the kind of the file and
+ * the mark of the last selection update that saw the file selected */
+#define THUNAR_LAUNCHER_KIND_VALUE(kind, mark) (GINT_TO_POINTER ((kind) | ((mark) << 2)))
+#define THUNAR_LAUNCHER_VALUE_KIND(value)      (GPOINTER_TO_INT (value) & 0x3)
+#define THUNAR_LAUNCHER_VALUE_MARK(value)      (GPOINTER_TO_INT (value) >> 2)
+
+
+
 static void                    thunar_launcher_component_init             (ThunarComponentIface     *iface);
 static void                    thunar_launcher_navigator_init             (ThunarNavigatorIface     *iface);
 static void                    thunar_launcher_dispose                    (GObject                  *object);
@@ -82,6 +98,13 @@ static void                    thunar_launcher_set_current_directory      (Thuna
 static GList                  *thunar_launcher_get_selected_files         (ThunarComponent          *component);
 static void                    thunar_launcher_set_selected_files         (ThunarComponent          *component,
                                                                            GList                    *selected_files);
+static ThunarLauncherFileKind  thunar_launcher_get_file_kind              (ThunarFile               *file);
+static void                    thunar_launcher_count_file                 (ThunarLauncher           *launcher,
+                                                                           ThunarLauncherFileKind    kind,
+                                                                           gint                      delta);
+static void                    thunar_launcher_file_changed               (ThunarFile               *file,
+                                                                           ThunarLauncher           *launcher);
+static void                    thunar_launcher_clear_kinds                (ThunarLauncher           *launcher);
 static GtkUIManager           *thunar_launcher_get_ui_manager             (ThunarComponent          *component);
 static void                    thunar_launcher_set_ui_manager             (ThunarComponent          *component,
                                                                            GtkUIManager             *ui_manager);
@@ -136,6 +159,17 @@ struct _ThunarLauncher
   ThunarFile             *current_directory;
   GList                  *selected_files;
 
+  /* the kinds of the selected files (ThunarFile -> ThunarLauncherFileKind),
+   * so only the files that were (un)selected have to be looked at. the
+   * table holds a reference on the files and the kinds are updated when
+   * a file changes. the mark flips with every update of the selection,
+   * files that keep the previous mark were unselected */
+  GHashTable             *selected_kinds;
+  guint                   selected_mark : 1;
+  gint                    n_directories;
+  gint                    n_executables;
+  gint                    n_regulars;
+
   guint                   launcher_idle_id;
 
   GtkActionGroup         *action_group;
@@ -283,6 +317,8 @@ G_GNUC_BEGIN_IGNORE_DEPRECATIONS
   launcher->action_open_with_other_in_menu = gtk_action_group_get_action (launcher->action_group, "open-with-other-in-menu");
 G_GNUC_END_IGNORE_DEPRECATIONS
 
+  launcher->selected_kinds = g_hash_table_new_full (g_direct_hash, g_direct_equal, g_object_unref, NULL);
+
   /* setup the "Send To" support */
   launcher->sendto_model = thunar_sendto_model_get_default ();
 
@@ -307,6 +343,7 @@ thunar_launcher_dispose (GObject *object)
   /* disconnect from the currently selected files */
   thunar_g_file_list_free (launcher->selected_files);
   launcher->selected_files = NULL;
+  thunar_launcher_clear_kinds (launcher);
 
   (*G_OBJECT_CLASS (thunar_launcher_parent_class)->dispose) (object);
 }
@@ -322,6 +359,8 @@ thunar_launcher_finalize (GObject *object)
   if (G_UNLIKELY (launcher->sendto_idle_id != 0))
     g_source_remove (launcher->sendto_idle_id);
 
+  g_hash_table_destroy (launcher->selected_kinds);
+
   /* be sure to cancel the launcher idle source */
   if (G_UNLIKELY (launcher->launcher_idle_id != 0))
     g_source_remove (launcher->launcher_idle_id);
@@ -444,13 +483,98 @@ thunar_launcher_get_selected_files (ThunarComponent *component)
 
 
 
+static ThunarLauncherFileKind
+thunar_launcher_get_file_kind (ThunarFile *file)
+{
+  if (thunar_file_is_directory (file)
+      || thunar_file_is_shortcut (file)
+      || thunar_file_is_mountable (file))
+    return THUNAR_LAUNCHER_FILE_DIRECTORY;
+  else if (thunar_file_is_executable (file))
+    return THUNAR_LAUNCHER_FILE_EXECUTABLE;
+  else
+    return THUNAR_LAUNCHER_FILE_REGULAR;
+}
+
+
+
+static void
+thunar_launcher_count_file (ThunarLauncher         *launcher,
+                            ThunarLauncherFileKind  kind,
+                            gint                    delta)
+{
+  if (kind == THUNAR_LAUNCHER_FILE_DIRECTORY)
+    {
+      launcher->n_directories += delta;
+    }
+  else
+    {
+      if (kind == THUNAR_LAUNCHER_FILE_EXECUTABLE)
+        launcher->n_executables += delta;
+      launcher->n_regulars += delta;
+    }
+}
+
+
+
+static void
+thunar_launcher_file_changed (ThunarFile     *file,
+                              ThunarLauncher *launcher)
+{
+  ThunarLauncherFileKind old_kind;
+  ThunarLauncherFileKind kind;
+  gpointer               value;
+
+  _thunar_return_if_fail (THUNAR_IS_FILE (file));
+  _thunar_return_if_fail (THUNAR_IS_LAUNCHER (launcher));
+
+  /* the kind may change with the permissions or the type of the file */
+  value = g_hash_table_lookup (launcher->selected_kinds, file);
+  old_kind = THUNAR_LAUNCHER_VALUE_KIND (value);
+  kind = thunar_launcher_get_file_kind (file);
+  if (old_kind != 0 && old_kind != kind)
+    {
+      thunar_launcher_count_file (launcher, old_kind, -1);
+      thunar_launcher_count_file (launcher, kind, 1);
+
+      /* the table keeps the existing key and releases the new one */
+      g_hash_table_insert (launcher->selected_kinds, g_object_ref (file),
+                           THUNAR_LAUNCHER_KIND_VALUE (kind, THUNAR_LAUNCHER_VALUE_MARK (value)));
+
+      thunar_launcher_update (launcher);
+    }
+}
+
+
+
+static void
+thunar_launcher_clear_kinds (ThunarLauncher *launcher)
+{
+  GHashTableIter iter;
+  gpointer       file;
+
+  /* disconnect from the files and release them */
+  g_hash_table_iter_init (&iter, launcher->selected_kinds);
+  while (g_hash_table_iter_next (&iter, &file, NULL))
+    g_signal_handlers_disconnect_by_func (file, thunar_launcher_file_changed, launcher);
+  g_hash_table_remove_all (launcher->selected_kinds);
+
+  launcher->n_directories = launcher->n_executables = launcher->n_regulars = 0;
+}
+
+
+
 static void
 thunar_launcher_set_selected_files (ThunarComponent *component,
                                     GList           *selected_files)
 {
-  ThunarLauncher *launcher = THUNAR_LAUNCHER (component);
-  GList          *np;
-  GList          *op;
+  ThunarLauncher         *launcher = THUNAR_LAUNCHER (component);
+  ThunarLauncherFileKind  kind;
+  GHashTableIter          iter;
+  gpointer                file;
+  gpointer                value;
+  GList                  *np;
+  GList                  *op;
 
   /* compare the old and the new list of selected files */
   for (np = selected_files, op = launcher->selected_files; np != NULL && op != NULL; np = np->next, op = op->next)
@@ -466,6 +590,44 @@ thunar_launcher_set_selected_files (ThunarComponent *component,
       /* connect to the new selected files list */
       launcher->selected_files = thunar_g_file_list_copy (selected_files);
 
+      /* only determine the kinds of the newly selected files, the
+       * table is updated in place and the files that are still
+       * selected only get the new mark */
+      launcher->selected_mark = !launcher->selected_mark;
+      for (np = selected_files; np != NULL; np = np->next)
+        {
+          value = g_hash_table_lookup (launcher->selected_kinds, np->data);
+          if (value != NULL)
+            {
+              /* still selected, so we stay connected to the file. the
+               * table keeps the existing key and releases the new one */
+              if (THUNAR_LAUNCHER_VALUE_MARK (value) != launcher->selected_mark)
+                g_hash_table_insert (launcher->selected_kinds, g_object_ref (np->data),
+                                     THUNAR_LAUNCHER_KIND_VALUE (THUNAR_LAUNCHER_VALUE_KIND (value), launcher->selected_mark));
+            }
+          else
+            {
+              kind = thunar_launcher_get_file_kind (np->data);
+              thunar_launcher_count_file (launcher, kind, 1);
+
+              /* update the kind if the file changes */
+              g_signal_connect (G_OBJECT (np->data), "changed", G_CALLBACK (thunar_launcher_file_changed), launcher);
+
+              g_hash_table_insert (launcher->selected_kinds, g_object_ref (np->data),
+                                   THUNAR_LAUNCHER_KIND_VALUE (kind, launcher->selected_mark));
+            }
+        }
+
+      /* the files that kept the previous mark were unselected */
+      g_hash_table_iter_init (&iter, launcher->selected_kinds);
+      while (g_hash_table_iter_next (&iter, &file, &value))
+        if (THUNAR_LAUNCHER_VALUE_MARK (value) != launcher->selected_mark)
+          {
+            g_signal_handlers_disconnect_by_func (file, thunar_launcher_file_changed, launcher);
+            thunar_launcher_count_file (launcher, THUNAR_LAUNCHER_VALUE_KIND (value), -1);
+            g_hash_table_iter_remove (&iter);
+          }
+
       /* update the launcher actions */
       thunar_launcher_update (launcher);
 
@@ -764,10 +926,9 @@ thunar_launcher_update_idle (gpointer data)
   gchar          *tooltip;
   gchar          *label;
   gchar          *name;
-  gint            n_directories = 0;
-  gint            n_executables = 0;
-  gint            n_regulars = 0;
-  gint            n_selected_files = 0;
+  gint            n_directories = launcher->n_directories;
+  gint            n_executables = launcher->n_executables;
+  gint            n_selected_files = launcher->n_directories + launcher->n_regulars;
   gint            n;
 
   /* verify that we're connected to an UI manager */
@@ -789,23 +950,6 @@ G_GNUC_END_IGNORE_DEPRECATIONS
   /* reset the application set for the "Open" action */
   g_object_set_qdata (G_OBJECT (launcher->action_open), thunar_launcher_handler_quark, NULL);
 
-  /* determine the number of files/directories/executables */
-  for (lp = launcher->selected_files; lp != NULL; lp = lp->next, ++n_selected_files)
-    {
-      if (thunar_file_is_directory (lp->data)
-          || thunar_file_is_shortcut (lp->data)
-          || thunar_file_is_mountable (lp->data))
-        {
-          ++n_directories;
-        }
-      else
-        {
-          if (thunar_file_is_executable (lp->data))
-            ++n_executables;
-          ++n_regulars;
-        }
-    }
-
 G_GNUC_BEGIN_IGNORE_DEPRECATIONS
   /* Prepare "Open" label and icon */
   gtk_action_set_label (launcher->action_open, _("_Open"));
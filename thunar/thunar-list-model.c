@@ -52,6 +52,7 @@ enum
   PROP_NUM_FILES,
   PROP_SHOW_HIDDEN,
   PROP_FILE_SIZE_BINARY,
+  PROP_FREE_SPACE,
   N_PROPERTIES
 };
 
@@ -68,6 +69,15 @@ typedef gint (*ThunarSortFunc) (const ThunarFile *a,
                                 const ThunarFile *b,
                                 gboolean          case_sensitive);
 
+typedef struct _ThunarSortKey ThunarSortKey;
+typedef struct _ThunarRowInfo ThunarRowInfo;
+
+/* columns that are expensive to compare are sorted by keys, which are
+ * built once per file by a ThunarSortKeyFunc and cached in the model */
+typedef void (*ThunarSortKeyFunc) (const ThunarFile *file,
+                                   gboolean          case_sensitive,
+                                   ThunarSortKey    *key);
+
 
 
 static void               thunar_list_model_tree_model_init       (GtkTreeModelIface      *iface);
@@ -137,7 +147,31 @@ static gboolean           thunar_list_model_has_default_sort_func (GtkTreeSortab
 static gint               thunar_list_model_cmp_func              (gconstpointer           a,
                                                                    gconstpointer           b,
                                                                    gpointer                user_data);
+static gint               thunar_list_model_cmp_array_func        (gconstpointer           a,
+                                                                   gconstpointer           b,
+                                                                   gpointer                user_data);
+static gint               thunar_list_model_cmp_positions         (gconstpointer           a,
+                                                                   gconstpointer           b,
+                                                                   gpointer                user_data);
 static void               thunar_list_model_sort                  (ThunarListModel        *store);
+static void               thunar_list_model_sort_key_free         (gpointer                data);
+static void               thunar_list_model_row_info_free         (gpointer                data);
+static void               thunar_list_model_count_row_info        (ThunarListModel        *store,
+                                                                   ThunarRowInfo          *info,
+                                                                   gint                    delta);
+static void               thunar_list_model_fill_row_info         (ThunarRowInfo          *info,
+                                                                   ThunarFile             *file);
+static void               thunar_list_model_add_row_info          (ThunarListModel        *store,
+                                                                   ThunarFile             *file);
+static void               thunar_list_model_update_row_info       (ThunarListModel        *store,
+                                                                   ThunarFile             *file);
+static void               thunar_list_model_remove_row_info       (ThunarListModel        *store,
+                                                                   ThunarFile             *file);
+static void               thunar_list_model_clear_row_info        (ThunarListModel        *store);
+static void               thunar_list_model_update_free_space     (ThunarListModel        *store);
+static void               thunar_list_model_free_space_ready      (GObject                *object,
+                                                                   GAsyncResult           *result,
+                                                                   gpointer                user_data);
 static void               thunar_list_model_file_changed          (ThunarFileMonitor      *file_monitor,
                                                                    ThunarFile             *file,
                                                                    ThunarListModel        *store);
@@ -158,15 +192,6 @@ static gint               sort_by_date_accessed                   (const ThunarF
 static gint               sort_by_date_modified                   (const ThunarFile       *a,
                                                                    const ThunarFile       *b,
                                                                    gboolean                case_sensitive);
-static gint               sort_by_group                           (const ThunarFile       *a,
-                                                                   const ThunarFile       *b,
-                                                                   gboolean                case_sensitive);
-static gint               sort_by_mime_type                       (const ThunarFile       *a,
-                                                                   const ThunarFile       *b,
-                                                                   gboolean                case_sensitive);
-static gint               sort_by_owner                           (const ThunarFile       *a,
-                                                                   const ThunarFile       *b,
-                                                                   gboolean                case_sensitive);
 static gint               sort_by_permissions                     (const ThunarFile       *a,
                                                                    const ThunarFile       *b,
                                                                    gboolean                case_sensitive);
@@ -176,9 +201,18 @@ static gint               sort_by_size                            (const ThunarF
 static gint               sort_by_size_in_bytes                   (const ThunarFile       *a,
                                                                    const ThunarFile       *b,
                                                                    gboolean                case_sensitive);
-static gint               sort_by_type                            (const ThunarFile       *a,
-                                                                   const ThunarFile       *b,
-                                                                   gboolean                case_sensitive);
+static void               sort_key_for_group                      (const ThunarFile       *file,
+                                                                   gboolean                case_sensitive,
+                                                                   ThunarSortKey          *key);
+static void               sort_key_for_mime_type                  (const ThunarFile       *file,
+                                                                   gboolean                case_sensitive,
+                                                                   ThunarSortKey          *key);
+static void               sort_key_for_owner                      (const ThunarFile       *file,
+                                                                   gboolean                case_sensitive,
+                                                                   ThunarSortKey          *key);
+static void               sort_key_for_type                       (const ThunarFile       *file,
+                                                                   gboolean                case_sensitive,
+                                                                   ThunarSortKey          *key);
 
 static gboolean           thunar_list_model_get_case_sensitive    (ThunarListModel        *store);
 static void               thunar_list_model_set_case_sensitive    (ThunarListModel        *store,
@@ -216,6 +250,7 @@ struct _ThunarListModel
 #endif
 
   GSequence      *rows;
+  GHashTable     *rows_map;   /* ThunarFile -> GSequenceIter in rows */
   GSList         *hidden;
   ThunarFolder   *folder;
   gboolean        show_hidden : 1;
@@ -239,6 +274,45 @@ struct _ThunarListModel
   gboolean       sort_folders_first : 1;
   gint           sort_sign;   /* 1 = ascending, -1 descending */
   ThunarSortFunc sort_func;
+
+  /* if set, the rows are sorted by the keys in sort_keys
+   * (ThunarFile -> ThunarSortKey) instead of sort_func */
+  ThunarSortKeyFunc sort_key_func;
+  GHashTable       *sort_keys;
+
+  /* running totals of the rows for the statusbar, row_info remembers
+   * what every row added to them (ThunarFile -> ThunarRowInfo), so a
+   * row can be taken out again after the file changed */
+  GHashTable     *row_info;
+  guint           n_folders;
+  guint           n_non_folders;
+  guint64         size_summary;
+
+  /* the same totals for the selected rows, updated by the view
+   * with the files that were (un)selected */
+  guint           n_selected_folders;
+  guint           n_selected_non_folders;
+  guint64         selected_size_summary;
+
+  /* free space of the filesystem of the folder, queried asynchronously */
+  GCancellable   *free_space_cancellable;
+  guint64         free_space;
+  gboolean        free_space_valid : 1;
+  gboolean        free_space_outdated : 1;
+};
+
+struct _ThunarSortKey
+{
+  gchar   *name;   /* description, content type, owner or group name */
+  guint32  id;     /* uid or gid, used if the name is not known */
+  gboolean valid;  /* FALSE if the file has no info to sort by */
+};
+
+struct _ThunarRowInfo
+{
+  guint64  size;
+  gboolean is_folder;
+  gboolean selected;
 };
 
 
@@ -363,6 +437,19 @@ thunar_list_model_class_init (ThunarListModelClass *klass)
                             TRUE,
                             EXO_PARAM_READWRITE);
 
+  /**
+   * ThunarListModel::free-space:
+   *
+   * The free space on the filesystem of the folder presented by
+   * this #ThunarListModel, or 0 if it is not known (yet).
+   **/
+  list_model_props[PROP_FREE_SPACE] =
+      g_param_spec_uint64 ("free-space",
+                           "free-space",
+                           "free-space",
+                           0, G_MAXUINT64, 0,
+                           EXO_PARAM_READABLE);
+
   /* install properties */
   g_object_class_install_properties (gobject_class, N_PROPERTIES, list_model_props);
 
@@ -441,7 +528,10 @@ thunar_list_model_init (ThunarListModel *store)
   store->sort_folders_first = TRUE;
   store->sort_sign = 1;
   store->sort_func = thunar_file_compare_by_name;
+  store->sort_keys = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, thunar_list_model_sort_key_free);
   store->rows = g_sequence_new (g_object_unref);
+  store->rows_map = g_hash_table_new (g_direct_hash, g_direct_equal);
+  store->row_info = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, thunar_list_model_row_info_free);
 
   /* connect to the shared ThunarFileMonitor, so we don't need to
    * connect "changed" to every single ThunarFile we own.
@@ -470,6 +560,9 @@ thunar_list_model_finalize (GObject *object)
   ThunarListModel *store = THUNAR_LIST_MODEL (object);
 
   g_sequence_free (store->rows);
+  g_hash_table_destroy (store->rows_map);
+  g_hash_table_destroy (store->row_info);
+  g_hash_table_destroy (store->sort_keys);
 
   /* disconnect from the file monitor */
   g_signal_handlers_disconnect_by_func (G_OBJECT (store->file_monitor), thunar_list_model_file_changed, store);
@@ -522,6 +615,10 @@ thunar_list_model_get_property (GObject    *object,
       g_value_set_boolean (value, thunar_list_model_get_file_size_binary (store));
       break;
 
+    case PROP_FREE_SPACE:
+      g_value_set_uint64 (value, store->free_space_valid ? store->free_space : 0);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -737,7 +834,7 @@ thunar_list_model_get_value (GtkTreeModel *model,
 
     case THUNAR_COLUMN_MIME_TYPE:
       g_value_init (value, G_TYPE_STRING);
-      g_value_set_static_string (value, thunar_file_get_content_type (file));
+      g_value_set_static_string (value, thunar_file_peek_content_type (file));
       break;
 
     case THUNAR_COLUMN_NAME:
@@ -792,7 +889,7 @@ thunar_list_model_get_value (GtkTreeModel *model,
         g_value_take_string (value, g_strdup_printf (_("link to %s"), thunar_file_get_symlink_target (file)));
       else
         {
-          content_type = thunar_file_get_content_type (file);
+          content_type = thunar_file_peek_content_type (file);
           if (content_type != NULL)
             g_value_take_string (value, g_content_type_get_description (content_type));
         }
@@ -937,7 +1034,7 @@ thunar_list_model_get_sort_column_id (GtkTreeSortable *sortable,
 
   _thunar_return_val_if_fail (THUNAR_IS_LIST_MODEL (store), FALSE);
 
-  if (store->sort_func == sort_by_mime_type)
+  if (store->sort_key_func == sort_key_for_mime_type)
     *sort_column_id = THUNAR_COLUMN_MIME_TYPE;
   else if (store->sort_func == thunar_file_compare_by_name)
     *sort_column_id = THUNAR_COLUMN_NAME;
@@ -951,11 +1048,11 @@ thunar_list_model_get_sort_column_id (GtkTreeSortable *sortable,
     *sort_column_id = THUNAR_COLUMN_DATE_ACCESSED;
   else if (store->sort_func == sort_by_date_modified)
     *sort_column_id = THUNAR_COLUMN_DATE_MODIFIED;
-  else if (store->sort_func == sort_by_type)
+  else if (store->sort_key_func == sort_key_for_type)
     *sort_column_id = THUNAR_COLUMN_TYPE;
-  else if (store->sort_func == sort_by_owner)
+  else if (store->sort_key_func == sort_key_for_owner)
     *sort_column_id = THUNAR_COLUMN_OWNER;
-  else if (store->sort_func == sort_by_group)
+  else if (store->sort_key_func == sort_key_for_group)
     *sort_column_id = THUNAR_COLUMN_GROUP;
   else
     _thunar_assert_not_reached ();
@@ -982,6 +1079,9 @@ thunar_list_model_set_sort_column_id (GtkTreeSortable *sortable,
 
   _thunar_return_if_fail (THUNAR_IS_LIST_MODEL (store));
 
+  store->sort_func = NULL;
+  store->sort_key_func = NULL;
+
   switch (sort_column_id)
     {
     case THUNAR_COLUMN_DATE_ACCESSED:
@@ -993,11 +1093,11 @@ thunar_list_model_set_sort_column_id (GtkTreeSortable *sortable,
       break;
 
     case THUNAR_COLUMN_GROUP:
-      store->sort_func = sort_by_group;
+      store->sort_key_func = sort_key_for_group;
       break;
 
     case THUNAR_COLUMN_MIME_TYPE:
-      store->sort_func = sort_by_mime_type;
+      store->sort_key_func = sort_key_for_mime_type;
       break;
 
     case THUNAR_COLUMN_FILE_NAME:
@@ -1006,7 +1106,7 @@ thunar_list_model_set_sort_column_id (GtkTreeSortable *sortable,
       break;
 
     case THUNAR_COLUMN_OWNER:
-      store->sort_func = sort_by_owner;
+      store->sort_key_func = sort_key_for_owner;
       break;
 
     case THUNAR_COLUMN_PERMISSIONS:
@@ -1022,13 +1122,16 @@ thunar_list_model_set_sort_column_id (GtkTreeSortable *sortable,
       break;
 
     case THUNAR_COLUMN_TYPE:
-      store->sort_func = sort_by_type;
+      store->sort_key_func = sort_key_for_type;
       break;
 
     default:
       _thunar_assert_not_reached ();
     }
 
+  /* the cached keys belong to the previous column */
+  g_hash_table_remove_all (store->sort_keys);
+
   /* new sort sign */
   store->sort_sign = (order == GTK_SORT_ASCENDING) ? 1 : -1;
 
@@ -1072,6 +1175,70 @@ thunar_list_model_has_default_sort_func (GtkTreeSortable *sortable)
 
 
 
+static void
+thunar_list_model_sort_key_free (gpointer data)
+{
+  ThunarSortKey *key = data;
+
+  g_free (key->name);
+  g_slice_free (ThunarSortKey, key);
+}
+
+
+
+static const ThunarSortKey*
+thunar_list_model_get_sort_key (ThunarListModel  *store,
+                                const ThunarFile *file)
+{
+  ThunarSortKey *key;
+
+  /* build the key on-demand */
+  key = g_hash_table_lookup (store->sort_keys, file);
+  if (G_UNLIKELY (key == NULL))
+    {
+      key = g_slice_new0 (ThunarSortKey);
+      (*store->sort_key_func) (file, store->sort_case_sensitive, key);
+      g_hash_table_insert (store->sort_keys, (gpointer) file, key);
+    }
+
+  return key;
+}
+
+
+
+static gint
+thunar_list_model_cmp_sort_keys (ThunarListModel  *store,
+                                 const ThunarFile *a,
+                                 const ThunarFile *b)
+{
+  const ThunarSortKey *key_a;
+  const ThunarSortKey *key_b;
+  gint                 result;
+
+  key_a = thunar_list_model_get_sort_key (store, a);
+  key_b = thunar_list_model_get_sort_key (store, b);
+
+  if (!key_a->valid || !key_b->valid)
+    return thunar_file_compare_by_name (a, b, store->sort_case_sensitive);
+
+  /* the names are already folded for case-insensitive sorting, files
+   * without a name (e.g. without a description) always come first, so
+   * the order does not depend on which files they are compared to */
+  if (key_a->name != NULL && key_b->name != NULL)
+    result = strcmp (key_a->name, key_b->name);
+  else if (key_a->name != NULL || key_b->name != NULL)
+    result = (key_a->name == NULL) ? -1 : 1;
+  else
+    result = CLAMP ((gint) key_a->id - (gint) key_b->id, -1, 1);
+
+  if (result == 0)
+    return thunar_file_compare_by_name (a, b, store->sort_case_sensitive);
+  else
+    return result;
+}
+
+
+
 static gint
 thunar_list_model_cmp_func (gconstpointer a,
                             gconstpointer b,
@@ -1092,11 +1259,34 @@ thunar_list_model_cmp_func (gconstpointer a,
         return isdir_a ? -1 : 1;
     }
 
+  if (store->sort_key_func != NULL)
+    return thunar_list_model_cmp_sort_keys (store, a, b) * store->sort_sign;
+
   return (*store->sort_func) (a, b, store->sort_case_sensitive) * store->sort_sign;
 }
 
 
 
+static gint
+thunar_list_model_cmp_array_func (gconstpointer a,
+                                  gconstpointer b,
+                                  gpointer      user_data)
+{
+  return thunar_list_model_cmp_func (*(ThunarFile *const *) a, *(ThunarFile *const *) b, user_data);
+}
+
+
+
+static gint
+thunar_list_model_cmp_positions (gconstpointer a,
+                                 gconstpointer b,
+                                 gpointer      user_data)
+{
+  return *((const gint *) a) - *((const gint *) b);
+}
+
+
+
 static void
 thunar_list_model_sort (ThunarListModel *store)
 {
@@ -1155,15 +1345,214 @@ thunar_list_model_sort (ThunarListModel *store)
 
 
 
+static void
+thunar_list_model_row_info_free (gpointer data)
+{
+  g_slice_free (ThunarRowInfo, data);
+}
+
+
+
+static void
+thunar_list_model_count_row_info (ThunarListModel *store,
+                                  ThunarRowInfo   *info,
+                                  gint             delta)
+{
+  /* add (delta = 1) or take out (delta = -1) what the row adds to the totals */
+  if (info->is_folder)
+    store->n_folders += delta;
+  else
+    store->n_non_folders += delta;
+  if (delta > 0)
+    store->size_summary += info->size;
+  else
+    store->size_summary -= info->size;
+
+  if (info->selected)
+    {
+      if (info->is_folder)
+        store->n_selected_folders += delta;
+      else
+        store->n_selected_non_folders += delta;
+      if (delta > 0)
+        store->selected_size_summary += info->size;
+      else
+        store->selected_size_summary -= info->size;
+    }
+}
+
+
+
+static void
+thunar_list_model_fill_row_info (ThunarRowInfo *info,
+                                 ThunarFile    *file)
+{
+  info->is_folder = thunar_file_is_directory (file);
+  info->size = 0;
+  if (!info->is_folder && thunar_file_is_regular (file))
+    info->size = thunar_file_get_size (file);
+}
+
+
+
+static void
+thunar_list_model_add_row_info (ThunarListModel *store,
+                                ThunarFile      *file)
+{
+  ThunarRowInfo *info;
+
+  /* remember what the file adds to the totals */
+  info = g_slice_new0 (ThunarRowInfo);
+  thunar_list_model_fill_row_info (info, file);
+  g_hash_table_insert (store->row_info, file, info);
+
+  thunar_list_model_count_row_info (store, info, 1);
+}
+
+
+
+static void
+thunar_list_model_update_row_info (ThunarListModel *store,
+                                   ThunarFile      *file)
+{
+  ThunarRowInfo *info;
+
+  info = g_hash_table_lookup (store->row_info, file);
+  _thunar_assert (info != NULL);
+
+  /* the file keeps its selected state */
+  thunar_list_model_count_row_info (store, info, -1);
+  thunar_list_model_fill_row_info (info, file);
+  thunar_list_model_count_row_info (store, info, 1);
+}
+
+
+
+static void
+thunar_list_model_remove_row_info (ThunarListModel *store,
+                                   ThunarFile      *file)
+{
+  ThunarRowInfo *info;
+
+  info = g_hash_table_lookup (store->row_info, file);
+  _thunar_assert (info != NULL);
+
+  thunar_list_model_count_row_info (store, info, -1);
+
+  g_hash_table_remove (store->row_info, file);
+}
+
+
+
+static void
+thunar_list_model_clear_row_info (ThunarListModel *store)
+{
+  g_hash_table_remove_all (store->row_info);
+  store->n_folders = 0;
+  store->n_non_folders = 0;
+  store->size_summary = 0;
+  store->n_selected_folders = 0;
+  store->n_selected_non_folders = 0;
+  store->selected_size_summary = 0;
+}
+
+
+
+static void
+thunar_list_model_update_free_space (ThunarListModel *store)
+{
+  ThunarFile *file;
+
+  /* only one query at a time, the running one is restarted when done */
+  if (store->free_space_cancellable != NULL)
+    {
+      store->free_space_outdated = TRUE;
+      return;
+    }
+
+  /* try to determine a file for the current folder */
+  file = (store->folder != NULL) ? thunar_folder_get_corresponding_file (store->folder) : NULL;
+  if (G_UNLIKELY (file == NULL))
+    return;
+
+  store->free_space_outdated = FALSE;
+  store->free_space_cancellable = g_cancellable_new ();
+
+  /* the callback holds a reference on the store */
+  g_file_query_filesystem_info_async (thunar_file_get_file (file),
+                                      G_FILE_ATTRIBUTE_FILESYSTEM_FREE,
+                                      G_PRIORITY_LOW,
+                                      store->free_space_cancellable,
+                                      thunar_list_model_free_space_ready,
+                                      g_object_ref (store));
+}
+
+
+
+static void
+thunar_list_model_free_space_ready (GObject      *object,
+                                    GAsyncResult *result,
+                                    gpointer      user_data)
+{
+  ThunarListModel *store = THUNAR_LIST_MODEL (user_data);
+  GFileInfo       *info;
+  GError          *error = NULL;
+  guint64          free_space;
+
+  info = g_file_query_filesystem_info_finish (G_FILE (object), result, &error);
+  if (G_UNLIKELY (info == NULL))
+    {
+      /* the query was cancelled if the folder changed, in which
+       * case a query for the new folder may be running already */
+      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        {
+          g_clear_object (&store->free_space_cancellable);
+          if (store->free_space_valid)
+            {
+              store->free_space_valid = FALSE;
+              g_object_notify_by_pspec (G_OBJECT (store), list_model_props[PROP_FREE_SPACE]);
+            }
+        }
+
+      g_error_free (error);
+      g_object_unref (store);
+      return;
+    }
+
+  g_clear_object (&store->free_space_cancellable);
+
+  if (g_file_info_has_attribute (info, G_FILE_ATTRIBUTE_FILESYSTEM_FREE))
+    {
+      /* only notify the views if the value actually changed */
+      free_space = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_FILESYSTEM_FREE);
+      if (!store->free_space_valid || store->free_space != free_space)
+        {
+          store->free_space = free_space;
+          store->free_space_valid = TRUE;
+          g_object_notify_by_pspec (G_OBJECT (store), list_model_props[PROP_FREE_SPACE]);
+        }
+    }
+
+  g_object_unref (info);
+
+  /* the folder changed while we were busy */
+  if (store->free_space_outdated)
+    thunar_list_model_update_free_space (store);
+
+  g_object_unref (store);
+}
+
+
+
 static void
 thunar_list_model_file_changed (ThunarFileMonitor *file_monitor,
                                 ThunarFile        *file,
                                 ThunarListModel   *store)
 {
   GSequenceIter *row;
-  GSequenceIter *end;
+  guint64        size_summary;
   gint           pos_after;
-  gint           pos_before = 0;
+  gint           pos_before;
   gint          *new_order;
   gint           length;
   gint           i, j;
@@ -1174,65 +1563,67 @@ thunar_list_model_file_changed (ThunarFileMonitor *file_monitor,
   _thunar_return_if_fail (THUNAR_IS_LIST_MODEL (store));
   _thunar_return_if_fail (THUNAR_IS_FILE (file));
 
-  row = g_sequence_get_begin_iter (store->rows);
-  end = g_sequence_get_end_iter (store->rows);
+  /* the sort key of the file is outdated now */
+  g_hash_table_remove (store->sort_keys, file);
 
-  while (row != end)
-    {
-      if (G_UNLIKELY (g_sequence_get (row) == file))
-        {
-          /* generate the iterator for this row */
-          GTK_TREE_ITER_INIT (iter, store->stamp, row);
+  /* check if the file is shown in the model */
+  row = g_hash_table_lookup (store->rows_map, file);
+  if (row == NULL)
+    return;
 
-          _thunar_assert (pos_before == g_sequence_iter_get_position (row));
+  /* the size or type of the file may have changed, files also
+   * change for other reasons (e.g. a new thumbnail), so only query
+   * the free space again if the size of the file is different */
+  size_summary = store->size_summary;
+  thunar_list_model_update_row_info (store, file);
+  if (store->size_summary != size_summary)
+    thunar_list_model_update_free_space (store);
+
+  /* generate the iterator for this row */
+  GTK_TREE_ITER_INIT (iter, store->stamp, row);
+
+  /* check if the sorting changed */
+  pos_before = g_sequence_iter_get_position (row);
+  g_sequence_sort_changed (row, thunar_list_model_cmp_func, store);
+  pos_after = g_sequence_iter_get_position (row);
+  if (pos_after != pos_before)
+    {
+      /* do swap sorting here since its much faster than a complete sort */
+      length = g_sequence_get_length (store->rows);
+      if (G_LIKELY (length < 2000))
+        new_order = g_newa (gint, length);
+      else
+        new_order = g_new (gint, length);
 
-          /* check if the sorting changed */
-          g_sequence_sort_changed (row, thunar_list_model_cmp_func, store);
-          pos_after = g_sequence_iter_get_position (row);
-          if (pos_after != pos_before)
+      /* new_order[newpos] = oldpos */
+      for (i = 0, j = 0; i < length; ++i)
+        {
+          if (G_UNLIKELY (i == pos_after))
             {
-              /* do swap sorting here since its much faster than a complete sort */
-              length = g_sequence_get_length (store->rows);
-              if (G_LIKELY (length < 2000))
-                new_order = g_newa (gint, length);
-              else
-                new_order = g_new (gint, length);
-
-              /* new_order[newpos] = oldpos */
-              for (i = 0, j = 0; i < length; ++i)
-                {
-                  if (G_UNLIKELY (i == pos_after))
-                    {
-                      new_order[i] = pos_before;
-                    }
-                  else
-                    {
-                      if (G_UNLIKELY (j == pos_before))
-                        j++;
-                      new_order[i] = j++;
-                    }
-                }
-
-              /* tell the view about the new item order */
-              path = gtk_tree_path_new_first ();
-              gtk_tree_model_rows_reordered (GTK_TREE_MODEL (store), path, NULL, new_order);
-              gtk_tree_path_free (path);
-
-              /* clean up if we used the heap */
-              if (G_UNLIKELY (length >= 2000))
-                g_free (new_order);
+              new_order[i] = pos_before;
+            }
+          else
+            {
+              if (G_UNLIKELY (j == pos_before))
+                j++;
+              new_order[i] = j++;
             }
-
-          /* notify the view that it has to redraw the file */
-          path = gtk_tree_path_new_from_indices (pos_before, -1);
-          gtk_tree_model_row_changed (GTK_TREE_MODEL (store), path, &iter);
-          gtk_tree_path_free (path);
-          break;
         }
 
-      row = g_sequence_iter_next (row);
-      pos_before++;
+      /* tell the view about the new item order */
+      path = gtk_tree_path_new_first ();
+      gtk_tree_model_rows_reordered (GTK_TREE_MODEL (store), path, NULL, new_order);
+      gtk_tree_path_free (path);
+
+      /* clean up if we used the heap */
+      if (G_UNLIKELY (length >= 2000))
+        g_free (new_order);
     }
+
+  /* notify the view that it has to redraw the file */
+  path = gtk_tree_path_new_from_indices (pos_before, -1);
+  gtk_tree_model_row_changed (GTK_TREE_MODEL (store), path, &iter);
+  gtk_tree_path_free (path);
 }
 
 
@@ -1274,13 +1665,35 @@ thunar_list_model_files_added (ThunarFolder    *folder,
                                GList           *files,
                                ThunarListModel *store)
 {
-  GtkTreePath   *path;
-  GtkTreeIter    iter;
-  ThunarFile    *file;
-  gint          *indices;
-  GSequenceIter *row;
-  GList         *lp;
-  gboolean       has_handler;
+  GtkTreePath    *path;
+  GtkTreeIter     iter;
+  ThunarFile     *file;
+  ThunarFile    **visible;
+  gint           *indices;
+  GSequenceIter  *row;
+  GSequenceIter  *new_row;
+  GSequenceIter  *end;
+  GList          *lp;
+  gboolean        has_handler;
+  guint           n_visible = 0;
+  guint           n;
+  gint            length;
+  gint            position;
+
+  /* collect the files to insert, hidden files are only remembered */
+  visible = g_new (ThunarFile *, g_list_length (files));
+  for (lp = files; lp != NULL; lp = lp->next)
+    {
+      /* take a reference on that file */
+      file = THUNAR_FILE (g_object_ref (G_OBJECT (lp->data)));
+      _thunar_assert (THUNAR_IS_FILE (file));
+
+      /* check if the file should be hidden */
+      if (!store->show_hidden && thunar_file_is_hidden (file))
+        store->hidden = g_slist_prepend (store->hidden, file);
+      else
+        visible[n_visible++] = file;
+    }
 
   /* we use a simple trick here to avoid allocating
    * GtkTreePath's again and again, by simply accessing
@@ -1293,23 +1706,53 @@ thunar_list_model_files_added (ThunarFolder    *folder,
   /* check if we have any handlers connected for "row-inserted" */
   has_handler = g_signal_has_handler_pending (G_OBJECT (store), store->row_inserted_id, 0, FALSE);
 
-  /* process all added files */
-  for (lp = files; lp != NULL; lp = lp->next)
+  /* inserting the files one by one costs a binary search for each
+   * file, so for large batches (compared to the number of rows, e.g.
+   * when loading a folder) it is cheaper to sort the batch and merge
+   * it into the rows in a single pass, which also yields the position
+   * of every new row for free */
+  length = g_sequence_get_length (store->rows);
+  if (n_visible * g_bit_storage (length) >= (guint) length)
     {
-      /* take a reference on that file */
-      file = THUNAR_FILE (g_object_ref (G_OBJECT (lp->data)));
-      _thunar_return_if_fail (THUNAR_IS_FILE (file));
+      g_qsort_with_data (visible, n_visible, sizeof (ThunarFile *),
+                         thunar_list_model_cmp_array_func, store);
 
-      /* check if the file should be hidden */
-      if (!store->show_hidden && thunar_file_is_hidden (file))
+      row = g_sequence_get_begin_iter (store->rows);
+      end = g_sequence_get_end_iter (store->rows);
+
+      for (n = 0, position = 0; n < n_visible; ++n, ++position)
         {
-          store->hidden = g_slist_prepend (store->hidden, file);
+          /* skip the rows sorted before the file */
+          while (row != end && thunar_list_model_cmp_func (g_sequence_get (row), visible[n], store) <= 0)
+            {
+              row = g_sequence_iter_next (row);
+              position++;
+            }
+
+          /* insert the file in front of the row */
+          new_row = g_sequence_insert_before (row, visible[n]);
+          g_hash_table_insert (store->rows_map, visible[n], new_row);
+          thunar_list_model_add_row_info (store, visible[n]);
+
+          if (has_handler)
+            {
+              /* generate an iterator for the new item */
+              GTK_TREE_ITER_INIT (iter, store->stamp, new_row);
+
+              indices[0] = position;
+              gtk_tree_model_row_inserted (GTK_TREE_MODEL (store), path, &iter);
+            }
         }
-      else
+    }
+  else
+    {
+      for (n = 0; n < n_visible; ++n)
         {
           /* insert the file */
-          row = g_sequence_insert_sorted (store->rows, file,
+          row = g_sequence_insert_sorted (store->rows, visible[n],
                                           thunar_list_model_cmp_func, store);
+          g_hash_table_insert (store->rows_map, visible[n], row);
+          thunar_list_model_add_row_info (store, visible[n]);
 
           if (has_handler)
             {
@@ -1324,6 +1767,10 @@ thunar_list_model_files_added (ThunarFolder    *folder,
 
   /* release the path */
   gtk_tree_path_free (path);
+  g_free (visible);
+
+  /* the files probably took some space */
+  thunar_list_model_update_free_space (store);
 
   /* number of visible files may have changed */
   g_object_notify_by_pspec (G_OBJECT (store), list_model_props[PROP_NUM_FILES]);
@@ -1336,56 +1783,102 @@ thunar_list_model_files_removed (ThunarFolder    *folder,
                                  GList           *files,
                                  ThunarListModel *store)
 {
+  GHashTable    *removed;
   GList         *lp;
   GSequenceIter *row;
   GSequenceIter *end;
   GSequenceIter *next;
   GtkTreePath   *path;
-  gboolean       found;
+  ThunarFile    *file;
+  gint          *indices;
+  gint           length;
+  guint          n_removed;
+
+  /* same trick as in thunar_list_model_files_added() */
+  path = gtk_tree_path_new_first ();
+  indices = gtk_tree_path_get_indices (path);
 
-  /* drop all the referenced files from the model */
+  /* collect the rows to remove */
+  removed = g_hash_table_new (g_direct_hash, g_direct_equal);
   for (lp = files; lp != NULL; lp = lp->next)
+    {
+      /* forget the sort key of the file */
+      g_hash_table_remove (store->sort_keys, lp->data);
+
+      row = g_hash_table_lookup (store->rows_map, lp->data);
+      if (row != NULL)
+        {
+          g_hash_table_insert (removed, lp->data, row);
+        }
+      else
+        {
+          /* file is hidden */
+          _thunar_assert (g_slist_find (store->hidden, lp->data) != NULL);
+          store->hidden = g_slist_remove (store->hidden, lp->data);
+          g_object_unref (G_OBJECT (lp->data));
+        }
+    }
+
+  /* looking up the position of every row costs a tree walk per file,
+   * so for large batches it is cheaper to remove all rows in a single
+   * pass over the model, which yields the positions for free */
+  length = g_sequence_get_length (store->rows);
+  n_removed = g_hash_table_size (removed);
+  if (n_removed * g_bit_storage (length) >= (guint) length)
     {
       row = g_sequence_get_begin_iter (store->rows);
       end = g_sequence_get_end_iter (store->rows);
 
-      found = FALSE;
-
-      while (row != end)
+      for (indices[0] = 0; n_removed > 0 && row != end; row = next)
         {
           next = g_sequence_iter_next (row);
 
-          if (g_sequence_get (row) == lp->data)
+          file = g_sequence_get (row);
+          if (g_hash_table_lookup (removed, file) != NULL)
             {
-              /* setup path for "row-deleted" */
-              path = gtk_tree_path_new_from_indices (g_sequence_iter_get_position (row), -1);
-
               /* remove file from the model */
+              thunar_list_model_remove_row_info (store, file);
+              g_hash_table_remove (store->rows_map, file);
               g_sequence_remove (row);
+              n_removed--;
 
-              /* notify the view(s) */
+              /* notify the view(s), the next row takes over the position */
               gtk_tree_model_row_deleted (GTK_TREE_MODEL (store), path);
-              gtk_tree_path_free (path);
-
-              /* no need to look in the hidden files */
-              found = TRUE;
-
-              break;
             }
-
-          row = next;
+          else
+            {
+              indices[0]++;
+            }
         }
-
-      /* check if the file was found */
-      if (!found)
+    }
+  else
+    {
+      for (lp = files; lp != NULL; lp = lp->next)
         {
-          /* file is hidden */
-          _thunar_assert (g_slist_find (store->hidden, lp->data) != NULL);
-          store->hidden = g_slist_remove (store->hidden, lp->data);
-          g_object_unref (G_OBJECT (lp->data));
+          row = g_hash_table_lookup (removed, lp->data);
+          if (row == NULL)
+            continue;
+
+          /* setup path for "row-deleted" */
+          indices[0] = g_sequence_iter_get_position (row);
+
+          /* remove file from the model */
+          g_hash_table_remove (removed, lp->data);
+          thunar_list_model_remove_row_info (store, lp->data);
+          g_hash_table_remove (store->rows_map, lp->data);
+          g_sequence_remove (row);
+
+          /* notify the view(s) */
+          gtk_tree_model_row_deleted (GTK_TREE_MODEL (store), path);
         }
     }
 
+  g_hash_table_destroy (removed);
+  gtk_tree_path_free (path);
+
+  /* the files probably freed some space */
+  thunar_list_model_update_free_space (store);
+
   /* this probably changed */
   g_object_notify_by_pspec (G_OBJECT (store), list_model_props[PROP_NUM_FILES]);
 }
@@ -1434,130 +1927,77 @@ sort_by_date_modified (const ThunarFile *a,
 
 
 
-static gint
-sort_by_group (const ThunarFile *a,
-               const ThunarFile *b,
-               gboolean          case_sensitive)
+static void
+sort_key_for_group (const ThunarFile *file,
+                    gboolean          case_sensitive,
+                    ThunarSortKey    *key)
 {
-  ThunarGroup *group_a;
-  ThunarGroup *group_b;
-  guint32      gid_a;
-  guint32      gid_b;
-  gint         result;
-  const gchar *name_a;
-  const gchar *name_b;
+  ThunarGroup *group;
 
-  if (thunar_file_get_info (a) == NULL || thunar_file_get_info (b) == NULL)
-    return thunar_file_compare_by_name (a, b, case_sensitive);
+  if (thunar_file_get_info (file) == NULL)
+    return;
 
-  group_a = thunar_file_get_group (a);
-  group_b = thunar_file_get_group (b);
+  key->valid = TRUE;
+  key->id = g_file_info_get_attribute_uint32 (thunar_file_get_info (file),
+                                              G_FILE_ATTRIBUTE_UNIX_GID);
 
-  if (group_a != NULL && group_b != NULL)
+  group = thunar_file_get_group (file);
+  if (group != NULL)
     {
-      name_a = thunar_group_get_name (group_a);
-      name_b = thunar_group_get_name (group_b);
-
       if (!case_sensitive)
-        result = strcasecmp (name_a, name_b);
+        key->name = g_ascii_strdown (thunar_group_get_name (group), -1);
       else
-        result = strcmp (name_a, name_b);
-    }
-  else
-    {
-      gid_a = g_file_info_get_attribute_uint32 (thunar_file_get_info (a),
-                                                G_FILE_ATTRIBUTE_UNIX_GID);
-      gid_b = g_file_info_get_attribute_uint32 (thunar_file_get_info (b),
-                                                G_FILE_ATTRIBUTE_UNIX_GID);
+        key->name = g_strdup (thunar_group_get_name (group));
 
-      result = CLAMP ((gint) gid_a - (gint) gid_b, -1, 1);
+      g_object_unref (group);
     }
-
-  if (group_a != NULL)
-    g_object_unref (group_a);
-
-  if (group_b != NULL)
-    g_object_unref (group_b);
-
-  if (result == 0)
-    return thunar_file_compare_by_name (a, b, case_sensitive);
-  else
-    return result;
 }
 
 
 
-static gint
-sort_by_mime_type (const ThunarFile *a,
-                   const ThunarFile *b,
-                   gboolean          case_sensitive)
+static void
+sort_key_for_mime_type (const ThunarFile *file,
+                        gboolean          case_sensitive,
+                        ThunarSortKey    *key)
 {
-  const gchar *content_type_a;
-  const gchar *content_type_b;
-  gint         result;
-
-  content_type_a = thunar_file_get_content_type (THUNAR_FILE (a));
-  content_type_b = thunar_file_get_content_type (THUNAR_FILE (b));
-
-  if (content_type_a == NULL)
-    content_type_a = "";
-  if (content_type_b == NULL)
-    content_type_b = "";
-
-  result = strcasecmp (content_type_a, content_type_b);
+  const gchar *content_type;
 
-  if (result == 0)
-    result = thunar_file_compare_by_name (a, b, case_sensitive);
+  content_type = thunar_file_peek_content_type (THUNAR_FILE (file));
+  if (content_type == NULL)
+    content_type = "";
 
-  return result;
+  /* content types are always compared case-insensitive */
+  key->valid = TRUE;
+  key->name = g_ascii_strdown (content_type, -1);
 }
 
 
 
-static gint
-sort_by_owner (const ThunarFile *a,
-               const ThunarFile *b,
-               gboolean          case_sensitive)
+static void
+sort_key_for_owner (const ThunarFile *file,
+                    gboolean          case_sensitive,
+                    ThunarSortKey    *key)
 {
-  const gchar *name_a;
-  const gchar *name_b;
-  ThunarUser  *user_a;
-  ThunarUser  *user_b;
-  guint32      uid_a;
-  guint32      uid_b;
-  gint         result;
+  ThunarUser *user;
 
-  if (thunar_file_get_info (a) == NULL || thunar_file_get_info (b) == NULL)
-    return thunar_file_compare_by_name (a, b, case_sensitive);
+  if (thunar_file_get_info (file) == NULL)
+    return;
 
-  user_a = thunar_file_get_user (a);
-  user_b = thunar_file_get_user (b);
+  key->valid = TRUE;
+  key->id = g_file_info_get_attribute_uint32 (thunar_file_get_info (file),
+                                              G_FILE_ATTRIBUTE_UNIX_UID);
 
-  if (user_a != NULL && user_b != NULL)
+  user = thunar_file_get_user (file);
+  if (user != NULL)
     {
       /* compare the system names */
-      name_a = thunar_user_get_name (user_a);
-      name_b = thunar_user_get_name (user_b);
-
       if (!case_sensitive)
-        result = strcasecmp (name_a, name_b);
+        key->name = g_ascii_strdown (thunar_user_get_name (user), -1);
       else
-        result = strcmp (name_a, name_b);
-    }
-  else
-    {
-      uid_a = g_file_info_get_attribute_uint32 (thunar_file_get_info (a),
-                                                G_FILE_ATTRIBUTE_UNIX_UID);
-      uid_b = g_file_info_get_attribute_uint32 (thunar_file_get_info (b),
-                                                G_FILE_ATTRIBUTE_UNIX_UID);
+        key->name = g_strdup (thunar_user_get_name (user));
 
-      result = CLAMP ((gint) uid_a - (gint) uid_b, -1, 1);
+      g_object_unref (user);
     }
-
-  if (result == 0)
-    return thunar_file_compare_by_name (a, b, case_sensitive);
-  else
-    return result;
 }
 
 
@@ -1614,63 +2054,36 @@ sort_by_size_in_bytes (const ThunarFile *a,
 
 
 
-static gint
-sort_by_type (const ThunarFile *a,
-              const ThunarFile *b,
-              gboolean          case_sensitive)
+static void
+sort_key_for_type (const ThunarFile *file,
+                   gboolean          case_sensitive,
+                   ThunarSortKey    *key)
 {
-  const gchar *content_type_a;
-  const gchar *content_type_b;
-  gchar       *description_a = NULL;
-  gchar       *description_b = NULL;
-  gint         result;
+  gchar *description;
 
   /* we alter the description of symlinks here because they are
    * displayed as "link to ..." in the detailed list view as well */
-
-  if (thunar_file_is_symlink (a))
+  if (thunar_file_is_symlink (file))
     {
-      description_a = g_strdup_printf (_("link to %s"),
-                                       thunar_file_get_symlink_target (a));
+      description = g_strdup_printf (_("link to %s"),
+                                     thunar_file_get_symlink_target (file));
     }
   else
     {
-      content_type_a = thunar_file_get_content_type (THUNAR_FILE (a));
-      description_a = g_content_type_get_description (content_type_a);
+      description = g_content_type_get_description (thunar_file_peek_content_type (THUNAR_FILE (file)));
     }
 
-  if (thunar_file_is_symlink (b))
+  key->valid = TRUE;
+
+  if (description != NULL && !case_sensitive)
     {
-      description_b = g_strdup_printf (_("link to %s"),
-                                       thunar_file_get_symlink_target (b));
+      key->name = g_ascii_strdown (description, -1);
+      g_free (description);
     }
   else
     {
-      content_type_b = thunar_file_get_content_type (THUNAR_FILE (b));
-      description_b = g_content_type_get_description (content_type_b);
+      key->name = description;
     }
-
-  /* avoid calling strcasecmp with NULL parameters */
-  if (description_a == NULL || description_b == NULL)
-    {
-      g_free (description_a);
-      g_free (description_b);
-
-      return 0;
-    }
-
-  if (!case_sensitive)
-    result = strcasecmp (description_a, description_b);
-  else
-    result = strcmp (description_a, description_b);
-
-  g_free (description_a);
-  g_free (description_b);
-
-  if (result == 0)
-    return thunar_file_compare_by_name (a, b, case_sensitive);
-  else
-    return result;
 }
 
 
@@ -1732,6 +2145,9 @@ thunar_list_model_set_case_sensitive (ThunarListModel *store,
       /* apply the new setting */
       store->sort_case_sensitive = case_sensitive;
 
+      /* the sort keys depend on the case-sensitivity */
+      g_hash_table_remove_all (store->sort_keys);
+
       /* resort the model with the new setting */
       thunar_list_model_sort (store);
 
@@ -1888,6 +2304,11 @@ thunar_list_model_set_folder (ThunarListModel *store,
       row = g_sequence_get_begin_iter (store->rows);
       end = g_sequence_get_end_iter (store->rows);
 
+      /* forget the sort keys and rows of the files */
+      g_hash_table_remove_all (store->sort_keys);
+      g_hash_table_remove_all (store->rows_map);
+      thunar_list_model_clear_row_info (store);
+
       /* remove existing entries */
       path = gtk_tree_path_new_first ();
       while (row != end)
@@ -1914,6 +2335,14 @@ thunar_list_model_set_folder (ThunarListModel *store,
       g_object_unref (G_OBJECT (store->folder));
     }
 
+  /* the free space of the previous folder is of no interest anymore */
+  if (store->free_space_cancellable != NULL)
+    {
+      g_cancellable_cancel (store->free_space_cancellable);
+      g_clear_object (&store->free_space_cancellable);
+    }
+  store->free_space_valid = FALSE;
+
   /* ... just to be sure! */
   _thunar_assert (g_sequence_get_length (store->rows) == 0);
 
@@ -1945,11 +2374,15 @@ thunar_list_model_set_folder (ThunarListModel *store,
       g_signal_connect (G_OBJECT (store->folder), "error", G_CALLBACK (thunar_list_model_folder_error), store);
       g_signal_connect (G_OBJECT (store->folder), "files-added", G_CALLBACK (thunar_list_model_files_added), store);
       g_signal_connect (G_OBJECT (store->folder), "files-removed", G_CALLBACK (thunar_list_model_files_removed), store);
+
+      /* query the free space of the new folder */
+      thunar_list_model_update_free_space (store);
     }
 
   /* notify listeners that we have a new folder */
   g_object_notify_by_pspec (G_OBJECT (store), list_model_props[PROP_FOLDER]);
   g_object_notify_by_pspec (G_OBJECT (store), list_model_props[PROP_NUM_FILES]);
+  g_object_notify_by_pspec (G_OBJECT (store), list_model_props[PROP_FREE_SPACE]);
   g_object_thaw_notify (G_OBJECT (store));
 }
 
@@ -2051,6 +2484,8 @@ thunar_list_model_set_show_hidden (ThunarListModel *store,
           /* insert file in the sorted position */
           row = g_sequence_insert_sorted (store->rows, file,
                                           thunar_list_model_cmp_func, store);
+          g_hash_table_insert (store->rows_map, file, row);
+          thunar_list_model_add_row_info (store, file);
 
           GTK_TREE_ITER_INIT (iter, store->stamp, row);
 
@@ -2084,6 +2519,8 @@ thunar_list_model_set_show_hidden (ThunarListModel *store,
               path = gtk_tree_path_new_from_indices (g_sequence_iter_get_position (row), -1);
 
               /* remove file from the model */
+              thunar_list_model_remove_row_info (store, file);
+              g_hash_table_remove (store->rows_map, file);
               g_sequence_remove (row);
 
               /* notify the view(s) */
@@ -2212,7 +2649,7 @@ thunar_list_model_get_num_files (ThunarListModel *store)
  * found in the @files list. If a #ThunarFile from the @files list is not
  * available in @store, no #GtkTreePath will be returned for it. So, in effect,
  * only #GtkTreePath<!---->s for the subset of @files available in @store will
- * be returned.
+ * be returned. The paths are sorted in ascending order.
  *
  * The caller is responsible to free the returned list using:
  * <informalexample><programlisting>
@@ -2225,27 +2662,69 @@ GList*
 thunar_list_model_get_paths_for_files (ThunarListModel *store,
                                        GList           *files)
 {
+  GHashTable    *lookup;
   GList         *paths = NULL;
+  GList         *lp;
   GSequenceIter *row;
   GSequenceIter *end;
-  gint           i = 0;
+  gint          *positions;
+  guint          n_files;
+  guint          n_positions = 0;
+  guint          n;
+  gint           length;
+  gint           i;
 
   _thunar_return_val_if_fail (THUNAR_IS_LIST_MODEL (store), NULL);
 
-  row = g_sequence_get_begin_iter (store->rows);
-  end = g_sequence_get_end_iter (store->rows);
+  /* looking up the position of a row costs a tree walk per file,
+   * so for large batches (e.g. when restoring the selection of a
+   * folder) it is cheaper to check all rows in a single pass */
+  length = g_sequence_get_length (store->rows);
+  n_files = g_list_length (files);
+  if (n_files * g_bit_storage (length) >= (guint) length)
+    {
+      lookup = g_hash_table_new (g_direct_hash, g_direct_equal);
+      for (lp = files; lp != NULL; lp = lp->next)
+        g_hash_table_insert (lookup, lp->data, lp->data);
 
-  /* find the rows for the given files */
-  while (row != end)
+      /* walk the rows backwards, so the paths end up in ascending order */
+      row = g_sequence_get_end_iter (store->rows);
+      end = g_sequence_get_begin_iter (store->rows);
+
+      for (i = length; row != end; )
+        {
+          row = g_sequence_iter_prev (row);
+          i--;
+
+          if (g_hash_table_lookup (lookup, g_sequence_get (row)) != NULL)
+            {
+              _thunar_assert (i == g_sequence_iter_get_position (row));
+              paths = g_list_prepend (paths, gtk_tree_path_new_from_indices (i, -1));
+            }
+        }
+
+      g_hash_table_destroy (lookup);
+    }
+  else
     {
-      if (g_list_find (files, g_sequence_get (row)) != NULL)
+      /* find the rows for the given files */
+      positions = g_new (gint, n_files);
+      for (lp = files; lp != NULL; lp = lp->next)
         {
-          _thunar_assert (i == g_sequence_iter_get_position (row));
-          paths = g_list_prepend (paths, gtk_tree_path_new_from_indices (i, -1));
+          row = g_hash_table_lookup (store->rows_map, lp->data);
+          if (row != NULL)
+            positions[n_positions++] = g_sequence_iter_get_position (row);
         }
 
-      row = g_sequence_iter_next (row);
-      i++;
+      g_qsort_with_data (positions, n_positions, sizeof (gint),
+                         thunar_list_model_cmp_positions, NULL);
+
+      /* build the list from the end, skipping files listed twice */
+      for (n = n_positions; n > 0; --n)
+        if (n == n_positions || positions[n - 1] != positions[n])
+          paths = g_list_prepend (paths, gtk_tree_path_new_from_indices (positions[n - 1], -1));
+
+      g_free (positions);
     }
 
   return paths;
@@ -2259,7 +2738,8 @@ thunar_list_model_get_paths_for_files (ThunarListModel *store,
  * @pattern : the pattern to match.
  *
  * Looks up all rows in the @store that match @pattern and returns
- * a list of #GtkTreePath<!---->s corresponding to the rows.
+ * a list of #GtkTreePath<!---->s corresponding to the rows, sorted
+ * in ascending order.
  *
  * The caller is responsible to free the returned list using:
  * <informalexample><programlisting>
@@ -2305,51 +2785,67 @@ thunar_list_model_get_paths_for_pattern (ThunarListModel *store,
   /* release the pattern */
   g_pattern_spec_free (pspec);
 
-  return paths;
+  return g_list_reverse (paths);
 }
 
 
 
 /**
- * thunar_list_model_get_statusbar_text_for_files:
- * @files                        : list of files for which a text is requested
+ * thunar_list_model_set_file_selected:
+ * @store    : a #ThunarListModel instance.
+ * @file     : a #ThunarFile.
+ * @selected : whether @file is selected in the view.
+ *
+ * Marks the row of @file as (un)selected, so the totals of the
+ * selection are updated with the files that were actually (un)selected.
+ * Files that are not shown in @store are ignored.
+ **/
+void
+thunar_list_model_set_file_selected (ThunarListModel *store,
+                                     ThunarFile      *file,
+                                     gboolean         selected)
+{
+  ThunarRowInfo *info;
+
+  _thunar_return_if_fail (THUNAR_IS_LIST_MODEL (store));
+  _thunar_return_if_fail (THUNAR_IS_FILE (file));
+
+  info = g_hash_table_lookup (store->row_info, file);
+  if (info == NULL || info->selected == !!selected)
+    return;
+
+  thunar_list_model_count_row_info (store, info, -1);
+  info->selected = !!selected;
+  thunar_list_model_count_row_info (store, info, 1);
+}
+
+
+
+/**
+ * thunar_list_model_get_statusbar_text_for_totals:
+ * @folder_count                 : the number of folders.
+ * @non_folder_count             : the number of other files.
+ * @size_summary                 : the size of the regular files.
  * @show_file_size_binary_format : weather the file size should be displayed in binary format
  *
- * Generates the statusbar text for the given @files.
+ * Generates the statusbar text for a set of files with the given totals.
  *
  * The caller is reponsible to free the returned text using
  * g_free() when it's no longer needed.
  *
- * Return value: the statusbar text for @store with the given @files.
+ * Return value: the statusbar text for the given totals.
  **/
 static gchar*
-thunar_list_model_get_statusbar_text_for_files (GList    *files,
-                                                gboolean  show_file_size_binary_format)
+thunar_list_model_get_statusbar_text_for_totals (gint     folder_count,
+                                                 gint     non_folder_count,
+                                                 guint64  size_summary,
+                                                 gboolean show_file_size_binary_format)
 {
-  guint64  size_summary = 0;
-  gint     folder_count = 0;
-  gint     non_folder_count = 0;
-  GList   *lp;
   gchar   *size_string;
   gchar   *text;
   gchar   *folder_text = NULL;
   gchar   *non_folder_text = NULL;
 
-  /* analyze files */
-  for (lp = files; lp != NULL; lp = lp->next)
-    {
-      if (thunar_file_is_directory (lp->data))
-        {
-          folder_count++;
-        }
-      else
-        {
-          non_folder_count++;
-          if (thunar_file_is_regular (lp->data))
-            size_summary += thunar_file_get_size (lp->data);
-        }
-    }
-
   if (non_folder_count > 0)
     {
       size_string = g_format_size_full (size_summary, G_FORMAT_SIZE_LONG_FORMAT | (show_file_size_binary_format ? G_FORMAT_SIZE_IEC_UNITS : G_FORMAT_SIZE_DEFAULT));
@@ -2391,10 +2887,12 @@ thunar_list_model_get_statusbar_text_for_files (GList    *files,
 /**
  * thunar_list_model_get_statusbar_text:
  * @store          : a #ThunarListModel instance.
- * @selected_items : the list of selected items (as GtkTreePath's).
+ * @selected_files : the list of selected #ThunarFile<!---->s.
  *
  * Generates the statusbar text for @store with the given
- * @selected_items.
+ * @selected_files. The totals of a selection of more than one
+ * file are taken from the rows marked with
+ * thunar_list_model_set_file_selected().
  *
  * This function is used by the #ThunarStandardView (and thereby
  * implicitly by #ThunarIconView and #ThunarDetailsView) to
@@ -2405,18 +2903,15 @@ thunar_list_model_get_statusbar_text_for_files (GList    *files,
  * g_free() when it's no longer needed.
  *
  * Return value: the statusbar text for @store with the given
- *               @selected_items.
+ *               @selected_files.
  **/
 gchar*
 thunar_list_model_get_statusbar_text (ThunarListModel *store,
-                                      GList           *selected_items)
+                                      GList           *selected_files)
 {
   const gchar       *content_type;
   const gchar       *original_path;
-  GtkTreeIter        iter;
   ThunarFile        *file;
-  guint64            size;
-  GList             *lp;
   gchar             *absolute_path;
   gchar             *fspace_string;
   gchar             *display_name;
@@ -2426,37 +2921,25 @@ thunar_list_model_get_statusbar_text (ThunarListModel *store,
   gint               height;
   gint               width;
   gchar             *description;
-  GSequenceIter     *row;
-  GSequenceIter     *end;
   ThunarPreferences *preferences;
   gboolean           show_image_size;
   gboolean           show_file_size_binary_format;
-  GList             *relevant_files = NULL;
 
   _thunar_return_val_if_fail (THUNAR_IS_LIST_MODEL (store), NULL);
 
   show_file_size_binary_format = thunar_list_model_get_file_size_binary(store);
 
-  if (selected_items == NULL) /* nothing selected */
+  if (selected_files == NULL) /* nothing selected */
     {
-      /* build a GList of all files */
-      end = g_sequence_get_end_iter (store->rows);
-      for (row = g_sequence_get_begin_iter (store->rows); row != end; row = g_sequence_iter_next (row))
-        {
-          relevant_files = g_list_append (relevant_files, g_sequence_get (row));
-        }
-
-      /* try to determine a file for the current folder */
-      file = (store->folder != NULL) ? thunar_folder_get_corresponding_file (store->folder) : NULL;
+      /* the totals of all files are kept up-to-date by the model */
+      size_string = thunar_list_model_get_statusbar_text_for_totals (store->n_folders, store->n_non_folders,
+                                                                     store->size_summary, show_file_size_binary_format);
 
-      /* check if we can determine the amount of free space for the volume */
-      if (G_LIKELY (file != NULL
-          && thunar_g_file_get_free_space (thunar_file_get_file (file), &size, NULL)))
+      /* check if we know the amount of free space for the volume */
+      if (G_LIKELY (store->free_space_valid))
         {
-          size_string = thunar_list_model_get_statusbar_text_for_files (relevant_files, show_file_size_binary_format);
-
           /* humanize the free space */
-          fspace_string = g_format_size_full (size, show_file_size_binary_format ? G_FORMAT_SIZE_IEC_UNITS : G_FORMAT_SIZE_DEFAULT);
+          fspace_string = g_format_size_full (store->free_space, show_file_size_binary_format ? G_FORMAT_SIZE_IEC_UNITS : G_FORMAT_SIZE_DEFAULT);
 
           text = g_strdup_printf (_("%s, Free space: %s"), size_string, fspace_string);
 
@@ -2466,17 +2949,12 @@ thunar_list_model_get_statusbar_text (ThunarListModel *store,
         }
       else
         {
-          text = thunar_list_model_get_statusbar_text_for_files (relevant_files, show_file_size_binary_format);
+          text = size_string;
         }
-      g_list_free (relevant_files);
     }
-  else if (selected_items->next == NULL) /* only one item selected */
+  else if (selected_files->next == NULL) /* only one item selected */
     {
-      /* resolve the iter for the single path */
-      gtk_tree_model_get_iter (GTK_TREE_MODEL (store), &iter, selected_items->data);
-
-      /* get the file for the given iter */
-      file = g_sequence_get (iter.user_data);
+      file = THUNAR_FILE (selected_files->data);
 
       /* determine the content type of the file */
       content_type = thunar_file_get_content_type (file);
@@ -2557,17 +3035,11 @@ thunar_list_model_get_statusbar_text (ThunarListModel *store,
     }
   else /* more than one item selected */
     {
-      /* build GList of files from selection */
-      for (lp = selected_items; lp != NULL; lp = lp->next)
-        {
-          gtk_tree_model_get_iter (GTK_TREE_MODEL (store), &iter, lp->data);
-          relevant_files = g_list_append (relevant_files, g_sequence_get (iter.user_data));
-        }
-        
-      size_string = thunar_list_model_get_statusbar_text_for_files (relevant_files, show_file_size_binary_format);
+      /* the totals of the selected rows are kept up-to-date as well */
+      size_string = thunar_list_model_get_statusbar_text_for_totals (store->n_selected_folders, store->n_selected_non_folders,
+                                                                     store->selected_size_summary, show_file_size_binary_format);
       text = g_strdup_printf (_("Selection: %s"), size_string);
       g_free (size_string);
-      g_list_free (relevant_files);
     }
 
   return text;
@@ -62,8 +62,12 @@ GList           *thunar_list_model_get_paths_for_files    (ThunarListModel  *sto
 GList           *thunar_list_model_get_paths_for_pattern  (ThunarListModel  *store,
                                                            const gchar      *pattern);
 
+void             thunar_list_model_set_file_selected      (ThunarListModel  *store,
+                                                           ThunarFile       *file,
+                                                           gboolean          selected);
+
 gchar           *thunar_list_model_get_statusbar_text     (ThunarListModel  *store,
-                                                           GList            *selected_items);
+                                                           GList            *selected_files);
 
 G_END_DECLS;
 
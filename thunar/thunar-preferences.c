@@ -77,10 +77,12 @@ enum
   PROP_MISC_CASE_SENSITIVE,
   PROP_MISC_DATE_STYLE,
   PROP_MISC_DATE_CUSTOM_STYLE,
+  PROP_MISC_DIRECTORY_LOAD_BATCH_SIZE,
   PROP_EXEC_SHELL_SCRIPTS_BY_DEFAULT,
   PROP_MISC_FOLDERS_FIRST,
   PROP_MISC_FULL_PATH_IN_TITLE,
   PROP_MISC_HORIZONTAL_WHEEL_NAVIGATES,
+  PROP_MISC_ICON_CACHE_SIZE,
   PROP_MISC_IMAGE_SIZE_IN_STATUSBAR,
   PROP_MISC_MIDDLE_CLICK_IN_TAB,
   PROP_MISC_OPEN_NEW_WINDOW_AS_TAB,
@@ -95,6 +97,7 @@ enum
   PROP_MISC_TEXT_BESIDE_ICONS,
   PROP_MISC_THUMBNAIL_MODE,
   PROP_MISC_THUMBNAIL_DRAW_FRAMES,
+  PROP_MISC_TRANSFER_PARALLEL_COPIES,
   PROP_MISC_FILE_SIZE_BINARY,
   PROP_SHORTCUTS_ICON_EMBLEMS,
   PROP_SHORTCUTS_ICON_SIZE,
@@ -509,6 +512,20 @@ thunar_preferences_class_init (ThunarPreferencesClass *klass)
                            "%Y-%m-%d %H:%M:%S",
                            EXO_PARAM_READWRITE);
 
+  /**
+   * ThunarPreferences:misc-directory-load-batch-size:
+   *
+   * The number of files that are read from a directory before they
+   * are passed to the views while the directory is being loaded. A
+   * value of %0 reports all files at once when loading is done.
+   **/
+  preferences_props[PROP_MISC_DIRECTORY_LOAD_BATCH_SIZE] =
+      g_param_spec_uint ("misc-directory-load-batch-size",
+                         NULL,
+                         NULL,
+                         0u, G_MAXUINT, 500u,
+                         EXO_PARAM_READWRITE);
+
   /**
    * ThunarPreferences:misc-execute-shell-scripts-by-default:
    *
@@ -563,6 +580,20 @@ thunar_preferences_class_init (ThunarPreferencesClass *klass)
                             FALSE,
                             EXO_PARAM_READWRITE);
 
+  /**
+   * ThunarPreferences:misc-icon-cache-size:
+   *
+   * The maximum memory in megabytes used to keep thumbnails of
+   * files in memory. The least recently drawn thumbnails are
+   * dropped first and loaded again from disk when needed.
+   **/
+  preferences_props[PROP_MISC_ICON_CACHE_SIZE] =
+      g_param_spec_uint ("misc-icon-cache-size",
+                         NULL,
+                         NULL,
+                         1u, 4096u, 64u,
+                         EXO_PARAM_READWRITE);
+
   /**
    * ThunarPreferences:misc-image-size-in-statusbar:
    *
@@ -750,6 +781,20 @@ thunar_preferences_class_init (ThunarPreferencesClass *klass)
                             FALSE,
                             EXO_PARAM_READWRITE);
 
+  /**
+   * ThunarPreferences:misc-transfer-parallel-copies:
+   *
+   * The number of files copied at the same time when copying a
+   * folder to a local file system. Copies to remote locations are
+   * always done one file after the other.
+   **/
+  preferences_props[PROP_MISC_TRANSFER_PARALLEL_COPIES] =
+      g_param_spec_uint ("misc-transfer-parallel-copies",
+                         NULL,
+                         NULL,
+                         1u, 64u, 4u,
+                         EXO_PARAM_READWRITE);
+
   /**
    * ThunarPreferences:misc-file-size-binary:
    *
@@ -39,6 +39,9 @@
 
 #define THUNAR_RENAMER_MODEL_ITEM(item) ((ThunarRenamerModelItem *) (item))
 
+/* maximum time in microseconds spent in a single update idle run */
+#define THUNAR_RENAMER_MODEL_UPDATE_TIME_SLICE (10 * 1000)
+
 
 
 /* Property identifiers */
@@ -110,13 +113,21 @@ static void                    thunar_renamer_model_file_destroyed      (ThunarR
                                                                          ThunarFile              *file,
                                                                          ThunarFileMonitor       *file_monitor);
 static void                    thunar_renamer_model_invalidate_all      (ThunarRenamerModel      *renamer_model);
+static void                    thunar_renamer_model_busy_changed        (ThunarRenamerModel      *renamer_model);
 static void                    thunar_renamer_model_invalidate_item     (ThunarRenamerModel      *renamer_model,
                                                                          ThunarRenamerModelItem  *item);
 static gboolean                thunar_renamer_model_conflict_item       (ThunarRenamerModel      *renamer_model,
                                                                          ThunarRenamerModelItem  *item);
+static void                    thunar_renamer_model_register_item       (ThunarRenamerModel      *renamer_model,
+                                                                         ThunarRenamerModelItem  *item);
+static void                    thunar_renamer_model_unregister_item     (ThunarRenamerModel      *renamer_model,
+                                                                         ThunarRenamerModelItem  *item);
 static gchar                  *thunar_renamer_model_process_item        (ThunarRenamerModel      *renamer_model,
                                                                          ThunarRenamerModelItem  *item,
                                                                          guint                    idx);
+static void                    thunar_renamer_model_update_item         (ThunarRenamerModel      *renamer_model,
+                                                                         GList                   *lp,
+                                                                         guint                    idx);
 static gboolean                thunar_renamer_model_update_idle         (gpointer                 user_data);
 static void                    thunar_renamer_model_update_idle_destroy (gpointer                 user_data);
 static ThunarRenamerModelItem *thunar_renamer_model_item_new            (ThunarFile              *file) G_GNUC_MALLOC;
@@ -160,16 +171,34 @@ struct _ThunarRenamerModel
 
   /* the idle source used to update the model */
   guint              update_idle_id;
+
+  /* the number of dirty items and the position in the
+   * items list where the update idle source continues.
+   */
+  guint              n_dirty;
+  GList             *update_lp;
+  guint              update_idx;
+
+  /* parent GFile -> (name -> ThunarRenamerModelItem) of all items
+   * that are up to date, used to look up conflicting names.
+   */
+  GHashTable        *names;
 };
 
 struct _ThunarRenamerModelItem
 {
-  ThunarFile *file;
-  gchar      *name;
-  guint64     date_changed;
-  guint       changed : 1;  /* if the file changed */
-  guint       conflict : 1; /* if the item conflicts with another item */
-  guint       dirty : 1;    /* if the item must be updated */
+  ThunarFile             *file;
+  GFile                  *parent;
+  gchar                  *name;
+  guint64                 date_changed;
+  guint                   changed : 1;  /* if the file changed */
+  guint                   conflict : 1; /* if the item conflicts with another item */
+  guint                   dirty : 1;    /* if the item must be updated */
+
+  /* the name the item is registered with in the names table
+   * and the next item in the same directory with that name */
+  gchar                  *conflict_name;
+  ThunarRenamerModelItem *conflict_next;
 };
 
 
@@ -276,6 +305,10 @@ thunar_renamer_model_init (ThunarRenamerModel *renamer_model)
   renamer_model->stamp = g_random_int ();
 #endif
 
+  /* allocate the table of up to date names per directory */
+  renamer_model->names = g_hash_table_new_full (g_file_hash, (GEqualFunc) g_file_equal,
+                                                g_object_unref, (GDestroyNotify) g_hash_table_unref);
+
   /* connect to the file monitor */
   renamer_model->file_monitor = thunar_file_monitor_get_default ();
   g_signal_connect_swapped (G_OBJECT (renamer_model->file_monitor), "file-changed",
@@ -296,6 +329,7 @@ thunar_renamer_model_finalize (GObject *object)
 
   /* release all items */
   g_list_free_full (renamer_model->items, thunar_renamer_model_item_free);
+  g_hash_table_destroy (renamer_model->names);
 
   /* disconnect from the file monitor */
   g_signal_handlers_disconnect_by_func (G_OBJECT (renamer_model->file_monitor), thunar_renamer_model_file_destroyed, renamer_model);
@@ -675,6 +709,12 @@ thunar_renamer_model_file_destroyed (ThunarRenamerModel *renamer_model,
         /* determine the idx of the item */
         idx = g_list_position (renamer_model->items, lp);
 
+        /* forget about the item */
+        if (THUNAR_RENAMER_MODEL_ITEM (lp->data)->dirty)
+          renamer_model->n_dirty -= 1;
+        thunar_renamer_model_unregister_item (renamer_model, lp->data);
+        renamer_model->update_lp = NULL;
+
         /* free the item data */
         thunar_renamer_model_item_free (lp->data);
 
@@ -699,6 +739,9 @@ thunar_renamer_model_invalidate_all (ThunarRenamerModel *renamer_model)
 {
   GList *lp;
 
+  /* restart the update at the head of the list */
+  renamer_model->update_lp = NULL;
+
   /* invalidate all items in the model */
   for (lp = renamer_model->items; lp != NULL; lp = lp->next)
     thunar_renamer_model_invalidate_item (renamer_model, lp->data);
@@ -706,12 +749,26 @@ thunar_renamer_model_invalidate_all (ThunarRenamerModel *renamer_model)
 
 
 
+static void
+thunar_renamer_model_busy_changed (ThunarRenamerModel *renamer_model)
+{
+  /* renaming is not possible while the renamer is busy */
+  g_object_notify (G_OBJECT (renamer_model), "can-rename");
+}
+
+
+
 static void
 thunar_renamer_model_invalidate_item (ThunarRenamerModel     *renamer_model,
                                       ThunarRenamerModelItem *item)
 {
-  /* mark the item as dirty */
-  item->dirty = TRUE;
+  /* mark the item as dirty, its name is no longer valid for conflicts */
+  if (G_LIKELY (!item->dirty))
+    {
+      item->dirty = TRUE;
+      renamer_model->n_dirty += 1;
+      thunar_renamer_model_unregister_item (renamer_model, item);
+    }
 
   /* check if the update idle source is already running and not frozen */
   if (G_UNLIKELY (renamer_model->update_idle_id == 0 && !renamer_model->frozen))
@@ -727,27 +784,11 @@ thunar_renamer_model_invalidate_item (ThunarRenamerModel     *renamer_model,
 
 
 
-static gboolean
-trm_same_directory (ThunarFile *a,
-                    ThunarFile *b)
+static const gchar *
+trm_item_get_name (ThunarRenamerModelItem *item)
 {
-  GFile    *parent_a;
-  GFile    *parent_b;
-  gboolean  result;
-
-  /* determine the parent paths for both files */
-  parent_a = g_file_get_parent (thunar_file_get_file (a));
-  parent_b = g_file_get_parent (thunar_file_get_file (b));
-
-  /* check if both files have the same parent */
-  result = (parent_a != NULL && parent_b != NULL && g_file_equal (parent_a, parent_b));
-
-  if (parent_a != NULL)
-    g_object_unref (parent_a);
-  if (parent_b != NULL)
-    g_object_unref (parent_b);
-
-  return result;
+  /* the new name or the current name if the item is not renamed */
+  return (item->name != NULL) ? item->name : thunar_file_get_display_name (item->file);
 }
 
 
@@ -757,45 +798,119 @@ thunar_renamer_model_conflict_item (ThunarRenamerModel     *renamer_model,
                                     ThunarRenamerModelItem *item)
 {
   ThunarRenamerModelItem *oitem;
+  ThunarRenamerModelItem *next;
+  GHashTable             *names;
   GtkTreePath            *path;
   GtkTreeIter             iter;
-  gboolean                conflict = FALSE;
-  GList                  *lp;
 
-  for (lp = renamer_model->items; lp != NULL; lp = lp->next)
+  /* items can only conflict if in the same directory */
+  if (G_UNLIKELY (item->parent == NULL))
+    return FALSE;
+
+  names = g_hash_table_lookup (renamer_model->names, item->parent);
+  if (names == NULL)
+    return FALSE;
+
+  /* find an up to date item with the same name in the directory */
+  for (oitem = g_hash_table_lookup (names, trm_item_get_name (item)); oitem == item; oitem = oitem->conflict_next)
+    ;
+  if (oitem == NULL)
+    return FALSE;
+
+  /* if there are other items with the name, they are all
+   * in conflict state already, no need to look at them */
+  for (next = oitem->conflict_next; next == item; next = next->conflict_next)
+    ;
+  if (next != NULL)
+    return TRUE;
+
+  /* check if the other item is already in conflict state */
+  if (G_LIKELY (!oitem->conflict))
     {
-      /* check if this item is dirty or the item we're about to check */
-      oitem = THUNAR_RENAMER_MODEL_ITEM (lp->data);
-      if (G_UNLIKELY (oitem == item || oitem->dirty))
-        continue;
-
-      /* check if this other item conflicts with the item in question (can only conflict if in same directory) */
-      if (trm_same_directory (item->file, oitem->file)
-          && ((item->name != NULL && oitem->name == NULL && strcmp (item->name, thunar_file_get_display_name (oitem->file)) == 0)
-           || (item->name == NULL && oitem->name != NULL && strcmp (thunar_file_get_display_name (item->file), oitem->name) == 0)
-           || (item->name != NULL && oitem->name != NULL && strcmp (item->name, oitem->name) == 0)))
-        {
-          /* check if the other item is already in conflict state */
-          if (G_LIKELY (!oitem->conflict))
-            {
-              /* set to conflict state */
-              oitem->conflict = TRUE;
+      /* set to conflict state */
+      oitem->conflict = TRUE;
 
-              /* determine iter for other item */
-              GTK_TREE_ITER_INIT (iter, renamer_model->stamp, lp);
+      /* determine iter for other item */
+      GTK_TREE_ITER_INIT (iter, renamer_model->stamp, g_list_find (renamer_model->items, oitem));
 
-              /* emit "row-changed" for the other item */
-              path = gtk_tree_model_get_path (GTK_TREE_MODEL (renamer_model), &iter);
-              gtk_tree_model_row_changed (GTK_TREE_MODEL (renamer_model), path, &iter);
-              gtk_tree_path_free (path);
-            }
+      /* emit "row-changed" for the other item */
+      path = gtk_tree_model_get_path (GTK_TREE_MODEL (renamer_model), &iter);
+      gtk_tree_model_row_changed (GTK_TREE_MODEL (renamer_model), path, &iter);
+      gtk_tree_path_free (path);
+    }
 
-          /* this item conflicts */
-          conflict = TRUE;
-        }
+  /* this item conflicts */
+  return TRUE;
+}
+
+
+
+static void
+thunar_renamer_model_register_item (ThunarRenamerModel     *renamer_model,
+                                    ThunarRenamerModelItem *item)
+{
+  GHashTable *names;
+
+  _thunar_assert (item->conflict_name == NULL);
+
+  if (G_UNLIKELY (item->parent == NULL))
+    return;
+
+  /* lookup or allocate the names table for the directory */
+  names = g_hash_table_lookup (renamer_model->names, item->parent);
+  if (names == NULL)
+    {
+      names = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+      g_hash_table_insert (renamer_model->names, g_object_ref (item->parent), names);
+    }
+
+  /* prepend the item to the items with the same name */
+  item->conflict_name = g_strdup (trm_item_get_name (item));
+  item->conflict_next = g_hash_table_lookup (names, item->conflict_name);
+  g_hash_table_insert (names, g_strdup (item->conflict_name), item);
+}
+
+
+
+static void
+thunar_renamer_model_unregister_item (ThunarRenamerModel     *renamer_model,
+                                      ThunarRenamerModelItem *item)
+{
+  ThunarRenamerModelItem *oitem;
+  GHashTable             *names;
+
+  if (item->conflict_name == NULL)
+    return;
+
+  names = g_hash_table_lookup (renamer_model->names, item->parent);
+  _thunar_assert (names != NULL);
+
+  /* unlink the item from the items with the same name */
+  oitem = g_hash_table_lookup (names, item->conflict_name);
+  if (oitem == item)
+    {
+      if (item->conflict_next != NULL)
+        g_hash_table_insert (names, g_strdup (item->conflict_name), item->conflict_next);
+      else
+        g_hash_table_remove (names, item->conflict_name);
+    }
+  else
+    {
+      for (; oitem != NULL; oitem = oitem->conflict_next)
+        if (oitem->conflict_next == item)
+          {
+            oitem->conflict_next = item->conflict_next;
+            break;
+          }
     }
 
-  return conflict;
+  /* drop the names table of the directory once it is empty */
+  if (g_hash_table_size (names) == 0)
+    g_hash_table_remove (renamer_model->names, item->parent);
+
+  g_free (item->conflict_name);
+  item->conflict_name = NULL;
+  item->conflict_next = NULL;
 }
 
 
@@ -886,17 +1001,80 @@ thunar_renamer_model_process_item (ThunarRenamerModel     *renamer_model,
 
 
 
+static void
+thunar_renamer_model_update_item (ThunarRenamerModel *renamer_model,
+                                  GList              *lp,
+                                  guint               idx)
+{
+  ThunarRenamerModelItem *item = THUNAR_RENAMER_MODEL_ITEM (lp->data);
+  GtkTreePath            *path;
+  GtkTreeIter             iter;
+  gboolean                changed;
+  gboolean                conflict;
+  gchar                  *name;
+
+  /* check if the file changed */
+  changed = item->changed;
+
+  /* mark as valid, since we're updating right now */
+  item->changed = FALSE;
+  item->dirty = FALSE;
+  renamer_model->n_dirty -= 1;
+
+  /* determine the new name for the item */
+  name = thunar_renamer_model_process_item (renamer_model, item, idx);
+  if (!exo_str_is_equal (item->name, name))
+    {
+      /* apply new name */
+      g_free (item->name);
+      item->name = name;
+
+      /* the item changed */
+      changed = TRUE;
+    }
+  else
+    {
+      /* release temporary name */
+      g_free (name);
+    }
+
+  /* check if this item conflicts with any other item */
+  conflict = thunar_renamer_model_conflict_item (renamer_model, item);
+  if (item->conflict != conflict)
+    {
+      /* apply the new state */
+      item->conflict = conflict;
+
+      /* the item changed */
+      changed = TRUE;
+    }
+
+  /* remember the name for the following items */
+  thunar_renamer_model_register_item (renamer_model, item);
+
+  /* check if the item changed */
+  if (G_LIKELY (changed))
+    {
+      /* generate the iter for the item */
+      GTK_TREE_ITER_INIT (iter, renamer_model->stamp, lp);
+
+      /* emit "row-changed" for this item */
+      path = gtk_tree_path_new_from_indices (idx, -1);
+      gtk_tree_model_row_changed (GTK_TREE_MODEL (renamer_model), path, &iter);
+      gtk_tree_path_free (path);
+    }
+}
+
+
+
 static gboolean
 thunar_renamer_model_update_idle (gpointer user_data)
 {
   ThunarRenamerModelItem *item;
   ThunarRenamerModel     *renamer_model = THUNAR_RENAMER_MODEL (user_data);
-  GtkTreePath            *path;
-  GtkTreeIter             iter;
-  gboolean                changed = FALSE;
-  gboolean                conflict;
+  gboolean                processed;
+  gint64                  end_time;
   guint                   idx;
-  gchar                  *name;
   GList                  *lp;
 
 THUNAR_THREADS_ENTER
@@ -904,67 +1082,42 @@ THUNAR_THREADS_ENTER
   /* don't do anything if the model is frozen */
   if (G_LIKELY (!renamer_model->frozen))
     {
-      /* process the first dirty item */
-      for (idx = 0, lp = renamer_model->items; !changed && lp != NULL; ++idx, lp = lp->next)
-        {
-          /* check if this item is dirty */
-          item = THUNAR_RENAMER_MODEL_ITEM (lp->data);
-          if (G_LIKELY (!item->dirty))
-            continue;
-
-          /* check if the file changed */
-          changed = item->changed;
+      end_time = g_get_monotonic_time () + THUNAR_RENAMER_MODEL_UPDATE_TIME_SLICE;
 
-          /* mark as valid, since we're updating right now */
-          item->changed = FALSE;
-          item->dirty = FALSE;
+      /* continue where the previous run stopped */
+      lp = renamer_model->update_lp;
+      idx = renamer_model->update_idx;
 
-          /* determine the new name for the item */
-          name = thunar_renamer_model_process_item (renamer_model, item, idx);
-          if (!exo_str_is_equal (item->name, name))
-            {
-              /* apply new name */
-              g_free (item->name);
-              item->name = name;
-
-              /* the item changed */
-              changed = TRUE;
-            }
-          else
+      /* process dirty items in list order until our time is up */
+      while (renamer_model->n_dirty > 0 && renamer_model->items != NULL)
+        {
+          /* wrap around, items before the cursor may have been invalidated */
+          if (G_UNLIKELY (lp == NULL))
             {
-              /* release temporary name */
-              g_free (name);
+              lp = renamer_model->items;
+              idx = 0;
             }
 
-          /* check if this item conflicts with any other item */
-          conflict = thunar_renamer_model_conflict_item (renamer_model, item);
-          if (item->conflict != conflict)
-            {
-              /* apply the new state */
-              item->conflict = conflict;
-
-              /* the item changed */
-              changed = TRUE;
-            }
+          item = THUNAR_RENAMER_MODEL_ITEM (lp->data);
+          processed = item->dirty;
+          if (processed)
+            thunar_renamer_model_update_item (renamer_model, lp, idx);
 
-          /* check if the item changed */
-          if (G_LIKELY (changed))
-            {
-              /* generate the iter for the item */
-              GTK_TREE_ITER_INIT (iter, renamer_model->stamp, lp);
+          lp = lp->next;
+          ++idx;
 
-              /* emit "row-changed" for this item */
-              path = gtk_tree_path_new_from_indices (idx, -1);
-              gtk_tree_model_row_changed (GTK_TREE_MODEL (renamer_model), path, &iter);
-              gtk_tree_path_free (path);
-            }
+          if (processed && g_get_monotonic_time () >= end_time)
+            break;
         }
+
+      renamer_model->update_lp = lp;
+      renamer_model->update_idx = idx;
     }
 
 THUNAR_THREADS_LEAVE
 
-  /* keep the idle source as long as any item changed */
-  return changed;
+  /* keep the idle source as long as there are dirty items */
+  return (!renamer_model->frozen && renamer_model->n_dirty > 0);
 }
 
 
@@ -988,8 +1141,8 @@ thunar_renamer_model_item_new (ThunarFile *file)
 
   item = g_slice_new0 (ThunarRenamerModelItem);
   item->file = THUNAR_FILE (g_object_ref (G_OBJECT (file)));
+  item->parent = g_file_get_parent (thunar_file_get_file (file));
   item->date_changed = thunar_file_get_date (file, THUNAR_FILE_DATE_CHANGED);
-  item->dirty = TRUE;
 
   return item;
 }
@@ -1002,6 +1155,9 @@ thunar_renamer_model_item_free (gpointer data)
   ThunarRenamerModelItem *item = data;
 
   g_object_unref (G_OBJECT (item->file));
+  if (item->parent != NULL)
+    g_object_unref (item->parent);
+  g_free (item->conflict_name);
   g_free (item->name);
   g_slice_free (ThunarRenamerModelItem, item);
 }
@@ -1072,7 +1228,8 @@ thunar_renamer_model_new (void)
  *
  * This method will always return %FALSE if the
  * @renamer_model is frozen. See thunar_renamer_model_set_frozen()
- * and thunar_renamer_model_get_frozen().
+ * and thunar_renamer_model_get_frozen(). The same applies while
+ * the renamer is busy, see thunarx_renamer_get_busy().
  *
  * Return value: %TRUE if bulk rename can be performed.
  **/
@@ -1084,7 +1241,8 @@ thunar_renamer_model_get_can_rename (ThunarRenamerModel *renamer_model)
 
   _thunar_return_val_if_fail (THUNAR_IS_RENAMER_MODEL (renamer_model), FALSE);
 
-  if (G_LIKELY (renamer_model->renamer != NULL && !renamer_model->frozen && renamer_model->update_idle_id == 0))
+  if (G_LIKELY (renamer_model->renamer != NULL && !renamer_model->frozen && renamer_model->update_idle_id == 0
+                && !thunarx_renamer_get_busy (renamer_model->renamer)))
     {
       /* check if atleast one item has a new name and no conflicts exist */
       for (lp = renamer_model->items; lp != NULL; lp = lp->next)
@@ -1259,6 +1417,7 @@ thunar_renamer_model_set_renamer (ThunarRenamerModel *renamer_model,
   if (renamer_model->renamer != NULL)
     {
       g_signal_handlers_disconnect_by_func (G_OBJECT (renamer_model->renamer), thunar_renamer_model_invalidate_all, renamer_model);
+      g_signal_handlers_disconnect_by_func (G_OBJECT (renamer_model->renamer), thunar_renamer_model_busy_changed, renamer_model);
       g_object_unref (G_OBJECT (renamer_model->renamer));
     }
 
@@ -1269,6 +1428,7 @@ thunar_renamer_model_set_renamer (ThunarRenamerModel *renamer_model,
   if (G_LIKELY (renamer != NULL))
     {
       g_signal_connect_swapped (G_OBJECT (renamer), "changed", G_CALLBACK (thunar_renamer_model_invalidate_all), renamer_model);
+      g_signal_connect_swapped (G_OBJECT (renamer), "notify::busy", G_CALLBACK (thunar_renamer_model_busy_changed), renamer_model);
       g_object_ref (G_OBJECT (renamer));
     }
 
@@ -1313,6 +1473,9 @@ thunar_renamer_model_insert (ThunarRenamerModel *renamer_model,
   /* append the item to the model */
   renamer_model->items = g_list_insert (renamer_model->items, item, position);
 
+  /* the positions of the following items changed */
+  renamer_model->update_lp = NULL;
+
   /* determine the iterator for the new item */
   GTK_TREE_ITER_INIT (iter, renamer_model->stamp, g_list_find (renamer_model->items, item));
 
@@ -1508,6 +1671,12 @@ thunar_renamer_model_remove (ThunarRenamerModel *renamer_model,
   if (G_UNLIKELY (lp == NULL))
     return;
 
+  /* forget about the item */
+  if (THUNAR_RENAMER_MODEL_ITEM (lp->data)->dirty)
+    renamer_model->n_dirty -= 1;
+  thunar_renamer_model_unregister_item (renamer_model, lp->data);
+  renamer_model->update_lp = NULL;
+
   /* free the item data */
   thunar_renamer_model_item_free (lp->data);
 
@@ -165,6 +165,11 @@ static ThunarFile          *thunar_standard_view_get_drop_file              (Thu
 static void                 thunar_standard_view_merge_custom_actions       (ThunarStandardView       *standard_view,
                                                                              GList                    *selected_items);
 static void                 thunar_standard_view_update_statusbar_text      (ThunarStandardView       *standard_view);
+static void                 thunar_standard_view_select_paths               (ThunarStandardView       *standard_view,
+                                                                             GList                    *paths);
+static gboolean             thunar_standard_view_selection_changed_idle     (gpointer                  user_data);
+static void                 thunar_standard_view_reset_selection_table      (ThunarStandardView       *standard_view);
+static void                 thunar_standard_view_flush_selection            (ThunarStandardView       *standard_view);
 static void                 thunar_standard_view_current_directory_destroy  (ThunarFile               *current_directory,
                                                                              ThunarStandardView       *standard_view);
 static void                 thunar_standard_view_current_directory_changed  (ThunarFile               *current_directory,
@@ -288,6 +293,8 @@ static gboolean             thunar_standard_view_drag_scroll_timer          (gpo
 static void                 thunar_standard_view_drag_scroll_timer_destroy  (gpointer                  user_data);
 static gboolean             thunar_standard_view_drag_timer                 (gpointer                  user_data);
 static void                 thunar_standard_view_drag_timer_destroy         (gpointer                  user_data);
+static void                 thunar_standard_view_clipboard_changed          (ThunarClipboardManager   *clipboard,
+                                                                             ThunarStandardView       *standard_view);
 static void                 thunar_standard_view_finished_thumbnailing      (ThunarThumbnailer        *thumbnailer,
                                                                              guint                     request,
                                                                              ThunarStandardView       *standard_view);
@@ -379,9 +386,15 @@ struct _ThunarStandardViewPrivate
   gfloat                  scroll_to_row_align;
   gfloat                  scroll_to_col_align;
 
-  /* selected_files support */
+  /* selected_files support, selected_files_table contains (and holds
+   * a reference on) the files of the last handled selection, to
+   * determine what changed */
   GList                  *selected_files;
+  GHashTable             *selected_files_table;
+  guint                   n_trashed_files;
+  guint                   selection_reset : 1;
   guint                   restore_selection_idle_id;
+  guint                   selection_changed_idle_id;
 
   /* support for generating thumbnails */
   ThunarThumbnailer      *thumbnailer;
@@ -392,6 +405,9 @@ struct _ThunarStandardViewPrivate
   /* file insert signal */
   gulong                  row_changed_id;
 
+  /* generation of the clipboard files the rows were drawn with */
+  guint                   clipboard_generation;
+
   /* Tree path for restoring the selection after selecting and
    * deleting an item */
   GtkTreePath            *selection_before_delete;
@@ -654,6 +670,7 @@ thunar_standard_view_init (ThunarStandardView *standard_view)
 
   /* allocate the scroll_to_files mapping (directory GFile -> first visible child GFile) */
   standard_view->priv->scroll_to_files = g_hash_table_new_full (g_file_hash, (GEqualFunc) g_file_equal, g_object_unref, g_object_unref);
+  standard_view->priv->selected_files_table = g_hash_table_new_full (g_direct_hash, g_direct_equal, g_object_unref, NULL);
 
   /* grab a reference on the preferences */
   standard_view->preferences = thunar_preferences_get ();
@@ -752,6 +769,9 @@ G_GNUC_END_IGNORE_DEPRECATIONS
   /* be sure to update the statusbar text whenever the file-size-binary property changes */
   g_signal_connect_swapped (G_OBJECT (standard_view->model), "notify::file-size-binary", G_CALLBACK (thunar_standard_view_update_statusbar_text), standard_view);
 
+  /* the free space of the folder is queried asynchronously by the model */
+  g_signal_connect_swapped (G_OBJECT (standard_view->model), "notify::free-space", G_CALLBACK (thunar_standard_view_update_statusbar_text), standard_view);
+
   /* connect to size allocation signals for generating thumbnail requests */
   g_signal_connect_after (G_OBJECT (standard_view), "size-allocate",
                           G_CALLBACK (thunar_standard_view_size_allocate), NULL);
@@ -864,6 +884,13 @@ thunar_standard_view_dispose (GObject *object)
   if (G_UNLIKELY (standard_view->priv->drag_timer_id != 0))
     g_source_remove (standard_view->priv->drag_timer_id);
 
+  /* the selection cannot be handled anymore once the view is gone */
+  if (G_UNLIKELY (standard_view->priv->selection_changed_idle_id != 0))
+    {
+      g_source_remove (standard_view->priv->selection_changed_idle_id);
+      standard_view->priv->selection_changed_idle_id = 0;
+    }
+
   /* reset the UI manager property */
   thunar_component_set_ui_manager (THUNAR_COMPONENT (standard_view), NULL);
 
@@ -954,6 +981,9 @@ thunar_standard_view_finalize (GObject *object)
   /* release the scroll_to_files hash table */
   g_hash_table_destroy (standard_view->priv->scroll_to_files);
 
+  /* release the files of the last selection */
+  g_hash_table_destroy (standard_view->priv->selected_files_table);
+
   (*G_OBJECT_CLASS (thunar_standard_view_parent_class)->finalize) (object);
 }
 
@@ -1088,6 +1118,11 @@ thunar_standard_view_realize (GtkWidget *widget)
   g_signal_connect_swapped (G_OBJECT (standard_view->clipboard), "changed",
                             G_CALLBACK (thunar_standard_view_selection_changed), standard_view);
 
+  /* redraw the rows of files that were cut or pasted */
+  standard_view->priv->clipboard_generation = thunar_clipboard_manager_get_generation (standard_view->clipboard);
+  g_signal_connect (G_OBJECT (standard_view->clipboard), "changed",
+                    G_CALLBACK (thunar_standard_view_clipboard_changed), standard_view);
+
   /* determine the icon factory for the screen on which we are realized */
   icon_theme = gtk_icon_theme_get_for_screen (gtk_widget_get_screen (widget));
   standard_view->icon_factory = thunar_icon_factory_get_for_icon_theme (icon_theme);
@@ -1113,6 +1148,7 @@ thunar_standard_view_unrealize (GtkWidget *widget)
 
   /* disconnect the clipboard changed handler */
   g_signal_handlers_disconnect_by_func (G_OBJECT (standard_view->clipboard), thunar_standard_view_selection_changed, standard_view);
+  g_signal_handlers_disconnect_by_func (G_OBJECT (standard_view->clipboard), thunar_standard_view_clipboard_changed, standard_view);
 
   /* drop the reference on the icon factory */
   g_signal_handlers_disconnect_by_func (G_OBJECT (standard_view->icon_factory), gtk_widget_queue_draw, standard_view);
@@ -1172,11 +1208,50 @@ thunar_standard_view_draw (GtkWidget      *widget,
 static GList*
 thunar_standard_view_get_selected_files (ThunarComponent *component)
 {
+  /* make sure a pending selection change was handled */
+  thunar_standard_view_flush_selection (THUNAR_STANDARD_VIEW (component));
+
   return THUNAR_STANDARD_VIEW (component)->priv->selected_files;
 }
 
 
 
+/**
+ * thunar_standard_view_select_paths:
+ * @standard_view : a #ThunarStandardView.
+ * @paths         : a list of #GtkTreePath<!---->s, sorted in ascending order.
+ *
+ * Selects the rows for @paths, where adjacent rows are selected as
+ * one range.
+ **/
+static void
+thunar_standard_view_select_paths (ThunarStandardView *standard_view,
+                                   GList              *paths)
+{
+  GtkTreePath *start_path;
+  GtkTreePath *end_path;
+  GList       *lp;
+
+  _thunar_return_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view));
+
+  for (lp = paths; lp != NULL; )
+    {
+      /* extend the range as long as the rows are adjacent */
+      start_path = end_path = lp->data;
+      for (lp = lp->next; lp != NULL; lp = lp->next)
+        {
+          _thunar_assert (gtk_tree_path_compare (end_path, lp->data) < 0);
+          if (gtk_tree_path_get_indices (lp->data)[0] != gtk_tree_path_get_indices (end_path)[0] + 1)
+            break;
+          end_path = lp->data;
+        }
+
+      (*THUNAR_STANDARD_VIEW_GET_CLASS (standard_view)->select_range) (standard_view, start_path, end_path);
+    }
+}
+
+
+
 static void
 thunar_standard_view_set_selected_files (ThunarComponent *component,
                                          GList           *selected_files)
@@ -1184,7 +1259,6 @@ thunar_standard_view_set_selected_files (ThunarComponent *component,
   ThunarStandardView *standard_view = THUNAR_STANDARD_VIEW (component);
   GtkTreePath        *first_path = NULL;
   GList              *paths;
-  GList              *lp;
 
   /* release the previous selected files list (if any) */
   if (G_UNLIKELY (standard_view->priv->selected_files != NULL))
@@ -1212,23 +1286,14 @@ thunar_standard_view_set_selected_files (ThunarComponent *component,
       paths = thunar_list_model_get_paths_for_files (standard_view->model, selected_files);
       if (G_LIKELY (paths != NULL))
         {
-          /* determine the first path */
-          for (first_path = paths->data, lp = paths; lp != NULL; lp = lp->next)
-            {
-              /* check if this path is located before the current first_path */
-              if (gtk_tree_path_compare (lp->data, first_path) < 0)
-                first_path = lp->data;
-            }
+          /* the paths are sorted, so the first path is the first selected row */
+          first_path = paths->data;
 
           /* place the cursor on the first selected path (must be first for GtkTreeView) */
           (*THUNAR_STANDARD_VIEW_GET_CLASS (standard_view)->set_cursor) (standard_view, first_path, FALSE);
 
-          /* select the given tree paths paths */
-          for (first_path = paths->data, lp = paths; lp != NULL; lp = lp->next)
-            {
-              /* select the path */
-              (*THUNAR_STANDARD_VIEW_GET_CLASS (standard_view)->select_path) (standard_view, lp->data);
-            }
+          /* select the given tree paths */
+          thunar_standard_view_select_paths (standard_view, paths);
 
           /* scroll to the first path (previously determined) */
           (*THUNAR_STANDARD_VIEW_GET_CLASS (standard_view)->scroll_to_path) (standard_view, first_path, FALSE, 0.0f, 0.0f);
@@ -1281,6 +1346,7 @@ G_GNUC_BEGIN_IGNORE_DEPRECATIONS
 
       /* drop our action group from the previous UI manager */
       gtk_ui_manager_remove_action_group (standard_view->ui_manager, standard_view->action_group);
+      g_signal_handlers_disconnect_by_func (G_OBJECT (standard_view->ui_manager), thunar_standard_view_flush_selection, standard_view);
 
       /* unmerge the ui controls from derived classes */
       (*THUNAR_STANDARD_VIEW_GET_CLASS (standard_view)->disconnect_ui_manager) (standard_view, standard_view->ui_manager);
@@ -1307,6 +1373,9 @@ G_GNUC_BEGIN_IGNORE_DEPRECATIONS
       /* add our action group to the new manager */
       gtk_ui_manager_insert_action_group (ui_manager, standard_view->action_group, -1);
 
+      /* actions (including those of the launcher) must see the current selection */
+      g_signal_connect_swapped (G_OBJECT (ui_manager), "pre-activate", G_CALLBACK (thunar_standard_view_flush_selection), standard_view);
+
       /* merge our UI control items with the new manager */
       standard_view->ui_merge_id = gtk_ui_manager_add_ui_from_string (ui_manager, thunar_standard_view_ui,
                                                                       thunar_standard_view_ui_length, &error);
@@ -1477,6 +1546,7 @@ thunar_standard_view_set_current_directory (ThunarNavigator *navigator,
 
       /* reset the folder for the model */
       thunar_list_model_set_folder (standard_view->model, NULL);
+      thunar_standard_view_reset_selection_table (standard_view);
 
       /* reconnect the model to the view */
       g_object_set (G_OBJECT (gtk_bin_get_child (GTK_BIN (standard_view))), "model", standard_view->model, NULL);
@@ -1513,6 +1583,7 @@ thunar_standard_view_set_current_directory (ThunarNavigator *navigator,
 
   /* apply the new folder */
   thunar_list_model_set_folder (standard_view->model, folder);
+  thunar_standard_view_reset_selection_table (standard_view);
   g_object_unref (G_OBJECT (folder));
 
   /* reconnect our model to the view */
@@ -1673,24 +1744,22 @@ static const gchar*
 thunar_standard_view_get_statusbar_text (ThunarView *view)
 {
   ThunarStandardView *standard_view = THUNAR_STANDARD_VIEW (view);
-  GList              *items;
 
   _thunar_return_val_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view), NULL);
 
   /* generate the statusbar text on-demand */
   if (standard_view->priv->statusbar_text == NULL)
     {
-      /* query the selected items (actually a list of GtkTreePath's) */
-      items = THUNAR_STANDARD_VIEW_GET_CLASS (standard_view)->get_selected_items (standard_view);
-
       /* we display a loading text if no items are
-       * selected and the view is loading
+       * selected and the view is loading (the selected
+       * files may be remembered for after loading then)
        */
-      if (items == NULL && standard_view->loading)
+      if (g_hash_table_size (standard_view->priv->selected_files_table) == 0 && standard_view->loading)
         return _("Loading folder contents...");
 
-      standard_view->priv->statusbar_text = thunar_list_model_get_statusbar_text (standard_view->model, items);
-      g_list_free_full (items, (GDestroyNotify) gtk_tree_path_free);
+      /* the last handled selection, the model keeps its totals */
+      standard_view->priv->statusbar_text = thunar_list_model_get_statusbar_text (standard_view->model,
+                                                                                  standard_view->priv->selected_files);
     }
 
   return standard_view->priv->statusbar_text;
@@ -2677,7 +2746,6 @@ thunar_standard_view_action_select_by_pattern (GtkAction          *action,
   GtkWidget   *label;
   GtkWidget   *entry;
   GList       *paths;
-  GList       *lp;
   gint         response;
   const gchar *pattern;
   gchar       *pattern_extended = NULL;
@@ -2732,14 +2800,10 @@ G_GNUC_END_IGNORE_DEPRECATIONS
 
       /* set the cursor and scroll to the first selected item */
       if (paths != NULL)
-        THUNAR_STANDARD_VIEW_GET_CLASS (standard_view)->set_cursor (standard_view, g_list_last (paths)->data, FALSE);
+        THUNAR_STANDARD_VIEW_GET_CLASS (standard_view)->set_cursor (standard_view, paths->data, FALSE);
 
-      for (lp = paths; lp != NULL; lp = lp->next)
-        {
-          THUNAR_STANDARD_VIEW_GET_CLASS (standard_view)->select_path (standard_view, lp->data);
-          gtk_tree_path_free (lp->data);
-        }
-      g_list_free (paths);
+      thunar_standard_view_select_paths (standard_view, paths);
+      g_list_free_full (paths, (GDestroyNotify) gtk_tree_path_free);
       g_free (pattern_extended);
     }
 
@@ -3874,6 +3938,57 @@ thunar_standard_view_row_changed (ThunarListModel    *model,
 
 
 
+static void
+thunar_standard_view_clipboard_changed (ThunarClipboardManager *clipboard,
+                                        ThunarStandardView     *standard_view)
+{
+  GtkTreePath *start_path;
+  GtkTreePath *end_path;
+  GtkTreePath *path;
+  GtkTreeIter  iter;
+  ThunarFile  *file;
+  gboolean     valid_iter;
+  guint        generation;
+
+  _thunar_return_if_fail (THUNAR_IS_CLIPBOARD_MANAGER (clipboard));
+  _thunar_return_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view));
+
+  /* nothing to do if the clipboard files did not change */
+  generation = thunar_clipboard_manager_get_generation (clipboard);
+  if (standard_view->priv->clipboard_generation == generation)
+    return;
+  standard_view->priv->clipboard_generation = generation;
+
+  /* rows outside the visible range are drawn with the new state anyway */
+  if (!(*THUNAR_STANDARD_VIEW_GET_CLASS (standard_view)->get_visible_range) (standard_view, &start_path, &end_path))
+    return;
+
+  for (valid_iter = gtk_tree_model_get_iter (GTK_TREE_MODEL (standard_view->model), &iter, start_path); valid_iter; )
+    {
+      path = gtk_tree_model_get_path (GTK_TREE_MODEL (standard_view->model), &iter);
+
+      /* redraw the row if the file was cut or is no longer cut */
+      file = thunar_list_model_get_file (standard_view->model, &iter);
+      if (thunar_clipboard_manager_has_cutted_file (clipboard, file)
+          != thunar_clipboard_manager_had_cutted_file (clipboard, file))
+        gtk_tree_model_row_changed (GTK_TREE_MODEL (standard_view->model), path, &iter);
+      g_object_unref (G_OBJECT (file));
+
+      /* stop at the end of the visible range */
+      if (gtk_tree_path_compare (path, end_path) != 0)
+        valid_iter = gtk_tree_model_iter_next (GTK_TREE_MODEL (standard_view->model), &iter);
+      else
+        valid_iter = FALSE;
+
+      gtk_tree_path_free (path);
+    }
+
+  gtk_tree_path_free (start_path);
+  gtk_tree_path_free (end_path);
+}
+
+
+
 static void
 thunar_standard_view_select_after_row_deleted (ThunarListModel    *model,
                                                GtkTreePath        *path,
@@ -4188,8 +4303,15 @@ thunar_standard_view_request_thumbnails_real (ThunarStandardView *standard_view,
   GtkTreePath *path;
   GtkTreeIter  iter;
   ThunarFile  *file;
+  ThunarFile  *drop_file;
   gboolean     valid_iter;
   GList       *visible_files = NULL;
+  GList       *prefetch_files = NULL;
+  gint         icon_size;
+  gint         start_index;
+  gint         end_index;
+  gint         n_rows;
+  gint         n;
 
   _thunar_return_val_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view), FALSE);
   _thunar_return_val_if_fail (THUNAR_IS_ICON_FACTORY (standard_view->icon_factory), FALSE);
@@ -4236,13 +4358,39 @@ thunar_standard_view_request_thumbnails_real (ThunarStandardView *standard_view,
           gtk_tree_path_free (path);
         }
 
+      /* request the visible files from top to bottom */
+      visible_files = g_list_reverse (visible_files);
+
+      /* prefetch a page of files below and above the visible range, after the
+       * visible files, so they are likely ready when the user scrolls */
+      start_index = gtk_tree_path_get_indices (start_path)[0];
+      end_index = gtk_tree_path_get_indices (end_path)[0];
+      n_rows = gtk_tree_model_iter_n_children (GTK_TREE_MODEL (standard_view->model), NULL);
+
+      for (n = end_index + 1; n <= end_index + (end_index - start_index + 1) && n < n_rows; ++n)
+        if (gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (standard_view->model), &iter, NULL, n))
+          prefetch_files = g_list_prepend (prefetch_files, thunar_list_model_get_file (standard_view->model, &iter));
+
+      for (n = start_index - 1; n >= start_index - (end_index - start_index + 1) && n >= 0; --n)
+        if (gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (standard_view->model), &iter, NULL, n))
+          prefetch_files = g_list_prepend (prefetch_files, thunar_list_model_get_file (standard_view->model, &iter));
+
+      prefetch_files = g_list_reverse (prefetch_files);
+
       /* queue a thumbnail request */
       thunar_thumbnailer_queue_files (standard_view->priv->thumbnailer,
-                                      lazy_request, visible_files,
+                                      lazy_request, visible_files, prefetch_files,
                                       &standard_view->priv->thumbnail_request);
 
-      /* release the file list */
+      /* keep the icons of the visible files in the icon cache */
+      g_object_get (G_OBJECT (standard_view->icon_renderer), "size", &icon_size, "drop-file", &drop_file, NULL);
+      thunar_icon_factory_prefetch_icons (standard_view->icon_factory, visible_files, drop_file, icon_size);
+      if (drop_file != NULL)
+        g_object_unref (drop_file);
+
+      /* release the file lists */
       g_list_free_full (visible_files, g_object_unref);
+      g_list_free_full (prefetch_files, g_object_unref);
 
       /* release the start and end path */
       gtk_tree_path_free (start_path);
@@ -4353,6 +4501,9 @@ thunar_standard_view_context_menu (ThunarStandardView *standard_view)
 
   _thunar_return_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view));
 
+  /* the menu must be setup for the current selection */
+  thunar_standard_view_flush_selection (standard_view);
+
   /* merge the custom menu actions for the selected items */
   selected_items = (*THUNAR_STANDARD_VIEW_GET_CLASS (standard_view)->get_selected_items) (standard_view);
   thunar_standard_view_merge_custom_actions (standard_view, selected_items);
@@ -4441,17 +4592,6 @@ thunar_standard_view_queue_popup (ThunarStandardView *standard_view,
 void
 thunar_standard_view_selection_changed (ThunarStandardView *standard_view)
 {
-  GtkTreeIter iter;
-  ThunarFile *current_directory;
-  gboolean    can_paste_into_folder;
-  gboolean    restorable;
-  gboolean    pastable;
-  gboolean    writable;
-  gboolean    trashed;
-  gboolean    show_delete_action;
-  GList      *lp, *selected_files;
-  gint        n_selected_files = 0;
-
   _thunar_return_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view));
 
   /* drop any existing "new-files" closure */
@@ -4462,12 +4602,87 @@ thunar_standard_view_selection_changed (ThunarStandardView *standard_view)
       standard_view->priv->new_files_closure = NULL;
     }
 
-  /* release the previously selected files */
-  thunar_g_file_list_free (standard_view->priv->selected_files);
+  /* a selection often changes many times in a row (e.g. while
+   * rubberbanding or selecting files one by one), so the new
+   * selection is only handled once before the next redraw */
+  if (standard_view->priv->selection_changed_idle_id == 0)
+    {
+      standard_view->priv->selection_changed_idle_id =
+          g_idle_add_full (G_PRIORITY_HIGH_IDLE, thunar_standard_view_selection_changed_idle,
+                           standard_view, NULL);
+    }
+}
+
+
+
+static void
+thunar_standard_view_flush_selection (ThunarStandardView *standard_view)
+{
+  _thunar_return_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view));
+
+  /* handle a pending selection change right away */
+  if (standard_view->priv->selection_changed_idle_id != 0)
+    {
+      g_source_remove (standard_view->priv->selection_changed_idle_id);
+      thunar_standard_view_selection_changed_idle (standard_view);
+    }
+}
+
+
+
+static void
+thunar_standard_view_reset_selection_table (ThunarStandardView *standard_view)
+{
+  _thunar_return_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view));
+
+  /* handle the selection change caused by swapping the model first, so
+   * the files of the previous folder are reported as unselected */
+  thunar_standard_view_flush_selection (standard_view);
+
+  /* forget the last handled selection, the next one is handled from scratch */
+  if (g_hash_table_size (standard_view->priv->selected_files_table) > 0)
+    {
+      g_hash_table_remove_all (standard_view->priv->selected_files_table);
+      standard_view->priv->n_trashed_files = 0;
+
+      /* make sure the consumers of "selected-files" learn about it */
+      standard_view->priv->selection_reset = TRUE;
+      thunar_standard_view_selection_changed (standard_view);
+    }
+}
+
+
+
+static gboolean
+thunar_standard_view_selection_changed_idle (gpointer user_data)
+{
+  ThunarStandardView *standard_view = THUNAR_STANDARD_VIEW (user_data);
+  GtkTreeIter         iter;
+  GHashTableIter      hash_iter;
+  GHashTable         *previous_files;
+  ThunarFile         *current_directory;
+  ThunarFile         *file;
+  gboolean            can_paste_into_folder;
+  gboolean            restorable;
+  gboolean            pastable;
+  gboolean            writable;
+  gboolean            trashed;
+  gboolean            show_delete_action;
+  GList              *lp, *selected_files;
+  guint               n_added = 0;
+  guint               n_removed;
+  gint                n_selected_files = 0;
+
+THUNAR_THREADS_ENTER
+
+  /* the selection is handled now, the notifications below may already
+   * lead to another flush or a new selection change */
+  standard_view->priv->selection_changed_idle_id = 0;
 
   /* determine the new list of selected files (replacing GtkTreePath's with ThunarFile's) */
+  previous_files = standard_view->priv->selected_files_table;
+  standard_view->priv->selected_files_table = g_hash_table_new_full (g_direct_hash, g_direct_equal, g_object_unref, NULL);
   selected_files = (*THUNAR_STANDARD_VIEW_GET_CLASS (standard_view)->get_selected_items) (standard_view);
-  restorable = (selected_files != NULL);
   for (lp = selected_files; lp != NULL; lp = lp->next, ++n_selected_files)
     {
       /* determine the iterator for the path */
@@ -4478,15 +4693,38 @@ thunar_standard_view_selection_changed (ThunarStandardView *standard_view)
 
       /* ...and replace it with the file */
       lp->data = thunar_list_model_get_file (standard_view->model, &iter);
+      g_hash_table_insert (standard_view->priv->selected_files_table, g_object_ref (lp->data), lp->data);
+
+      /* check if the file was selected before */
+      if (!g_hash_table_remove (previous_files, lp->data))
+        {
+          n_added++;
+          if (thunar_file_is_trashed (lp->data))
+            standard_view->priv->n_trashed_files++;
+
+          /* add the file to the selection totals of the statusbar */
+          thunar_list_model_set_file_selected (standard_view->model, lp->data, TRUE);
+        }
+    }
 
-      /* enable "Restore" if we have only trashed files (atleast one file) */
-      if (!thunar_file_is_trashed (lp->data))
-        restorable = FALSE;
+  /* the files that are left were unselected */
+  n_removed = g_hash_table_size (previous_files);
+  g_hash_table_iter_init (&hash_iter, previous_files);
+  while (g_hash_table_iter_next (&hash_iter, (gpointer) &file, NULL))
+    {
+      if (thunar_file_is_trashed (file))
+        standard_view->priv->n_trashed_files--;
+      thunar_list_model_set_file_selected (standard_view->model, file, FALSE);
     }
+  g_hash_table_destroy (previous_files);
 
-  /* and setup the new selected files list */
+  /* release the previously selected files and setup the new list */
+  thunar_g_file_list_free (standard_view->priv->selected_files);
   standard_view->priv->selected_files = selected_files;
 
+  /* enable "Restore" if we have only trashed files (atleast one file) */
+  restorable = (n_selected_files > 0 && standard_view->priv->n_trashed_files == (guint) n_selected_files);
+
   /* check whether the folder displayed by the view is writable/in the trash */
   current_directory = thunar_navigator_get_current_directory (THUNAR_NAVIGATOR (standard_view));
   writable = (current_directory != NULL && thunar_file_is_writable (current_directory));
@@ -4591,11 +4829,23 @@ G_GNUC_END_IGNORE_DEPRECATIONS
                                      n_selected_files),
                 NULL);
 
-  /* update the statusbar text */
-  thunar_standard_view_update_statusbar_text (standard_view);
+  /* the actions above also depend on the folder and the clipboard,
+   * but the statusbar and the consumers of "selected-files" (e.g.
+   * the launcher) only have to be updated if the selection changed */
+  if (n_added > 0 || n_removed > 0 || standard_view->priv->selection_reset)
+    {
+      standard_view->priv->selection_reset = FALSE;
+
+      /* update the statusbar text */
+      thunar_standard_view_update_statusbar_text (standard_view);
+
+      /* emit notification for "selected-files" */
+      g_object_notify_by_pspec (G_OBJECT (standard_view), standard_view_props[PROP_SELECTED_FILES]);
+    }
+
+THUNAR_THREADS_LEAVE
 
-  /* emit notification for "selected-files" */
-  g_object_notify_by_pspec (G_OBJECT (standard_view), standard_view_props[PROP_SELECTED_FILES]);
+  return FALSE;
 }
 
 
@@ -69,6 +69,11 @@ struct _ThunarStandardViewClass
   void         (*select_path)           (ThunarStandardView *standard_view,
                                          GtkTreePath        *path);
 
+  /* Selects all items from start_path to end_path (inclusive) */
+  void         (*select_range)          (ThunarStandardView *standard_view,
+                                         GtkTreePath        *start_path,
+                                         GtkTreePath        *end_path);
+
   /* Called by the ThunarStandardView class to let derived class
    * place the cursor on the item/row referred to by path. If
    * start_editing is TRUE, the derived class should also start
@@ -663,17 +663,49 @@ void
 thunar_thumbnail_cache_cleanup_file (ThunarThumbnailCache *cache,
                                      GFile                *file)
 {
+  GList files = { NULL, NULL, NULL };
+
   _thunar_return_if_fail (THUNAR_IS_THUMBNAIL_CACHE (cache));
   _thunar_return_if_fail (G_IS_FILE (file));
 
+  files.data = file;
+  thunar_thumbnail_cache_cleanup_files (cache, &files);
+}
+
+
+
+/**
+ * thunar_thumbnail_cache_cleanup_files:
+ * @cache : a #ThunarThumbnailCache.
+ * @files : a #GList of #GFile<!---->s.
+ *
+ * Queues the thumbnails of all @files for cleanup. The queue is
+ * flushed with a single D-Bus call, so prefer this over calling
+ * thunar_thumbnail_cache_cleanup_file() for every file.
+ **/
+void
+thunar_thumbnail_cache_cleanup_files (ThunarThumbnailCache *cache,
+                                      GList                *files)
+{
+  GList *lp;
+
+  _thunar_return_if_fail (THUNAR_IS_THUMBNAIL_CACHE (cache));
+
+  if (files == NULL)
+    return;
+
   /* acquire a cache lock */
   _thumbnail_cache_lock (cache);
 
   /* check if we have a valid proxy for the cache service */
   if (cache->proxy_state != THUNAR_THUMBNAIL_CACHE_PROXY_FAILED)
     {
-      /* add the file to the cleanup queue */
-      cache->cleanup_queue = g_list_prepend (cache->cleanup_queue, g_object_ref (file));
+      /* add the files to the cleanup queue */
+      for (lp = files; lp != NULL; lp = lp->next)
+        {
+          _thunar_assert (G_IS_FILE (lp->data));
+          cache->cleanup_queue = g_list_prepend (cache->cleanup_queue, g_object_ref (lp->data));
+        }
     }
 
   if (cache->proxy_state == THUNAR_THUMBNAIL_CACHE_PROXY_AVAILABLE)
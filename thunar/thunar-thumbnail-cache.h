@@ -50,6 +50,8 @@ void                  thunar_thumbnail_cache_delete_file  (ThunarThumbnailCache
                                                            GFile                *file);
 void                  thunar_thumbnail_cache_cleanup_file (ThunarThumbnailCache *cache,
                                                            GFile                *file);
+void                  thunar_thumbnail_cache_cleanup_files (ThunarThumbnailCache *cache,
+                                                            GList                *files);
 
 G_END_DECLS
 
@@ -68,12 +68,28 @@
  * ========
  *
  * The Finished signal handler looks up the internal request ID based on
- * the D-Bus thumbnailer handle. It then drops all corresponding information
- * from handle_request_mapping and request_handle_mapping.
+ * the D-Bus thumbnailer handle. If the request has files left, the next
+ * batch is sent out, otherwise the request is finished and dropped.
+ *
+ *
+ * Batches
+ * =======
+ *
+ * A request is not sent to tumbler at once. The files are sent in batches
+ * of at most THUNAR_THUMBNAILER_MAX_BATCH_SIZE files, one batch at a time,
+ * the files visible in the view first and the files around them after
+ * that using the background scheduler. This way, requests that are
+ * superseded while scrolling are dropped before most of their files
+ * have been sent out.
  */
 
 
 
+/* maximum number of files sent to tumbler in one call */
+#define THUNAR_THUMBNAILER_MAX_BATCH_SIZE (50)
+
+
+
 typedef enum
 {
   THUNAR_THUMBNAILER_IDLE_ERROR,
@@ -140,6 +156,8 @@ static void                   thunar_thumbnailer_set_property           (GObject
                                                                          guint                       prop_id,
                                                                          const GValue               *value,
                                                                          GParamSpec                 *pspec);
+static void                   thunar_thumbnailer_continue_job           (ThunarThumbnailer          *thumbnailer,
+                                                                         ThunarThumbnailerJob       *job);
 
 #if GLIB_CHECK_VERSION (2, 32, 0)
 #define _thumbnailer_lock(thumbnailer)    g_mutex_lock (&((thumbnailer)->lock))
@@ -166,8 +184,9 @@ struct _ThunarThumbnailer
   ThunarThumbnailerDBus      *thumbnailer_proxy;
   ThunarThumbnailerProxyState proxy_state;
 
-  /* running jobs */
-  GSList     *jobs;
+  /* running jobs, request ID -> job and tumbler handle -> job */
+  GHashTable *jobs;
+  GHashTable *handles;
 
 #if GLIB_CHECK_VERSION (2, 32, 0)
   GMutex      lock;
@@ -186,6 +205,12 @@ struct _ThunarThumbnailer
 
   /* IDs of idle functions */
   GSList     *idles;
+
+  /* number of files not sent to tumbler yet and the time it
+   * took to process the batches that were sent */
+  guint       n_waiting;
+  guint       n_batches;
+  gint64      batch_latency;
 };
 
 struct _ThunarThumbnailerJob
@@ -197,15 +222,22 @@ struct _ThunarThumbnailerJob
 
   guint              lazy_checks : 1;
 
-  /* data is saved here in case the queueing is delayed */
-  /* If this is NULL, the request has been sent off. */
+  /* if the queue call of the current batch is running */
+  guint              sending : 1;
+
+  /* files that have not been sent off yet, the visible
+   * files first, followed by the ones around them */
   GList             *files; /* element type: ThunarFile */
+  GList             *prefetch_files; /* element type: ThunarFile */
 
   /* request number returned by ThunarThumbnailer */
   guint              request;
 
-  /* handle returned by the tumbler dbus service */
+  /* handle returned by the tumbler dbus service for the current batch */
   guint              handle;
+
+  /* when the current batch was sent off */
+  gint64             batch_time;
 };
 
 struct _ThunarThumbnailerIdle
@@ -310,14 +342,35 @@ thunar_thumbnailer_set_property (GObject      *object,
     }
 }
 
+
+
+static void
+thunar_thumbnailer_drop_files (ThunarThumbnailerJob *job)
+{
+  /* forget about the files that were not sent off */
+  job->thumbnailer->n_waiting -= g_list_length (job->files) + g_list_length (job->prefetch_files);
+
+  g_list_free_full (job->files, g_object_unref);
+  job->files = NULL;
+
+  g_list_free_full (job->prefetch_files, g_object_unref);
+  job->prefetch_files = NULL;
+}
+
+
+
 static void
 thunar_thumbnailer_free_job (ThunarThumbnailerJob *job)
 {
-  if (job->files)
-    g_list_free_full (job->files, g_object_unref);
+  thunar_thumbnailer_drop_files (job);
 
-  if (job->thumbnailer && job->thumbnailer->thumbnailer_proxy && job->handle)
-    thunar_thumbnailer_dbus_call_dequeue (job->thumbnailer->thumbnailer_proxy, job->handle, NULL, NULL, NULL);
+  if (job->handle != 0)
+    {
+      g_hash_table_remove (job->thumbnailer->handles, GUINT_TO_POINTER (job->handle));
+
+      if (job->thumbnailer->thumbnailer_proxy != NULL)
+        thunar_thumbnailer_dbus_call_dequeue (job->thumbnailer->thumbnailer_proxy, job->handle, NULL, NULL, NULL);
+    }
 
   g_slice_free (ThunarThumbnailerJob, job);
 }
@@ -345,23 +398,29 @@ thunar_thumbnailer_queue_async_reply (GObject      *proxy,
 
   thunar_thumbnailer_dbus_call_queue_finish (THUNAR_THUMBNAILER_DBUS (proxy), &handle, res, &error);
 
+  job->sending = FALSE;
+
   if (job->cancelled)
     {
       /* job is cancelled while there was no handle jet, so dequeue it now */
-      thunar_thumbnailer_dbus_call_dequeue (THUNAR_THUMBNAILER_DBUS (proxy), handle, NULL, NULL, NULL);
+      if (error == NULL)
+        thunar_thumbnailer_dbus_call_dequeue (THUNAR_THUMBNAILER_DBUS (proxy), handle, NULL, NULL, NULL);
 
       /* cleanup */
-      thumbnailer->jobs = g_slist_remove (thumbnailer->jobs, job);
-      thunar_thumbnailer_free_job (job);
+      g_hash_table_remove (thumbnailer->jobs, GUINT_TO_POINTER (job->request));
     }
   else if (error == NULL)
     {
       /* store the handle returned by tumbler */
       job->handle = handle;
+      g_hash_table_insert (thumbnailer->handles, GUINT_TO_POINTER (handle), job);
     }
   else
     {
       g_printerr ("ThunarThumbnailer: Queue failed: %s\n", error->message);
+
+      /* try the next batch, or finish the request */
+      thunar_thumbnailer_continue_job (thumbnailer, job);
     }
 
   _thumbnailer_unlock (thumbnailer);
@@ -385,9 +444,10 @@ thunar_thumbnailer_begin_job (ThunarThumbnailer *thumbnailer,
   GList                 *supported_files = NULL;
   guint                  n;
   guint                  n_items = 0;
+  guint                  n_visible = 0;
+  gboolean               visible;
   ThunarFileThumbState   thumb_state;
   const gchar           *thumbnail_path;
-  gint                   request_no;
 
   if (thumbnailer->proxy_state == THUNAR_THUMBNAILER_PROXY_WAITING)
     {
@@ -400,15 +460,37 @@ thunar_thumbnailer_begin_job (ThunarThumbnailer *thumbnailer,
       return FALSE;
     }
 
-  /* collect all supported files from the list that are neither in the
-   * about to be queued (wait queue), nor already queued, nor already
-   * processed (and awaiting to be refreshed) */
-  for (lp = job->files; lp != NULL; lp = lp->next)
+  /* collect the next batch of supported files from the list that are
+   * neither in the about to be queued (wait queue), nor already queued,
+   * nor already processed (and awaiting to be refreshed). the visible
+   * files go first */
+  while (n_items < THUNAR_THUMBNAILER_MAX_BATCH_SIZE)
     {
+      if (job->files != NULL)
+        {
+          lp = job->files;
+          job->files = g_list_remove_link (job->files, lp);
+          visible = TRUE;
+        }
+      else if (job->prefetch_files != NULL)
+        {
+          lp = job->prefetch_files;
+          job->prefetch_files = g_list_remove_link (job->prefetch_files, lp);
+          visible = FALSE;
+        }
+      else
+        {
+          /* no files left */
+          break;
+        }
+
+      thumbnailer->n_waiting--;
+
       /* the icon factory only loads icons for regular files and folders */
       if (!thunar_file_is_regular (lp->data) && !thunar_file_is_directory (lp->data))
         {
           thunar_file_set_thumb_state (lp->data, THUNAR_FILE_THUMB_STATE_NONE);
+          g_list_free_full (lp, g_object_unref);
           continue;
         }
 
@@ -421,15 +503,22 @@ thunar_thumbnailer_begin_job (ThunarThumbnailer *thumbnailer,
            * been loaded or are not supported */
           if (thumb_state == THUNAR_FILE_THUMB_STATE_NONE
               || thumb_state == THUNAR_FILE_THUMB_STATE_READY)
-            continue;
+            {
+              g_list_free_full (lp, g_object_unref);
+              continue;
+            }
         }
 
       /* check if the file is supported, assume it is when the state was ready previously */
       if (thumb_state == THUNAR_FILE_THUMB_STATE_READY
           || thunar_thumbnailer_file_is_supported (thumbnailer, lp->data))
         {
-          supported_files = g_list_prepend (supported_files, lp->data);
+          supported_files = g_list_concat (lp, supported_files);
           n_items++;
+
+          /* the batch contains files the user is looking at */
+          if (visible)
+            n_visible++;
         }
       else
         {
@@ -442,6 +531,8 @@ thunar_thumbnailer_begin_job (ThunarThumbnailer *thumbnailer,
             thunar_file_set_thumb_state (lp->data, THUNAR_FILE_THUMB_STATE_READY);
           else
             thunar_file_set_thumb_state (lp->data, THUNAR_FILE_THUMB_STATE_NONE);
+
+          g_list_free_full (lp, g_object_unref);
         }
     }
 
@@ -460,33 +551,27 @@ thunar_thumbnailer_begin_job (ThunarThumbnailer *thumbnailer,
 
           /* save URI and MIME hint in the arrays */
           uris[n] = thunar_file_dup_uri (lp->data);
-          mime_hints[n] = thunar_file_get_content_type (lp->data);
+          mime_hints[n] = thunar_file_peek_content_type (lp->data);
         }
 
       /* NULL-terminate both arrays */
       uris[n] = NULL;
       mime_hints[n] = NULL;
 
-      /* queue a thumbnail request for the URIs from the wait queue */
-      /* compute the next request ID, making sure it's never 0 */
-      request_no = thumbnailer->last_request + 1;
-      request_no = MAX (request_no, 1);
-
-      /* remember the ID for the next request */
-      thumbnailer->last_request = request_no;
-
-      /* save the request number */
-      job->request = request_no;
+      /* remember when the batch was sent off */
+      job->sending = TRUE;
+      job->batch_time = g_get_monotonic_time ();
 
       /* increase the reference count while the dbus call is running */
       g_object_ref (thumbnailer);
 
-      /* queue the request - asynchronously, of course */
+      /* queue the request - asynchronously, of course. files around
+       * the visible area are generated when tumbler is idle */
       thunar_thumbnailer_dbus_call_queue (thumbnailer->thumbnailer_proxy,
                                           (const gchar *const *)uris,
                                           (const gchar *const *)mime_hints,
                                           thunar_thumbnail_size_get_nick (thumbnailer->thumbnail_size),
-                                          "foreground", 0,
+                                          n_visible > 0 ? "foreground" : "background", 0,
                                           NULL,
                                           thunar_thumbnailer_queue_async_reply,
                                           job);
@@ -495,22 +580,36 @@ thunar_thumbnailer_begin_job (ThunarThumbnailer *thumbnailer,
       g_free (mime_hints);
       g_strfreev (uris);
 
-      /* free the list of supported files */
-      g_list_free (supported_files);
-
-      /* free the list of files passed in */
-      g_list_free_full (job->files, g_object_unref);
-      job->files = NULL;
-
       /* we assume success if we've come so far */
       success = TRUE;
     }
 
+  /* free the list of supported files */
+  g_list_free_full (supported_files, g_object_unref);
+
   return success;
 }
 
 
 
+/* NOTE: assumes that the lock is held by the caller */
+static void
+thunar_thumbnailer_continue_job (ThunarThumbnailer    *thumbnailer,
+                                 ThunarThumbnailerJob *job)
+{
+  /* send the next batch of the request */
+  if (thunar_thumbnailer_begin_job (thumbnailer, job))
+    return;
+
+  /* tell everybody we're done here */
+  g_signal_emit (G_OBJECT (thumbnailer), thumbnailer_signals[REQUEST_FINISHED], 0, job->request);
+
+  /* remove job from the table */
+  g_hash_table_remove (thumbnailer->jobs, GUINT_TO_POINTER (job->request));
+}
+
+
+
 static void
 thunar_thumbnailer_init (ThunarThumbnailer *thumbnailer)
 {
@@ -520,6 +619,11 @@ thunar_thumbnailer_init (ThunarThumbnailer *thumbnailer)
   thumbnailer->lock = g_mutex_new ();
 #endif
 
+  /* lookup tables for the running jobs */
+  thumbnailer->jobs = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                             NULL, (GDestroyNotify) thunar_thumbnailer_free_job);
+  thumbnailer->handles = g_hash_table_new (g_direct_hash, g_direct_equal);
+
   /* initialize the proxies */
   thunar_thumbnailer_init_thumbnailer_proxy (thumbnailer);
 }
@@ -553,7 +657,8 @@ thunar_thumbnailer_finalize (GObject *object)
   g_slist_free (thumbnailer->idles);
 
   /* remove all jobs */
-  g_slist_free_full (thumbnailer->jobs, (GDestroyNotify)thunar_thumbnailer_free_job);
+  g_hash_table_destroy (thumbnailer->jobs);
+  g_hash_table_destroy (thumbnailer->handles);
 
   /* release the thumbnailer proxy */
   if (thumbnailer->thumbnailer_proxy != NULL)
@@ -618,12 +723,13 @@ thunar_thumbnailer_received_supported_types (ThunarThumbnailerDBus  *proxy,
                                              GAsyncResult           *result,
                                              ThunarThumbnailer      *thumbnailer)
 {
-  guint       n;
-  gchar     **schemes = NULL;
-  gchar     **types = NULL;
-  GPtrArray  *schemes_array;
-  GSList     *lp = NULL;
-  GError     *error = NULL;
+  guint           n;
+  gchar         **schemes = NULL;
+  gchar         **types = NULL;
+  GPtrArray      *schemes_array;
+  GHashTableIter  iter;
+  gpointer        job;
+  GError         *error = NULL;
 
   _thunar_return_if_fail (THUNAR_IS_THUMBNAILER (thumbnailer));
   _thunar_return_if_fail (THUNAR_IS_THUMBNAILER_DBUS (proxy));
@@ -633,8 +739,7 @@ thunar_thumbnailer_received_supported_types (ThunarThumbnailerDBus  *proxy,
 
   if (!thunar_thumbnailer_dbus_call_get_supported_finish (proxy, &schemes, &types, result, &error))
     {
-      g_slist_free_full (thumbnailer->jobs, (GDestroyNotify)thunar_thumbnailer_free_job);
-      thumbnailer->jobs = NULL;
+      g_hash_table_remove_all (thumbnailer->jobs);
 
       g_printerr ("ThunarThumbnailer: Failed to retrieve supported types: %s\n", error->message);
       g_clear_error (&error);
@@ -683,15 +788,10 @@ thunar_thumbnailer_received_supported_types (ThunarThumbnailerDBus  *proxy,
   thumbnailer->thumbnailer_proxy = proxy;
 
   /* now start delayed jobs */
-  for (lp = thumbnailer->jobs; lp; lp = lp->next)
-    {
-      if (!thunar_thumbnailer_begin_job (thumbnailer, lp->data))
-        {
-          thunar_thumbnailer_free_job (lp->data);
-          lp->data = NULL;
-        }
-    }
-  thumbnailer->jobs = g_slist_remove_all (thumbnailer->jobs, NULL);
+  g_hash_table_iter_init (&iter, thumbnailer->jobs);
+  while (g_hash_table_iter_next (&iter, NULL, &job))
+    if (!thunar_thumbnailer_begin_job (thumbnailer, job))
+      g_hash_table_iter_remove (&iter);
 
   g_clear_error (&error);
 
@@ -721,8 +821,7 @@ thunar_thumbnailer_proxy_created (GObject       *object,
       g_printerr ("ThunarThumbnailer: failed to create proxy: %s", error->message);
       g_clear_error (&error);
 
-      g_slist_free_full (thumbnailer->jobs, (GDestroyNotify)thunar_thumbnailer_free_job);
-      thumbnailer->jobs = NULL;
+      g_hash_table_remove_all (thumbnailer->jobs);
 
       _thumbnailer_unlock (thumbnailer);
 
@@ -797,8 +896,8 @@ thunar_thumbnailer_file_is_supported (ThunarThumbnailer *thumbnailer,
   _thunar_return_val_if_fail (THUNAR_IS_THUMBNAILER_DBUS (thumbnailer->thumbnailer_proxy), FALSE);
   _thunar_return_val_if_fail (thumbnailer->supported != NULL, FALSE);
 
-  /* determine the content type of the passed file */
-  content_type = thunar_file_get_content_type (file);
+  /* determine the content type of the passed file, without blocking */
+  content_type = thunar_file_peek_content_type (file);
 
   /* abort if the content type is unknown */
   if (content_type == NULL)
@@ -866,31 +965,24 @@ thunar_thumbnailer_thumbnailer_finished (GDBusProxy        *proxy,
                                          ThunarThumbnailer *thumbnailer)
 {
   ThunarThumbnailerJob *job;
-  GSList               *lp;
 
   _thunar_return_if_fail (G_IS_DBUS_PROXY (proxy));
   _thunar_return_if_fail (THUNAR_IS_THUMBNAILER (thumbnailer));
 
   _thumbnailer_lock (thumbnailer);
 
-  for (lp = thumbnailer->jobs; lp != NULL; lp = lp->next)
+  job = g_hash_table_lookup (thumbnailer->handles, GUINT_TO_POINTER (handle));
+  if (job != NULL)
     {
-      job = lp->data;
-
-      if (job->handle == handle)
-        {
-          /* this job is finished, forget about the handle */
-          job->handle = 0;
-
-          /* tell everybody we're done here */
-          g_signal_emit (G_OBJECT (thumbnailer), thumbnailer_signals[REQUEST_FINISHED], 0, job->request);
+      /* this batch is finished, forget about the handle */
+      g_hash_table_remove (thumbnailer->handles, GUINT_TO_POINTER (handle));
+      job->handle = 0;
 
-          /* remove job from the list */
-          thumbnailer->jobs = g_slist_delete_link (thumbnailer->jobs, lp);
+      thumbnailer->n_batches++;
+      thumbnailer->batch_latency += g_get_monotonic_time () - job->batch_time;
 
-          thunar_thumbnailer_free_job (job);
-          break;
-        }
+      /* send the next batch or finish the request */
+      thunar_thumbnailer_continue_job (thumbnailer, job);
     }
 
   _thumbnailer_unlock (thumbnailer);
@@ -904,9 +996,7 @@ thunar_thumbnailer_idle (ThunarThumbnailer          *thumbnailer,
                          ThunarThumbnailerIdleType   type,
                          const gchar               **uris)
 {
-  GSList                *lp;
   ThunarThumbnailerIdle *idle;
-  ThunarThumbnailerJob  *job;
 
   /* leave if there are no uris */
   if (G_UNLIKELY (uris == NULL))
@@ -919,30 +1009,23 @@ thunar_thumbnailer_idle (ThunarThumbnailer          *thumbnailer,
    * want each window (because they all have a connection to the
    * same proxy) emit the file change, only the window that requested
    * the data */
-  for (lp = thumbnailer->jobs; lp != NULL; lp = lp->next)
+  if (g_hash_table_lookup (thumbnailer->handles, GUINT_TO_POINTER (handle)) != NULL)
     {
-      job = lp->data;
-
-      if (job->handle == handle)
-        {
-          /* allocate a new idle struct */
-          idle = g_slice_new0 (ThunarThumbnailerIdle);
-          idle->type = type;
-          idle->thumbnailer = thumbnailer;
-
-          /* copy the URI array because we need it in the idle function */
-          idle->uris = g_strdupv ((gchar **)uris);
+      /* allocate a new idle struct */
+      idle = g_slice_new0 (ThunarThumbnailerIdle);
+      idle->type = type;
+      idle->thumbnailer = thumbnailer;
 
-          /* remember the idle struct because we might have to remove it in finalize() */
-          thumbnailer->idles = g_slist_prepend (thumbnailer->idles, idle);
+      /* copy the URI array because we need it in the idle function */
+      idle->uris = g_strdupv ((gchar **)uris);
 
-          /* call the idle function when we have the time */
-          idle->id = g_idle_add_full (G_PRIORITY_LOW,
-                                      thunar_thumbnailer_idle_func, idle,
-                                      thunar_thumbnailer_idle_free);
+      /* remember the idle struct because we might have to remove it in finalize() */
+      thumbnailer->idles = g_slist_prepend (thumbnailer->idles, idle);
 
-          break;
-        }
+      /* call the idle function when we have the time */
+      idle->id = g_idle_add_full (G_PRIORITY_LOW,
+                                  thunar_thumbnailer_idle_func, idle,
+                                  thunar_thumbnailer_idle_free);
     }
 
   _thumbnailer_unlock (thumbnailer);
@@ -1066,19 +1149,36 @@ thunar_thumbnailer_queue_file (ThunarThumbnailer *thumbnailer,
   files.prev = NULL;
 
   /* queue a thumbnail request for the file */
-  return thunar_thumbnailer_queue_files (thumbnailer, FALSE, &files, request);
+  return thunar_thumbnailer_queue_files (thumbnailer, FALSE, &files, NULL, request);
 }
 
 
 
+/**
+ * thunar_thumbnailer_queue_files:
+ * @thumbnailer    : a #ThunarThumbnailer.
+ * @lazy_checks    : whether to skip files with a known thumbnail state.
+ * @files          : the #ThunarFile<!---->s that are visible.
+ * @prefetch_files : the #ThunarFile<!---->s around the visible ones, or %NULL.
+ * @request        : return location for the request ID, or %NULL.
+ *
+ * Requests thumbnails for @files and @prefetch_files. The files are
+ * sent to the thumbnailer in batches, @files first and @prefetch_files
+ * after them with a lower priority. Files of a request that are not sent
+ * off yet are dropped by thunar_thumbnailer_dequeue().
+ *
+ * Return value: %TRUE if the request was queued.
+ **/
 gboolean
 thunar_thumbnailer_queue_files (ThunarThumbnailer *thumbnailer,
                                 gboolean           lazy_checks,
                                 GList             *files,
+                                GList             *prefetch_files,
                                 guint             *request)
 {
   gboolean               success = FALSE;
   ThunarThumbnailerJob  *job = NULL;
+  guint                  request_no;
 
   _thunar_return_val_if_fail (THUNAR_IS_THUMBNAILER (thumbnailer), FALSE);
   _thunar_return_val_if_fail (files != NULL, FALSE);
@@ -1086,17 +1186,28 @@ thunar_thumbnailer_queue_files (ThunarThumbnailer *thumbnailer,
   /* acquire the thumbnailer lock */
   _thumbnailer_lock (thumbnailer);
 
+  /* compute the next request ID, making sure it's never 0 */
+  request_no = thumbnailer->last_request + 1;
+  request_no = MAX (request_no, 1);
+
+  /* remember the ID for the next request */
+  thumbnailer->last_request = request_no;
+
   /* allocate a job */
   job = g_slice_new0 (ThunarThumbnailerJob);
   job->thumbnailer = thumbnailer;
+  job->request = request_no;
   job->files = g_list_copy_deep (files, (GCopyFunc)g_object_ref, NULL);
+  job->prefetch_files = g_list_copy_deep (prefetch_files, (GCopyFunc)g_object_ref, NULL);
   job->lazy_checks = lazy_checks ? 1 : 0;
 
+  thumbnailer->n_waiting += g_list_length (job->files) + g_list_length (job->prefetch_files);
+
   success = thunar_thumbnailer_begin_job (thumbnailer, job);
   if (success)
     {
-      thumbnailer->jobs = g_slist_prepend (thumbnailer->jobs, job);
-      if (*request)
+      g_hash_table_insert (thumbnailer->jobs, GUINT_TO_POINTER (job->request), job);
+      if (request != NULL)
         *request = job->request;
     }
   else
@@ -1117,35 +1228,61 @@ thunar_thumbnailer_dequeue (ThunarThumbnailer *thumbnailer,
                             guint              request)
 {
   ThunarThumbnailerJob *job;
-  GSList               *lp;
 
   _thunar_return_if_fail (THUNAR_IS_THUMBNAILER (thumbnailer));
 
   /* acquire the thumbnailer lock */
   _thumbnailer_lock (thumbnailer);
 
-  for (lp = thumbnailer->jobs; lp != NULL; lp = lp->next)
+  /* find the request in the table */
+  job = g_hash_table_lookup (thumbnailer->jobs, GUINT_TO_POINTER (request));
+  if (job != NULL)
     {
-      job = lp->data;
-
-      /* find the request in the list */
-      if (job->request == request)
-        {
-          /* this job is cancelled */
-          job->cancelled = TRUE;
-
-          if (job->handle != 0)
-            {
-              /* remove job */
-              thumbnailer->jobs = g_slist_delete_link (thumbnailer->jobs, lp);
+      /* this job is cancelled */
+      job->cancelled = TRUE;
 
-              thunar_thumbnailer_free_job (job);
-            }
+      /* the files that were not sent off are never sent */
+      thunar_thumbnailer_drop_files (job);
 
-          break;
-        }
+      /* remove job, unless we are waiting for its handle */
+      if (!job->sending)
+        g_hash_table_remove (thumbnailer->jobs, GUINT_TO_POINTER (request));
     }
 
   /* release the thumbnailer lock */
   _thumbnailer_unlock (thumbnailer);
 }
+
+
+
+/**
+ * thunar_thumbnailer_get_statistics:
+ * @thumbnailer   : a #ThunarThumbnailer.
+ * @n_waiting     : return location for the number of files that were not
+ *                  sent to the thumbnailer yet, or %NULL.
+ * @n_batches     : return location for the number of finished batches, or %NULL.
+ * @batch_latency : return location for the average time in microseconds
+ *                  it took to finish a batch, or %NULL.
+ *
+ * Returns the queue depth and latency of the requests of @thumbnailer,
+ * for profiling.
+ **/
+void
+thunar_thumbnailer_get_statistics (ThunarThumbnailer *thumbnailer,
+                                   guint             *n_waiting,
+                                   guint             *n_batches,
+                                   gint64            *batch_latency)
+{
+  _thunar_return_if_fail (THUNAR_IS_THUMBNAILER (thumbnailer));
+
+  _thumbnailer_lock (thumbnailer);
+
+  if (n_waiting != NULL)
+    *n_waiting = thumbnailer->n_waiting;
+  if (n_batches != NULL)
+    *n_batches = thumbnailer->n_batches;
+  if (batch_latency != NULL)
+    *batch_latency = (thumbnailer->n_batches > 0) ? thumbnailer->batch_latency / thumbnailer->n_batches : 0;
+
+  _thumbnailer_unlock (thumbnailer);
+}
@@ -45,10 +45,16 @@ gboolean           thunar_thumbnailer_queue_file      (ThunarThumbnailer
 gboolean           thunar_thumbnailer_queue_files     (ThunarThumbnailer        *thumbnailer,
                                                        gboolean                  lazy_checks,
                                                        GList                    *files,
+                                                       GList                    *prefetch_files,
                                                        guint                    *request);
 void               thunar_thumbnailer_dequeue         (ThunarThumbnailer        *thumbnailer,
                                                        guint                     request);
 
+void               thunar_thumbnailer_get_statistics  (ThunarThumbnailer        *thumbnailer,
+                                                       guint                    *n_waiting,
+                                                       guint                    *n_batches,
+                                                       gint64                   *batch_latency);
+
 G_END_DECLS
 
 #endif /* !__THUNAR_THUMBNAILER_H__ */
@@ -23,11 +23,38 @@
 #include <config.h>
 #endif
 
+/* for copy_file_range() */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#ifdef HAVE_SYS_TYPES_H
+#include <sys/types.h>
+#endif
+#ifdef HAVE_SYS_STAT_H
+#include <sys/stat.h>
+#endif
+#ifdef HAVE_SYS_IOCTL_H
+#include <sys/ioctl.h>
+#endif
+#ifdef HAVE_LINUX_FS_H
+#include <linux/fs.h>
+#endif
+
+#ifdef HAVE_ERRNO_H
+#include <errno.h>
+#endif
+#ifdef HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
 #include <gio/gio.h>
 
 #include <thunar/thunar-application.h>
 #include <thunar/thunar-gio-extensions.h>
-#include <thunar/thunar-io-scan-directory.h>
 #include <thunar/thunar-io-jobs-util.h>
 #include <thunar/thunar-job.h>
 #include <thunar/thunar-preferences.h>
@@ -40,6 +67,29 @@
 /* seconds before we show the transfer rate + remaining time */
 #define MINIMUM_TRANSFER_TIME (10 * G_USEC_PER_SEC) /* 10 seconds */
 
+/* attributes of the files we keep in the transfer nodes */
+#define TRANSFER_NODE_ATTRIBUTES G_FILE_ATTRIBUTE_STANDARD_NAME "," \
+                                 G_FILE_ATTRIBUTE_STANDARD_DISPLAY_NAME "," \
+                                 G_FILE_ATTRIBUTE_STANDARD_SIZE "," \
+                                 G_FILE_ATTRIBUTE_STANDARD_TYPE
+
+/* bytes copied by the kernel between two progress updates */
+#define LOCAL_COPY_CHUNK_SIZE (8 * 1024 * 1024) /* 8 MiB */
+
+
+
+#if GLIB_CHECK_VERSION (2, 32, 0)
+#define _transfer_job_lock(job)       g_mutex_lock (&((job)->lock))
+#define _transfer_job_unlock(job)     g_mutex_unlock (&((job)->lock))
+#define _transfer_job_ask_lock(job)   g_mutex_lock (&((job)->ask_lock))
+#define _transfer_job_ask_unlock(job) g_mutex_unlock (&((job)->ask_lock))
+#else
+#define _transfer_job_lock(job)       g_mutex_lock ((job)->lock)
+#define _transfer_job_unlock(job)     g_mutex_unlock ((job)->lock)
+#define _transfer_job_ask_lock(job)   g_mutex_lock ((job)->ask_lock)
+#define _transfer_job_ask_unlock(job) g_mutex_unlock ((job)->ask_lock)
+#endif
+
 
 
 /* Property identifiers */
@@ -51,7 +101,9 @@ enum
 
 
 
-typedef struct _ThunarTransferNode ThunarTransferNode;
+typedef struct _ThunarTransferNode     ThunarTransferNode;
+typedef struct _ThunarTransferCopy     ThunarTransferCopy;
+typedef struct _ThunarTransferProgress ThunarTransferProgress;
 
 
 
@@ -69,6 +121,8 @@ static void     thunar_transfer_job_finalize     (GObject                *object
 static gboolean thunar_transfer_job_execute      (ExoJob                 *job,
                                                   GError                **error);
 static void     thunar_transfer_node_free        (gpointer                data);
+static void     thunar_transfer_job_copy_worker  (gpointer                data,
+                                                  gpointer                user_data);
 
 
 
@@ -91,11 +145,29 @@ struct _ThunarTransferJob
 
   guint64               total_size;
   guint64               total_progress;
-  guint64               file_progress;
   guint64               transfer_rate;
 
   ThunarPreferences    *preferences;
   gboolean              file_size_binary;
+
+  /* files copied in parallel by the worker threads */
+  guint                 n_parallel_copies;
+  GThreadPool          *copy_pool;
+  GError               *copy_error;
+
+  /* protects the progress and the copy error */
+#if GLIB_CHECK_VERSION (2, 32, 0)
+  GMutex                lock;
+#else
+  GMutex               *lock;
+#endif
+
+  /* makes sure only one question is asked at a time */
+#if GLIB_CHECK_VERSION (2, 32, 0)
+  GMutex                ask_lock;
+#else
+  GMutex               *ask_lock;
+#endif
 };
 
 struct _ThunarTransferNode
@@ -103,6 +175,23 @@ struct _ThunarTransferNode
   ThunarTransferNode *next;
   ThunarTransferNode *children;
   GFile              *source_file;
+
+  /* information about the source file */
+  gchar              *display_name;
+  guint64             size;
+  GFileType           type;
+};
+
+struct _ThunarTransferCopy
+{
+  ThunarTransferNode  node;
+  GFile              *target_file;
+};
+
+struct _ThunarTransferProgress
+{
+  ThunarTransferJob *job;
+  guint64            file_progress;
 };
 
 
@@ -153,11 +242,23 @@ thunar_transfer_job_init (ThunarTransferJob *job)
   job->target_file_list = NULL;
   job->total_size = 0;
   job->total_progress = 0;
-  job->file_progress = 0;
   job->last_update_time = 0;
   job->last_total_progress = 0;
   job->transfer_rate = 0;
   job->start_time = 0;
+
+  /* determine the number of files we may copy at the same time */
+  g_object_get (G_OBJECT (job->preferences), "misc-transfer-parallel-copies", &job->n_parallel_copies, NULL);
+  job->copy_pool = NULL;
+  job->copy_error = NULL;
+
+#if GLIB_CHECK_VERSION (2, 32, 0)
+  g_mutex_init (&job->lock);
+  g_mutex_init (&job->ask_lock);
+#else
+  job->lock = g_mutex_new ();
+  job->ask_lock = g_mutex_new ();
+#endif
 }
 
 
@@ -173,6 +274,20 @@ thunar_transfer_job_finalize (GObject *object)
 
   g_object_unref (job->preferences);
 
+  /* the copies are always finished when the job is done */
+  _thunar_assert (job->copy_pool == NULL);
+
+  if (G_UNLIKELY (job->copy_error != NULL))
+    g_error_free (job->copy_error);
+
+#if GLIB_CHECK_VERSION (2, 32, 0)
+  g_mutex_clear (&job->lock);
+  g_mutex_clear (&job->ask_lock);
+#else
+  g_mutex_free (job->lock);
+  g_mutex_free (job->ask_lock);
+#endif
+
   (*G_OBJECT_CLASS (thunar_transfer_job_parent_class)->finalize) (object);
 }
 
@@ -227,21 +342,26 @@ thunar_transfer_job_progress (goffset  current_num_bytes,
                               goffset  total_num_bytes,
                               gpointer user_data)
 {
-  ThunarTransferJob *job = user_data;
-  guint64            new_percentage;
-  gint64             current_time;
-  gint64             expired_time;
-  guint64            transfer_rate;
+  ThunarTransferProgress *progress = user_data;
+  ThunarTransferJob      *job = progress->job;
+  guint64                 new_percentage = 0;
+  gint64                  current_time;
+  gint64                  expired_time;
+  guint64                 transfer_rate;
+  gboolean                notify = FALSE;
 
   _thunar_return_if_fail (THUNAR_IS_TRANSFER_JOB (job));
 
   if (G_LIKELY (job->total_size > 0))
     {
+      /* other files may be copied in parallel */
+      _transfer_job_lock (job);
+
       /* update total progress */
-      job->total_progress += (current_num_bytes - job->file_progress);
+      job->total_progress += (current_num_bytes - progress->file_progress);
 
       /* update file progress */
-      job->file_progress = current_num_bytes;
+      progress->file_progress = current_num_bytes;
 
       /* compute the new percentage after the progress we've made */
       new_percentage = (job->total_progress * 100.0) / job->total_size;
@@ -262,28 +382,47 @@ thunar_transfer_job_progress (goffset  current_num_bytes,
           else
             job->transfer_rate = transfer_rate;
 
-          /* emit the percent signal */
-          exo_job_percent (EXO_JOB (job), new_percentage);
-
           /* update internals */
           job->last_update_time = current_time;
           job->last_total_progress = job->total_progress;
+
+          notify = TRUE;
         }
+
+      _transfer_job_unlock (job);
+
+      /* emit the percent signal */
+      if (notify)
+        exo_job_percent (EXO_JOB (job), new_percentage);
     }
 }
 
 
 
+static void
+thunar_transfer_node_set_info (ThunarTransferNode *node,
+                               GFileInfo          *info)
+{
+  _thunar_return_if_fail (node != NULL);
+  _thunar_return_if_fail (G_IS_FILE_INFO (info));
+
+  g_free (node->display_name);
+  node->display_name = g_strdup (g_file_info_get_display_name (info));
+  node->size = g_file_info_get_size (info);
+  node->type = g_file_info_get_file_type (info);
+}
+
+
+
 static gboolean
 thunar_transfer_job_collect_node (ThunarTransferJob  *job,
                                   ThunarTransferNode *node,
                                   GError            **error)
 {
   ThunarTransferNode *child_node;
+  GFileEnumerator    *enumerator;
   GFileInfo          *info;
   GError             *err = NULL;
-  GList              *file_list;
-  GList              *lp;
 
   _thunar_return_val_if_fail (THUNAR_IS_TRANSFER_JOB (job), FALSE);
   _thunar_return_val_if_fail (node != NULL && G_IS_FILE (node->source_file), FALSE);
@@ -292,32 +431,33 @@ thunar_transfer_job_collect_node (ThunarTransferJob  *job,
   if (exo_job_set_error_if_cancelled (EXO_JOB (job), error))
     return FALSE;
 
-  info = g_file_query_info (node->source_file,
-                            G_FILE_ATTRIBUTE_STANDARD_SIZE ","
-                            G_FILE_ATTRIBUTE_STANDARD_TYPE,
-                            G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
-                            exo_job_get_cancellable (EXO_JOB (job)),
-                            &err);
-
-  if (G_UNLIKELY (info == NULL))
-    return FALSE;
-
-  job->total_size += g_file_info_get_size (info);
+  /* the size and type of the node were read with its parent */
+  job->total_size += node->size;
 
   /* check if we have a directory here */
-  if (g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY)
+  if (node->type == G_FILE_TYPE_DIRECTORY)
     {
-      /* scan the directory for immediate children */
-      file_list = thunar_io_scan_directory (THUNAR_JOB (job), node->source_file,
-                                            G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
-                                            FALSE, FALSE, FALSE, &err);
+      /* enumerate the immediate children along with their size and type */
+      enumerator = g_file_enumerate_children (node->source_file,
+                                              TRANSFER_NODE_ATTRIBUTES,
+                                              G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                              exo_job_get_cancellable (EXO_JOB (job)),
+                                              &err);
 
       /* add children to the transfer node */
-      for (lp = file_list; err == NULL && lp != NULL; lp = lp->next)
+      while (err == NULL && !exo_job_set_error_if_cancelled (EXO_JOB (job), &err))
         {
+          info = g_file_enumerator_next_file (enumerator,
+                                              exo_job_get_cancellable (EXO_JOB (job)),
+                                              &err);
+          if (info == NULL)
+            break;
+
           /* allocate a new transfer node for the child */
           child_node = g_slice_new0 (ThunarTransferNode);
-          child_node->source_file = g_object_ref (lp->data);
+          child_node->source_file = g_file_get_child (node->source_file, g_file_info_get_name (info));
+          thunar_transfer_node_set_info (child_node, info);
+          g_object_unref (info);
 
           /* hook the child node into the child list */
           child_node->next = node->children;
@@ -327,13 +467,11 @@ thunar_transfer_job_collect_node (ThunarTransferJob  *job,
           thunar_transfer_job_collect_node (job, child_node, &err);
         }
 
-      /* release the child files */
-      thunar_g_file_list_free (file_list);
+      /* release the enumerator */
+      if (enumerator != NULL)
+        g_object_unref (enumerator);
     }
 
-  /* release file info */
-  g_object_unref (info);
-
   if (G_UNLIKELY (err != NULL))
     {
       g_propagate_error (error, err);
@@ -345,18 +483,161 @@ thunar_transfer_job_collect_node (ThunarTransferJob  *job,
 
 
 
+static gboolean
+ttj_copy_file_local (ThunarTransferJob      *job,
+                     GFile                  *source_file,
+                     GFile                  *target_file,
+                     GFileCopyFlags          copy_flags,
+                     ThunarTransferProgress *progress,
+                     GError                **error)
+{
+#if defined (FICLONE) || defined (HAVE_COPY_FILE_RANGE)
+  struct stat statb;
+  gboolean    copied = FALSE;
+  gboolean    failed = FALSE;
+  goffset     offset = 0;
+  gssize      n;
+  gchar      *source_path = NULL;
+  gchar      *target_path = NULL;
+  gchar      *display_name;
+  gint        source_fd = -1;
+  gint        target_fd = -1;
+  gint        errsv = 0;
+
+  _thunar_return_val_if_fail (THUNAR_IS_TRANSFER_JOB (job), FALSE);
+  _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  /* only new files on local file systems, GIO takes care of
+   * overwriting existing files and reports the usual errors */
+  if ((copy_flags & G_FILE_COPY_OVERWRITE) != 0
+      || !g_file_is_native (source_file)
+      || !g_file_is_native (target_file))
+    return FALSE;
+
+  source_path = g_file_get_path (source_file);
+  target_path = g_file_get_path (target_file);
+  if (G_UNLIKELY (source_path == NULL || target_path == NULL))
+    goto out;
+
+  /* leave anything but regular files to GIO */
+  source_fd = open (source_path, O_RDONLY);
+  if (source_fd < 0 || fstat (source_fd, &statb) < 0 || !S_ISREG (statb.st_mode))
+    goto out;
+
+  /* create the target with the permissions of the source, masked by the umask,
+   * so it never ends up with stricter permissions than g_file_copy() would give */
+  target_fd = open (target_path, O_WRONLY | O_CREAT | O_EXCL, statb.st_mode & 0777);
+  if (target_fd < 0)
+    goto out;
+
+#ifdef FICLONE
+  /* try to share the data blocks of the source on copy-on-write file systems */
+  if (ioctl (target_fd, FICLONE, source_fd) == 0)
+    {
+      offset = statb.st_size;
+      thunar_transfer_job_progress (offset, statb.st_size, progress);
+      copied = TRUE;
+    }
+#endif
+
+#ifdef HAVE_COPY_FILE_RANGE
+  /* let the kernel copy the data without passing it through userspace */
+  while (!copied && !failed)
+    {
+      if (exo_job_is_cancelled (EXO_JOB (job)))
+        {
+          failed = TRUE;
+          break;
+        }
+
+      n = copy_file_range (source_fd, NULL, target_fd, NULL, LOCAL_COPY_CHUNK_SIZE, 0);
+      if (n > 0)
+        {
+          offset += n;
+          thunar_transfer_job_progress (offset, statb.st_size, progress);
+        }
+      else if (n == 0 && offset == 0 && statb.st_size > 0)
+        {
+          /* procfs, sysfs and some fuse file systems report a size but
+           * return no data here, leave those files to GIO */
+          failed = TRUE;
+        }
+      else if (n == 0)
+        {
+          copied = TRUE;
+        }
+      else if (errno != EINTR)
+        {
+          errsv = errno;
+          failed = TRUE;
+        }
+    }
+#endif
+
+  /* the data could be on a network share, so check for write errors */
+  if (close (target_fd) < 0 && copied)
+    {
+      errsv = errno;
+      copied = FALSE;
+      failed = TRUE;
+    }
+  target_fd = -1;
+
+  /* copy the permissions and extended attributes like g_file_copy() does */
+  if (G_LIKELY (copied)
+      && !g_file_copy_attributes (source_file, target_file, copy_flags,
+                                  exo_job_get_cancellable (EXO_JOB (job)), error))
+    {
+      /* report the problem instead of leaving a target with the wrong attributes */
+      unlink (target_path);
+      copied = FALSE;
+    }
+  else if (!copied)
+    {
+      /* remove the incomplete target file */
+      unlink (target_path);
+
+      /* fall back to GIO unless cancelled or data was copied already */
+      if (!exo_job_set_error_if_cancelled (EXO_JOB (job), error) && failed && offset > 0)
+        {
+          display_name = g_filename_display_name (target_path);
+          g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errsv),
+                       _("Failed to write to \"%s\": %s"),
+                       display_name, g_strerror (errsv));
+          g_free (display_name);
+        }
+    }
+
+out:
+  if (source_fd >= 0)
+    close (source_fd);
+  if (target_fd >= 0)
+    close (target_fd);
+
+  g_free (source_path);
+  g_free (target_path);
+
+  return copied;
+#else
+  return FALSE;
+#endif
+}
+
+
+
 static gboolean
 ttj_copy_file (ThunarTransferJob *job,
                GFile             *source_file,
+               GFileType          source_type,
                GFile             *target_file,
                GFileCopyFlags     copy_flags,
                gboolean           merge_directories,
                GError           **error)
 {
-  GFileType source_type;
-  GFileType target_type;
-  gboolean  target_exists;
-  GError   *err = NULL;
+  ThunarTransferProgress progress;
+  GFileType              target_type;
+  gboolean               target_exists;
+  GError                *err = NULL;
 
   _thunar_return_val_if_fail (THUNAR_IS_TRANSFER_JOB (job), FALSE);
   _thunar_return_val_if_fail (G_IS_FILE (source_file), FALSE);
@@ -364,25 +645,28 @@ ttj_copy_file (ThunarTransferJob *job,
   _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
   /* reset the file progress */
-  job->file_progress = 0;
+  progress.job = job;
+  progress.file_progress = 0;
 
   if (exo_job_set_error_if_cancelled (EXO_JOB (job), error))
     return FALSE;
 
-  source_type = g_file_query_file_type (source_file, G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
-                                        exo_job_get_cancellable (EXO_JOB (job)));
-
-  if (exo_job_set_error_if_cancelled (EXO_JOB (job), error))
-    return FALSE;
-
-  target_type = g_file_query_file_type (target_file, G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
-                                        exo_job_get_cancellable (EXO_JOB (job)));
+  /* the target type only matters if we are in overwrite mode */
+  if ((copy_flags & G_FILE_COPY_OVERWRITE) != 0)
+    {
+      target_type = g_file_query_file_type (target_file, G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                            exo_job_get_cancellable (EXO_JOB (job)));
 
-  if (exo_job_set_error_if_cancelled (EXO_JOB (job), error))
-    return FALSE;
+      if (exo_job_set_error_if_cancelled (EXO_JOB (job), error))
+        return FALSE;
+    }
+  else
+    {
+      target_type = G_FILE_TYPE_UNKNOWN;
+    }
 
   /* check if the target is a symlink and we are in overwrite mode */
-  if (target_type == G_FILE_TYPE_SYMBOLIC_LINK && (copy_flags & G_FILE_COPY_OVERWRITE) != 0)
+  if (target_type == G_FILE_TYPE_SYMBOLIC_LINK)
     {
       /* try to delete the symlink */
       if (!g_file_delete (target_file, exo_job_get_cancellable (EXO_JOB (job)), &err))
@@ -392,14 +676,31 @@ ttj_copy_file (ThunarTransferJob *job,
         }
     }
 
-  /* try to copy the file */
-  g_file_copy (source_file, target_file, copy_flags,
-               exo_job_get_cancellable (EXO_JOB (job)),
-               thunar_transfer_job_progress, job, &err);
+  /* try to let the kernel copy local files */
+  if (source_type == G_FILE_TYPE_REGULAR
+      && ttj_copy_file_local (job, source_file, target_file, copy_flags, &progress, &err))
+    return TRUE;
+
+  /* try to copy the file, unless the local copy already failed */
+  if (G_LIKELY (err == NULL))
+    {
+      g_file_copy (source_file, target_file, copy_flags,
+                   exo_job_get_cancellable (EXO_JOB (job)),
+                   thunar_transfer_job_progress, &progress, &err);
+    }
 
   /* check if there were errors */
   if (G_UNLIKELY (err != NULL && err->domain == G_IO_ERROR))
     {
+      /* determine the type of the existing target only if we copy a directory */
+      if (err->code == G_IO_ERROR_EXISTS
+          && source_type == G_FILE_TYPE_DIRECTORY
+          && target_type == G_FILE_TYPE_UNKNOWN)
+        {
+          target_type = g_file_query_file_type (target_file, G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                                exo_job_get_cancellable (EXO_JOB (job)));
+        }
+
       if (err->code == G_IO_ERROR_WOULD_MERGE
           || (err->code == G_IO_ERROR_EXISTS
               && source_type == G_FILE_TYPE_DIRECTORY
@@ -470,6 +771,7 @@ ttj_copy_file (ThunarTransferJob *job,
  * thunar_transfer_job_copy_file:
  * @job                : a #ThunarTransferJob.
  * @source_file        : the source #GFile to copy.
+ * @source_type        : the #GFileType of @source_file.
  * @target_file        : the destination #GFile to copy to.
  * @error              : return location for errors or %NULL.
  *
@@ -491,6 +793,7 @@ ttj_copy_file (ThunarTransferJob *job,
 static GFile *
 thunar_transfer_job_copy_file (ThunarTransferJob *job,
                                GFile             *source_file,
+                               GFileType          source_type,
                                GFile             *target_file,
                                GError           **error)
 {
@@ -514,7 +817,7 @@ thunar_transfer_job_copy_file (ThunarTransferJob *job,
       if (G_LIKELY (!g_file_equal (source_file, target_file)))
         {
           /* try to copy the file from source_file to the target_file */
-          if (ttj_copy_file (job, source_file, target_file, copy_flags, TRUE, &err))
+          if (ttj_copy_file (job, source_file, source_type, target_file, copy_flags, TRUE, &err))
             {
               /* return the real target file */
               return g_object_ref (target_file);
@@ -532,7 +835,7 @@ thunar_transfer_job_copy_file (ThunarTransferJob *job,
               if (err == NULL)
                 {
                   /* try to copy the file from source file to the duplicate file */
-                  if (ttj_copy_file (job, source_file, duplicate_file, copy_flags, TRUE, &err))
+                  if (ttj_copy_file (job, source_file, source_type, duplicate_file, copy_flags, TRUE, &err))
                     {
                       /* return the real target file */
                       return duplicate_file;
@@ -556,8 +859,10 @@ thunar_transfer_job_copy_file (ThunarTransferJob *job,
           g_clear_error (&err);
 
           /* ask the user whether to replace the target file */
+          _transfer_job_ask_lock (job);
           response = thunar_job_ask_replace (THUNAR_JOB (job), source_file,
                                              target_file, &err);
+          _transfer_job_ask_unlock (job);
 
           if (err != NULL)
             break;
@@ -588,6 +893,86 @@ thunar_transfer_job_copy_file (ThunarTransferJob *job,
 
 
 
+static void
+thunar_transfer_job_push_copy (ThunarTransferJob  *job,
+                               ThunarTransferNode *node,
+                               GFile              *target_parent_file,
+                               GError            **error)
+{
+  ThunarTransferCopy *copy;
+  gchar              *base_name;
+
+  _thunar_return_if_fail (THUNAR_IS_TRANSFER_JOB (job));
+  _thunar_return_if_fail (node != NULL && G_IS_FILE (node->source_file));
+  _thunar_return_if_fail (G_IS_FILE (target_parent_file));
+  _thunar_return_if_fail (error == NULL || *error == NULL);
+
+  /* don't queue more files if one of the workers failed, the
+   * error itself is kept for the workers and propagated later */
+  _transfer_job_lock (job);
+  if (G_UNLIKELY (job->copy_error != NULL))
+    {
+      g_propagate_error (error, g_error_copy (job->copy_error));
+      _transfer_job_unlock (job);
+      return;
+    }
+  _transfer_job_unlock (job);
+
+  /* take a copy of the node, the node itself may be released before the copy */
+  copy = g_slice_new0 (ThunarTransferCopy);
+  copy->node.source_file = g_object_ref (node->source_file);
+  copy->node.display_name = g_strdup (node->display_name);
+  copy->node.size = node->size;
+  copy->node.type = node->type;
+
+  /* determine the target file */
+  base_name = g_file_get_basename (node->source_file);
+  copy->target_file = g_file_get_child (target_parent_file, base_name);
+  g_free (base_name);
+
+  /* allocate the workers on demand */
+  if (job->copy_pool == NULL)
+    {
+      job->copy_pool = g_thread_pool_new (thunar_transfer_job_copy_worker, job,
+                                          job->n_parallel_copies, FALSE, NULL);
+    }
+
+  /* copy the file in this thread if no workers could be created */
+  if (G_LIKELY (job->copy_pool != NULL))
+    g_thread_pool_push (job->copy_pool, copy, NULL);
+  else
+    thunar_transfer_job_copy_worker (copy, job);
+}
+
+
+
+static void
+thunar_transfer_job_wait_copies (ThunarTransferJob  *job,
+                                 GError            **error)
+{
+  _thunar_return_if_fail (THUNAR_IS_TRANSFER_JOB (job));
+
+  /* wait until all queued files are copied */
+  if (job->copy_pool != NULL)
+    {
+      g_thread_pool_free (job->copy_pool, FALSE, TRUE);
+      job->copy_pool = NULL;
+    }
+
+  /* propagate the first error of the workers, unless we already failed */
+  if (G_UNLIKELY (job->copy_error != NULL))
+    {
+      if (error != NULL && *error == NULL)
+        *error = job->copy_error;
+      else
+        g_error_free (job->copy_error);
+
+      job->copy_error = NULL;
+    }
+}
+
+
+
 static void
 thunar_transfer_job_copy_node (ThunarTransferJob  *job,
                                ThunarTransferNode *node,
@@ -599,7 +984,6 @@ thunar_transfer_job_copy_node (ThunarTransferJob  *job,
   ThunarThumbnailCache *thumbnail_cache;
   ThunarApplication    *application;
   ThunarJobResponse     response;
-  GFileInfo            *info;
   GError               *err = NULL;
   GFile                *real_target_file = NULL;
   gchar                *base_name;
@@ -622,6 +1006,16 @@ thunar_transfer_job_copy_node (ThunarTransferJob  *job,
 
   for (; err == NULL && node != NULL; node = node->next)
     {
+      /* hand files without children over to the workers if the target is local */
+      if (target_file == NULL
+          && node->children == NULL
+          && job->n_parallel_copies > 1
+          && g_file_is_native (target_parent_file))
+        {
+          thunar_transfer_job_push_copy (job, node, target_parent_file, &err);
+          continue;
+        }
+
       /* guess the target file for this node (unless already provided) */
       if (G_LIKELY (target_file == NULL))
         {
@@ -632,26 +1026,12 @@ thunar_transfer_job_copy_node (ThunarTransferJob  *job,
       else
         target_file = g_object_ref (target_file);
 
-      /* query file info */
-      info = g_file_query_info (node->source_file,
-                                G_FILE_ATTRIBUTE_STANDARD_DISPLAY_NAME,
-                                G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
-                                exo_job_get_cancellable (EXO_JOB (job)),
-                                &err);
-
-      /* abort on error or cancellation */
-      if (info == NULL)
-        {
-          g_object_unref (target_file);
-          break;
-        }
-
       /* update progress information */
-      exo_job_info_message (EXO_JOB (job), "%s", g_file_info_get_display_name (info));
+      exo_job_info_message (EXO_JOB (job), "%s", node->display_name);
 
 retry_copy:
       /* copy the item specified by this node (not recursively) */
-      real_target_file = thunar_transfer_job_copy_file (job, node->source_file,
+      real_target_file = thunar_transfer_job_copy_file (job, node->source_file, node->type,
                                                         target_file, &err);
       if (G_LIKELY (real_target_file != NULL))
         {
@@ -669,6 +1049,10 @@ retry_copy:
                   /* copy all children of this node */
                   thunar_transfer_job_copy_node (job, node->children, NULL, real_target_file, NULL, &err);
 
+                  /* the children must be copied before the source can be removed */
+                  if (job->type == THUNAR_TRANSFER_JOB_MOVE)
+                    thunar_transfer_job_wait_copies (job, &err);
+
                   /* free resources allocted for the children */
                   thunar_transfer_node_free (node->children);
                   node->children = NULL;
@@ -706,8 +1090,10 @@ retry_remove:
                   else
                     {
                       /* ask the user to retry */
+                      _transfer_job_ask_lock (job);
                       response = thunar_job_ask_skip (THUNAR_JOB (job), "%s",
                                                       err->message);
+                      _transfer_job_ask_unlock (job);
 
                       /* reset the error */
                       g_clear_error (&err);
@@ -727,7 +1113,9 @@ retry_remove:
           if (err->domain != G_IO_ERROR || err->code != G_IO_ERROR_NO_SPACE)
             {
               /* ask the user to skip this node and all subnodes */
+              _transfer_job_ask_lock (job);
               response = thunar_job_ask_skip (THUNAR_JOB (job), "%s", err->message);
+              _transfer_job_ask_unlock (job);
 
               /* reset the error */
               g_clear_error (&err);
@@ -741,9 +1129,6 @@ retry_remove:
       /* release the guessed target file */
       g_object_unref (target_file);
       target_file = NULL;
-
-      /* release file info */
-      g_object_unref (info);
     }
 
   /* release the thumbnail cache */
@@ -756,6 +1141,43 @@ retry_remove:
 
 
 
+static void
+thunar_transfer_job_copy_worker (gpointer data,
+                                 gpointer user_data)
+{
+  ThunarTransferCopy *copy = data;
+  ThunarTransferJob  *job = THUNAR_TRANSFER_JOB (user_data);
+  gboolean            failed;
+  GError             *err = NULL;
+
+  /* skip the remaining files once a copy failed */
+  _transfer_job_lock (job);
+  failed = (job->copy_error != NULL);
+  _transfer_job_unlock (job);
+
+  /* copy the file, the user is asked to skip or retry on errors */
+  if (G_LIKELY (!failed))
+    thunar_transfer_job_copy_node (job, &copy->node, copy->target_file, NULL, NULL, &err);
+
+  /* remember the first unrecoverable error */
+  if (G_UNLIKELY (err != NULL))
+    {
+      _transfer_job_lock (job);
+      if (job->copy_error == NULL)
+        job->copy_error = err;
+      else
+        g_error_free (err);
+      _transfer_job_unlock (job);
+    }
+
+  g_object_unref (copy->node.source_file);
+  g_free (copy->node.display_name);
+  g_object_unref (copy->target_file);
+  g_slice_free (ThunarTransferCopy, copy);
+}
+
+
+
 static gboolean
 thunar_transfer_job_verify_destination (ThunarTransferJob  *transfer_job,
                                         GError            **error)
@@ -892,8 +1314,9 @@ thunar_transfer_job_execute (ExoJob  *job,
       /* determine the current source transfer node */
       node = sp->data;
 
+      /* query the information we keep in the node */
       info = g_file_query_info (node->source_file,
-                                G_FILE_ATTRIBUTE_STANDARD_DISPLAY_NAME,
+                                TRANSFER_NODE_ATTRIBUTES,
                                 G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
                                 exo_job_get_cancellable (job),
                                 &err);
@@ -901,6 +1324,8 @@ thunar_transfer_job_execute (ExoJob  *job,
       if (G_UNLIKELY (info == NULL))
         break;
 
+      thunar_transfer_node_set_info (node, info);
+
       flags = G_FILE_COPY_NOFOLLOW_SYMLINKS | G_FILE_COPY_NO_FALLBACK_FOR_MOVE | G_FILE_COPY_ALL_METADATA;
 
       /* check if we are moving a file out of the trash */
@@ -1066,6 +1491,9 @@ thunar_transfer_job_execute (ExoJob  *job,
           thunar_transfer_job_copy_node (transfer_job, sp->data, tp->data, NULL,
                                          &new_files_list, &err);
         }
+
+      /* wait for the files still being copied by the workers */
+      thunar_transfer_job_wait_copies (transfer_job, &err);
     }
 
   /* check if we failed */
@@ -1101,6 +1529,7 @@ thunar_transfer_node_free (gpointer data)
 
       /* drop the source file of this node */
       g_object_unref (node->source_file);
+      g_free (node->display_name);
 
       /* release the resources of this node */
       g_slice_free (ThunarTransferNode, node);
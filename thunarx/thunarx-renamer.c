@@ -37,6 +37,7 @@
 enum
 {
   PROP_0,
+  PROP_BUSY,
   PROP_HELP_URL,
   PROP_NAME,
 };
@@ -104,8 +105,9 @@ static GList   *thunarx_renamer_real_get_menu_items  (ThunarxRenamer         *re
 
 struct _ThunarxRenamerPrivate
 {
-  gchar *help_url;
-  gchar *name;
+  gchar   *help_url;
+  gchar   *name;
+  gboolean busy;
 };
 
 
@@ -137,6 +139,24 @@ thunarx_renamer_class_init (ThunarxRenamerClass *klass)
   klass->save = thunarx_renamer_real_save;
   klass->get_menu_items = thunarx_renamer_real_get_menu_items;
 
+  /**
+   * ThunarxRenamer:busy:
+   *
+   * Whether the #ThunarxRenamer is still collecting information
+   * in the background, so thunarx_renamer_process() may not yet
+   * return the final names. The file manager does not allow to
+   * rename the files while the renamer is busy.
+   *
+   * Since: 1.8.5
+   **/
+  g_object_class_install_property (gobject_class,
+                                   PROP_BUSY,
+                                   g_param_spec_boolean ("busy",
+                                                         _("Busy"),
+                                                         _("Whether the renamer is still collecting information"),
+                                                         FALSE,
+                                                         G_PARAM_READWRITE));
+
   /**
    * ThunarxRenamer:help-url:
    *
@@ -254,6 +274,10 @@ thunarx_renamer_get_property (GObject    *object,
 
   switch (prop_id)
     {
+    case PROP_BUSY:
+      g_value_set_boolean (value, thunarx_renamer_get_busy (renamer));
+      break;
+
     case PROP_HELP_URL:
       g_value_set_string (value, thunarx_renamer_get_help_url (renamer));
       break;
@@ -280,6 +304,10 @@ thunarx_renamer_set_property (GObject      *object,
 
   switch (prop_id)
     {
+    case PROP_BUSY:
+      thunarx_renamer_set_busy (renamer, g_value_get_boolean (value));
+      break;
+
     case PROP_HELP_URL:
       thunarx_renamer_set_help_url (renamer, g_value_get_string (value));
       break;
@@ -416,6 +444,58 @@ thunarx_renamer_real_get_menu_items (ThunarxRenamer *renamer,
 
 
 
+/**
+ * thunarx_renamer_get_busy:
+ * @renamer : a #ThunarxRenamer.
+ *
+ * Returns %TRUE if @renamer is still collecting information
+ * in the background. See thunarx_renamer_set_busy().
+ *
+ * Return value: %TRUE if @renamer is busy.
+ *
+ * Since: 1.8.5
+ **/
+gboolean
+thunarx_renamer_get_busy (ThunarxRenamer *renamer)
+{
+  g_return_val_if_fail (THUNARX_IS_RENAMER (renamer), FALSE);
+  return renamer->priv->busy;
+}
+
+
+
+/**
+ * thunarx_renamer_set_busy:
+ * @renamer : a #ThunarxRenamer.
+ * @busy    : %TRUE while thunarx_renamer_process() may not
+ *            return the final names yet.
+ *
+ * Derived classes, which look up information in the background,
+ * should set @renamer busy until all results arrived, and then
+ * emit thunarx_renamer_changed() to update the preview. The file
+ * manager does not allow to rename the files while @renamer is busy.
+ *
+ * Since: 1.8.5
+ **/
+void
+thunarx_renamer_set_busy (ThunarxRenamer *renamer,
+                          gboolean        busy)
+{
+  g_return_if_fail (THUNARX_IS_RENAMER (renamer));
+
+  /* check if we have a new value */
+  if (renamer->priv->busy == !!busy)
+    return;
+
+  /* apply the new value */
+  renamer->priv->busy = !!busy;
+
+  /* notify listeners */
+  g_object_notify (G_OBJECT (renamer), "busy");
+}
+
+
+
 /**
  * thunarx_renamer_get_help_url:
  * @renamer : a #ThunarxRenamer.
@@ -106,6 +106,10 @@ struct _ThunarxRenamer
 
 GType        thunarx_renamer_get_type       (void) G_GNUC_CONST;
 
+gboolean     thunarx_renamer_get_busy       (ThunarxRenamer   *renamer);
+void         thunarx_renamer_set_busy       (ThunarxRenamer   *renamer,
+                                             gboolean          busy);
+
 const gchar *thunarx_renamer_get_help_url   (ThunarxRenamer   *renamer);
 void         thunarx_renamer_set_help_url   (ThunarxRenamer   *renamer,
                                              const gchar      *help_url);